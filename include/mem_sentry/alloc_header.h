@@ -1,11 +1,25 @@
 #pragma once 
 #include <cstdint>
 
-namespace MEM_SENTRY::heap {
-    class Heap;
-}
-
 namespace MEM_SENTRY::alloc_header {
+
+    /**
+     * @enum AllocFlags
+     * @brief Bits of AllocHeader::m_Flags.
+     */
+    enum AllocFlags : uint8_t {
+        /// @brief Block is a guard page mapping, data against the guard (guard::GuardMode::Right).
+        ALLOC_FLAG_GUARD_RIGHT = 1 << 0,
+
+        /// @brief Block is a guard page mapping, guard below the header (guard::GuardMode::Left).
+        ALLOC_FLAG_GUARD_LEFT = 1 << 1,
+
+        /// @brief Block is a slot of an object pool (see pool.h), released back to it.
+        ALLOC_FLAG_POOLED = 1 << 3,
+
+        /// @brief Both guard bits; the masked value equals the guard::GuardMode used.
+        ALLOC_FLAG_GUARD_MASK = ALLOC_FLAG_GUARD_RIGHT | ALLOC_FLAG_GUARD_LEFT
+    };
     /**
      * @struct AllocHeader
      * @brief Metadata header attached to every allocation.
@@ -15,17 +29,18 @@ namespace MEM_SENTRY::alloc_header {
      * required to correctly free aligned memory.
      *
      * @note Memory Layout:
-     * - Pointers (32 bytes): p_Heap, p_Next, p_Prev, p_OriginalAddress
-     * - Integers (13 bytes): m_Size(4), m_Signature(4), m_AllocId(4), m_Alignment(1)
-     * - Padding  (3 bytes):  To align struct to 8-byte boundary.
-     * - Total Size: 48 Bytes.
+     * - Pointers (24 bytes): p_Next, p_Prev, p_OriginalAddress
+     * - Integers (16 bytes): m_Size(4), m_Signature(4), m_AllocId(4), m_HeapId(2), m_Alignment(1), m_Flags(1)
+     * - Canary (6 bytes):    m_CanarySeed(4), m_CanarySize(1), m_ScrubReported(1)
+     * - Tags (8 bytes):      m_ContextId(2), m_SiteId(4), m_ThreadIndex(2)
+     * - Lifetime (8 bytes):  m_Timestamp(8)
+     * - Reserved (2 bytes):  Keeps the size a multiple of 16 so user data stays
+     *   aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__ (and m_Timestamp 8-byte aligned).
+     * - Total Size: 64 Bytes.
      */
     struct AllocHeader {
         // --- Pointers (8 bytes each) ---
 
-        /// @brief Pointer to the heap that tracks this allocation.
-        MEM_SENTRY::heap::Heap* p_Heap;
-
         /// @brief Pointer to the next allocation in the linked list.
         AllocHeader* p_Next;
 
@@ -48,9 +63,43 @@ namespace MEM_SENTRY::alloc_header {
         /// @brief Unique allocation ID for tracking/reporting.
         uint32_t m_AllocId;
 
+        /// @brief Registry id of the heap that tracks this allocation.
+        /// Resolve the heap with `registry::HeapOf()`; the id outlives the heap
+        /// so the header stays valid when its heap is destroyed first.
+        uint16_t m_HeapId;
+
         /// @brief Alignment used for this allocation.
         uint8_t m_Alignment;
 
-        // 3 bytes of implicit padding here on 64-bit systems
+        /// @brief AllocFlags bits describing how the block was obtained.
+        uint8_t m_Flags;
+
+        /// @brief Random value of this allocation's canaries (see canary::Write()).
+        uint32_t m_CanarySeed;
+
+        /// @brief Bytes of the front canary (below the header) and of the back canary
+        /// (after the user data). 0 for guarded blocks.
+        uint8_t m_CanarySize;
+
+        /// @brief Non-zero once the scrubber reported this block's corruption. Only
+        /// touched under the heap lock; kept out of m_Flags, which owners read without it.
+        uint8_t m_ScrubReported;
+
+        /// @brief Allocation context current when the block was allocated (see context.h), 0 if none.
+        uint16_t m_ContextId;
+
+        /// @brief Call site of a tagged allocation (see sites.h, MS_NEW), 0 if untagged.
+        uint32_t m_SiteId;
+
+        /// @brief Index of the thread that allocated the block (see threads.h).
+        uint16_t m_ThreadIndex;
+
+        /// @brief Unused, see the memory layout note.
+        uint8_t m_Reserved2[2];
+
+        /// @brief lifetime::Now() at allocation when the heap profiles lifetimes, 0 otherwise.
+        uint64_t m_Timestamp;
     };
+
+    static_assert(sizeof(AllocHeader) % 16 == 0, "AllocHeader must keep user data 16-byte aligned");
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::canary {
+
+    /**
+     * @enum Status
+     * @brief Result of validating a live allocation.
+     */
+    enum class Status : uint8_t {
+        Ok,
+        BadSignature,
+        FrontCanary,
+        BackCanary,
+        GuardSlack
+    };
+
+    /**
+     * @brief Printable description of a status.
+     */
+    const char* StatusName(Status status) noexcept;
+
+    /**
+     * @brief Sets the size of the front and back canaries of new allocations.
+     *
+     * Rounded up to a multiple of 16 bytes (the front canary sits below the header,
+     * which must keep user data 16-byte aligned) and capped at `CANARY_MAX_SIZE`.
+     * Existing allocations keep the size they were created with (stored in their header).
+     */
+    void SetCanarySize(size_t bytes) noexcept;
+
+    size_t GetCanarySize() noexcept;
+
+    /**
+     * @brief Returns a fresh random, non-zero 32-bit canary value (per-thread generator).
+     */
+    uint32_t NextSeed() noexcept;
+
+    /**
+     * @brief Writes the front and back canaries of an allocation.
+     * `m_CanarySeed`, `m_CanarySize` and `m_Size` must already be set in the header.
+     * Layout: [front canary][header][data][back canary]
+     */
+    void Write(alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Validates the signature and canaries (or guard slack) of an allocation.
+     */
+    Status Check(const alloc_header::AllocHeader* header) noexcept;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace MEM_SENTRY::census {
+
+    /**
+     * @struct TypeEntry
+     * @brief Live instances of one ISentry class, whatever heaps they are on.
+     */
+    struct TypeEntry {
+        /// @brief Demangled class name (static storage).
+        const char* m_Name;
+
+        /// @brief Number of live instances (an array counts each of its elements).
+        uint64_t m_Live;
+
+        /// @brief User bytes of the live allocations.
+        uint64_t m_Bytes;
+
+        /// @brief Highest value m_Bytes has reached.
+        uint64_t m_PeakBytes;
+    };
+
+    /**
+     * @brief Registers a class in the census (once per class, see ISentryLite<T>).
+     *
+     * The name is demangled here, so allocations only carry the returned id. Past
+     * `CENSUS_MAX_TYPES` classes, new ones share the "(other types)" entry.
+     *
+     * @param mangledName `typeid(T).name()`.
+     * @return uint32_t Dense type id.
+     */
+    uint32_t RegisterType(const char* mangledName);
+
+    /**
+     * @brief Counts a new tracked block of a type. O(1), lock-free.
+     * @param typeId Id from RegisterType().
+     * @param block User data of the block (its header holds the size).
+     * @param instances Objects in the block (the element count of an array).
+     */
+    void OnAlloc(uint32_t typeId, const void* block, uint64_t instances = 1) noexcept;
+
+    /**
+     * @brief Uncounts a tracked block of a type, before it is freed.
+     * @param instances Same count as the block's OnAlloc().
+     */
+    void OnFree(uint32_t typeId, const void* block, uint64_t instances = 1) noexcept;
+
+    /**
+     * @class TypeCensus
+     * @brief Copy of the census counters, sorted by live bytes (largest first).
+     *
+     * Taking one reads each counter once, without any lock or list walk: entries
+     * are consistent per counter, not across types.
+     */
+    class TypeCensus {
+    private:
+        std::vector<TypeEntry> m_Entries;
+
+        uint64_t m_TotalLive;
+
+        uint64_t m_TotalBytes;
+
+    public:
+        TypeCensus();
+
+        /**
+         * @brief Takes the current census. Types that never had a live instance are skipped.
+         */
+        static TypeCensus Take();
+
+        const std::vector<TypeEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        uint64_t GetTotalLive() const noexcept { return m_TotalLive; }
+
+        uint64_t GetTotalBytes() const noexcept { return m_TotalBytes; }
+
+        /**
+         * @brief Finds the entry of a class by its demangled name, nullptr if absent.
+         */
+        const TypeEntry* Find(const char* name) const noexcept;
+
+        /**
+         * @brief Prints the census as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <new>
 
 namespace MEM_SENTRY::constants {
     /// @brief signature value for valid active memory
@@ -8,9 +10,23 @@ namespace MEM_SENTRY::constants {
     /// Used to detect Double Free errors.
     constexpr int MEMSYSTEM_FREED_SIGNATURE = 0xFEDC0DE;
 
-    /// @brief endmarker to make sure we don't free beyond the array.
+    /// @brief legacy fixed endmarker, replaced by per-allocation canaries (see canary.h).
     constexpr int MEMSYSTEM_ENDMARKER = 0XEEDC0DE;
 
+    /// @brief signature of a cursor node parked inside a heap list by an incremental walk.
+    /// Cursors are not allocations and are skipped by every list traversal.
+    constexpr int MEMSYSTEM_CURSOR_SIGNATURE = 0xC0C0C0DE;
+
+    /// @brief signature of an untracked block handed out by the malloc interposer
+    /// (MemSentry's own memory). Only the signature and original address are set.
+    constexpr int MEMSYSTEM_RAW_SIGNATURE = 0xBADC0DE;
+
+    /// @brief max nodes visited per lock acquisition while taking a heap snapshot.
+    constexpr size_t SNAPSHOT_CHUNK_SIZE = 256;
+
+    /// @brief number of log2 size classes in a snapshot (sizes up to 2^32).
+    constexpr size_t SNAPSHOT_SIZE_CLASSES = 33;
+
 
 
     /*------------- MEM SENTRY CONFIG -----------------*/
@@ -26,5 +42,95 @@ namespace MEM_SENTRY::constants {
     #endif
 
     constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+
+    /// @brief max heaps alive at once (plus dead heaps whose allocations are still orphaned).
+    constexpr size_t MAX_HEAPS = 4096;
+
+    /// @brief max threads that can be inside an epoch guard with their own slot.
+    /// Extra threads still work but postpone reclamation while they read.
+    constexpr size_t MAX_EPOCH_READERS = 128;
+
+    /// @brief default size of the OpenMetrics output buffer (~300 heaps).
+    constexpr size_t METRICS_BUFFER_SIZE = 64 * 1024;
+
+    /// @brief default number of samples kept by the stats sampler ring.
+    constexpr size_t SAMPLER_RING_SIZE = 16 * 1024;
+
+    /// @brief fill byte of the few bytes between the user data and the guard page (right mode).
+    constexpr unsigned char GUARD_SLACK_BYTE = 0xFD;
+
+    /// @brief address space kept PROT_NONE by freed guarded blocks before they can be reused.
+    constexpr size_t GUARD_QUARANTINE_BYTES = 32 * 1024 * 1024;
+
+    /// @brief guarded blocks up to this many pages are cached for reuse instead of unmapped.
+    constexpr size_t GUARD_REUSE_MAX_PAGES = 16;
+
+    /// @brief max cached blocks per page count.
+    constexpr size_t GUARD_REUSE_PER_SIZE = 64;
+
+    /// @brief largest alignment of a guarded block: guard::Free() recomputes the mapping
+    /// from AllocHeader::m_Alignment, which has 8 bits. Larger ones get a regular block.
+    constexpr size_t GUARD_MAX_ALIGNMENT = 128;
+
+    /// @brief default size in bytes of the front and back canaries of every allocation.
+    constexpr size_t CANARY_DEFAULT_SIZE = 16;
+
+    /// @brief max canary size (the size is stored in one header byte).
+    constexpr size_t CANARY_MAX_SIZE = 64;
+
+    /// @brief max allocations validated per heap and per tick by the background scrubber.
+    constexpr size_t SCRUB_NODES_PER_TICK = 256;
+
+    /// @brief max corruptions printed per heap and per tick, the others wait for a later tick.
+    constexpr size_t SCRUB_REPORTS_PER_TICK = 16;
+
+    /// @brief fill byte of new user data when the allocation fill mode is on (poison::SetAllocFill()).
+    constexpr unsigned char ALLOC_FILL_BYTE = 0xCD;
+
+    /// @brief fill byte of quarantined (deleted) user data, checked before the block is freed.
+    constexpr unsigned char QUARANTINE_POISON_BYTE = 0xDD;
+
+    /// @brief default bytes of deleted user data held back per thread (0 disables the quarantine).
+    constexpr size_t QUARANTINE_THREAD_BYTES = 1024 * 1024;
+
+    /// @brief max blocks held back per thread, whatever their size.
+    constexpr size_t QUARANTINE_MAX_BLOCKS = 4096;
+
+    /// @brief min blocks verified and freed together when the quarantine is full.
+    constexpr size_t QUARANTINE_BATCH = 32;
+
+    /// @brief max object pools (see pool::Create()), each class with usePool() has one.
+    constexpr size_t POOL_MAX_POOLS = 64;
+
+    /// @brief free slots cached per thread and per pool; half a magazine moves to or
+    /// from the pool's depot at once.
+    constexpr size_t POOL_MAGAZINE_SIZE = 32;
+
+    /// @brief max slots carved from one backend allocation when a pool grows.
+    constexpr size_t POOL_CHUNK_SLOTS = 64;
+
+    /// @brief max ISentry classes with their own census entry (see census.h).
+    constexpr size_t CENSUS_MAX_TYPES = 1024;
+
+    /// @brief max distinct allocation sites tagged with MS_NEW (a power of 2, see sites.h).
+    constexpr size_t SITE_TABLE_SIZE = 4096;
+
+    /// @brief max named allocation contexts (see context.h), ids fit the 16-bit header field.
+    constexpr size_t CONTEXT_MAX_CONTEXTS = 1024;
+
+    /// @brief max threads with their own allocation counters (see threads.h); later threads share entry 0.
+    constexpr size_t THREAD_MAX_THREADS = 1024;
+
+    /// @brief nice value of the background threads (see threads::LowerPriority()).
+    constexpr int THREAD_BACKGROUND_NICE = 10;
+
+    /// @brief number of log-scale lifetime buckets of a heap's lifetime histogram (see lifetime.h).
+    constexpr size_t LIFETIME_BUCKETS = 16;
+
+    /// @brief max (site, size class) groups of suspected leaks per heap and pass (see leaks.h).
+    constexpr size_t LEAK_MAX_GROUPS = 1024;
+
+    /// @brief (time, next alloc id) marks kept per heap to age untimestamped blocks (see leaks.h).
+    constexpr size_t LEAK_AGE_MARKS = 32;
 };
 
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::context {
+
+    /**
+     * @struct ContextStats
+     * @brief Memory cost of one allocation context (a request or task type), across all heaps.
+     */
+    struct ContextStats {
+        /// @brief Name given to Register(), nullptr for an unknown id.
+        const char* m_Name;
+
+        /// @brief ContextScopes opened with this id (requests served).
+        uint64_t m_Scopes;
+
+        /// @brief Blocks allocated while the context was current.
+        uint64_t m_Allocs;
+
+        /// @brief User bytes allocated while the context was current (never decreases).
+        uint64_t m_Allocated;
+
+        /// @brief User bytes of those blocks that are still live.
+        uint64_t m_Retained;
+
+        /// @brief Highest value m_Retained has reached.
+        uint64_t m_Peak;
+    };
+
+    /**
+     * @brief Returns the id of a named context, registering it on first use.
+     * Registration takes a lock: register once and keep the id.
+     * @param name Copied.
+     * @return uint16_t The id (1 based), 0 if `CONTEXT_MAX_CONTEXTS` contexts exist.
+     */
+    uint16_t Register(const char* name);
+
+    /// @brief Context of the calling thread's innermost ContextScope, 0 outside scopes.
+    /// constinit + initial-exec: reading it is a single TLS load.
+    extern constinit thread_local __attribute__((tls_model("initial-exec"))) uint16_t tContextId;
+
+    /**
+     * @brief Context stamped into the blocks allocated by the calling thread now.
+     */
+    inline uint16_t Current() noexcept {
+        return tContextId;
+    }
+
+    /**
+     * @brief Counts a new block of the context in its header (no-op for context 0). Lock-free.
+     */
+    void OnAlloc(const alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Uncounts a block being freed, from whatever thread or context frees it.
+     */
+    void OnFree(const alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Follows a block resized from `oldSize` to its current m_Size (realloc).
+     */
+    void OnResize(const alloc_header::AllocHeader* header, uint32_t oldSize) noexcept;
+
+    /**
+     * @brief Current counters of a context. Each one is read atomically, not all of them together.
+     */
+    ContextStats GetStats(uint16_t id) noexcept;
+
+    /**
+     * @brief Prints every context as a plain-text table, highest peak first.
+     * @param out Destination stream (stdout by default).
+     */
+    void Dump(std::FILE* out = stdout);
+
+    /**
+     * @class ContextScope
+     * @brief Makes a context current on the calling thread while alive.
+     *
+     * @code
+     * static const uint16_t kSearch = MEM_SENTRY::context::Register("search");
+     * void HandleSearch(Request& request) {
+     *     MEM_SENTRY::context::ContextScope scope(kSearch);
+     *     ...
+     * }
+     * @endcode
+     *
+     * Scopes nest (each one restores the context it replaced). Blocks keep the context
+     * they were allocated in: freeing them later, anywhere, lowers its retained bytes.
+     * An id Register() can't return (past `CONTEXT_MAX_CONTEXTS`) opens no context.
+     */
+    class ContextScope {
+    private:
+        uint16_t m_Previous;
+
+    public:
+        explicit ContextScope(uint16_t id) noexcept;
+
+        ~ContextScope() {
+            tContextId = m_Previous;
+        }
+
+        ContextScope(const ContextScope&) = delete;
+        ContextScope& operator=(const ContextScope&) = delete;
+    };
+};
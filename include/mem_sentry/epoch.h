@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace MEM_SENTRY::epoch {
+
+    /**
+     * @class EpochGuard
+     * @brief RAII read-side critical section for Epoch Based Reclamation (EBR).
+     *
+     * While a guard is alive, any block published before the guard was entered
+     * and retired afterwards via `Retire()` is guaranteed not to be freed, so readers
+     * can dereference RCU-published pointers without taking a lock.
+     *
+     * Entering a guard is a TLS load, one store into a per-thread slot and a fence.
+     * Guards nest (only the outermost one publishes the epoch).
+     *
+     * @note Each thread claims one of `MAX_EPOCH_READERS` slots on first use and returns
+     * it at thread exit. Threads that can't get a slot still work correctly: while
+     * any of them is inside a guard, reclamation is simply postponed.
+     */
+    class EpochGuard {
+    public:
+        EpochGuard() noexcept;
+        ~EpochGuard() noexcept;
+
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    };
+
+    /**
+     * @brief Defers freeing a block that has just been unpublished.
+     *
+     * The block is released with `deleter` once every reader that could still
+     * observe it has left its guard. Call this only AFTER the block has been
+     * replaced in its atomic pointer.
+     *
+     * @param ptr Block to free.
+     * @param deleter Function used to free it (e.g. std::free).
+     *
+     * @note Intended for rare writers (topology changes); the retire list is
+     * guarded by a mutex.
+     */
+    void Retire(void* ptr, void (*deleter)(void*));
+
+    /**
+     * @brief Frees every retired block no reader can observe anymore.
+     * Called automatically by Retire(), exposed for tests and shutdown paths.
+     *
+     * @return size_t Number of blocks still waiting for readers.
+     */
+    size_t Reclaim();
+};
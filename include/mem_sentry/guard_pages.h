@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace MEM_SENTRY::guard {
+
+    /**
+     * @enum GuardMode
+     * @brief Where a heap places the inaccessible (PROT_NONE) page of its allocations.
+     */
+    enum class GuardMode : uint8_t {
+        /// @brief Regular malloc'ed allocations (end marker checked on delete).
+        None = 0,
+
+        /// @brief User data ends against a guard page: overflows fault immediately.
+        Right = 1,
+
+        /// @brief A guard page sits right below the header: underflows fault immediately.
+        Left = 2
+    };
+
+    /**
+     * @brief Maps a guarded block for `size` user bytes.
+     *
+     * Right mode: `[header][data][slack < 8][guard page]`. The data is aligned to
+     * the largest power of two dividing `size` (at least 8, so the header stays
+     * aligned, and at most 16) unless an explicit alignment is requested, so a
+     * one byte overflow of most objects hits the guard page. The few slack bytes
+     * are filled with `GUARD_SLACK_BYTE` and checked by Free().
+     *
+     * Left mode: `[guard page][header][data][unused]`. An underflow first runs
+     * over the header (caught by the signature check on delete), then faults.
+     *
+     * Freed blocks stay PROT_NONE in a quarantine (so use-after-free faults too)
+     * before their pages are reused by later guarded allocations.
+     *
+     * @param size User bytes.
+     * @param alignment Requested alignment, 0 for the default one, at most `GUARD_MAX_ALIGNMENT`.
+     * @param mode Right or Left.
+     * @param base Receives the start of the mapping (store it in p_OriginalAddress).
+     * @return void* The user data, nullptr if mapping failed.
+     */
+    void* Allocate(size_t size, size_t alignment, GuardMode mode, void** base);
+
+    /**
+     * @brief Verifies the slack bytes of a Right mode block.
+     * @return false if the user wrote past its data (below the guard page granularity).
+     */
+    bool CheckSlack(const void* data, size_t size, GuardMode mode);
+
+    /**
+     * @brief Protects the whole block and sends it to the quarantine.
+     * The mapping has the same length in both modes, so only the layout inputs are needed.
+     * @param base p_OriginalAddress of the block.
+     * @param size User bytes, as passed to Allocate().
+     * @param alignment Alignment, as passed to Allocate().
+     */
+    void Free(void* base, size_t size, size_t alignment);
+
+    /**
+     * @brief Bytes of address space currently held by the quarantine and the reuse cache.
+     */
+    size_t CachedBytes() noexcept;
+
+    /**
+     * @brief Unmaps every quarantined and cached block.
+     */
+    void Trim();
+};
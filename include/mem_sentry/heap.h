@@ -3,14 +3,37 @@
 #include <cstring>
 #include <atomic>
 #include <mutex>
-#include <vector>
-#include <functional>
-#include <unordered_set>
 
 #include "mem_sentry/alloc_header.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/guard_pages.h"
+#include "mem_sentry/lifetime.h"
 #include "mem_sentry/reporter.h"
+#include "mem_sentry/snapshot.h"
+#include "mem_sentry/sites.h"
+#include "mem_sentry/registry.h"
 
 namespace MEM_SENTRY::heap {       
+
+    class Heap;
+
+    /**
+     * @struct HeapList
+     * @brief Immutable, flat list of heaps published through an atomic pointer (RCU).
+     *
+     * Used for the adjacency lists and for the closure of heaps reachable from a heap.
+     * Writers never modify a published list: they build a new one, swap the pointer
+     * and retire the old one through epoch::Retire(), so readers traverse the graph
+     * inside an epoch::EpochGuard without any lock.
+     * Allocated with malloc so it never shows up in the stats it is used to compute.
+     */
+    struct HeapList {
+        /** @brief Number of entries in m_Heaps. */
+        size_t m_Count;
+
+        /** @brief The heaps (flexible array, m_Count entries). */
+        Heap* m_Heaps[1];
+    };
     
     /**
      * @class Heap
@@ -23,15 +46,36 @@ namespace MEM_SENTRY::heap {
      */
     class Heap {
     private:
-        /** @brief Name of the heap (e.g., "Physics", "AI"). */
-        char m_name[100];
+        /** @brief Interned name of the heap (e.g., "Physics", "AI"). */
+        const char* m_name;
 
         /** @brief Total bytes currently allocated in this heap. */
-        int m_total;
+        std::atomic<int> m_total;
+
+        /** @brief Number of allocations currently tracked by this heap. */
+        std::atomic<int> m_count;
+
+        /** @brief Monotonic number of allocations ever added to this heap. */
+        std::atomic<uint64_t> m_AllocCount;
+
+        /** @brief Monotonic number of allocations ever removed from this heap. */
+        std::atomic<uint64_t> m_FreeCount;
         
         /** @brief Counter to generate unique IDs for allocations. */
         std::atomic<int> m_NextAllocId;
 
+        /** @brief Dense registry id stored in every allocation header of this heap. */
+        uint16_t m_Id;
+
+        /** @brief Guard page placement for new allocations (None: regular malloc). */
+        std::atomic<guard::GuardMode> m_GuardMode;
+
+        /** @brief Whether new allocations are timestamped for the lifetime histogram. */
+        std::atomic<bool> m_LifetimeProfile;
+
+        /** @brief Lifetime histogram, created by the first SetLifetimeProfile(true). */
+        std::atomic<lifetime::Histogram*> p_Lifetime;
+
         /** @brief Pointer to the first allocation in the tracking list. */
         alloc_header::AllocHeader* p_HeadList;
 
@@ -44,11 +88,36 @@ namespace MEM_SENTRY::heap {
          */
         reporter::IReporter* p_Reporter;
 
+        /** @brief Cursor node parked in the list between two ScrubStep() calls. */
+        alloc_header::AllocHeader m_ScrubCursor;
+
+        /** @brief True while m_ScrubCursor is linked in the list. */
+        bool m_ScrubParked;
+
+        /**
+         * @brief Published adjacency list storing pointers to connected neighbor heaps.
+         * nullptr means no neighbors. Read inside an epoch::EpochGuard.
+         */
+        std::atomic<HeapList*> m_AdjHeaps;
+
+        /**
+         * @brief Reverse adjacency list (heaps that have this heap as a neighbor).
+         * @note Only used by writers to find the closures invalidated by a topology change.
+         * Guarded by m_graphMutex.
+         */
+        HeapList* p_InHeaps;
+
+        /**
+         * @brief Published closure of heaps reachable from this one.
+         * nullptr means the heap only reaches itself. Read inside an epoch::EpochGuard.
+         */
+        std::atomic<HeapList*> p_Reach;
+
         /**
-         * @brief Adjacency list storing pointers to connected neighbor heaps.
-         * @note Used for graph traversal operations like GetTotalHH().
+         * @brief Traversal mark used by writers instead of a visited set.
+         * @note Guarded by m_graphMutex.
          */
-        std::vector<Heap*> m_AdjHeaps;
+        uint64_t m_VisitMark;
 
         /**
          * @brief linked list mutex.
@@ -58,11 +127,17 @@ namespace MEM_SENTRY::heap {
         std::mutex m_llMutex;
         
         /**
-         * @brief GLOBAL lock for the Heap Hierarchy.
-         * Locks ALL heaps to prevent neighbor race conditions.
+         * @brief GLOBAL lock for Heap Hierarchy writers.
+         * Serializes topology changes only; hierarchy queries never take it.
          */
         static std::mutex m_graphMutex;
 
+        /**
+         * @brief Generation counter backing m_VisitMark.
+         * @note Guarded by m_graphMutex.
+         */
+        static uint64_t m_VisitEpoch;
+
         /**
          * @brief Internal helper to append a node to the linked list.
          * @param alloc Pointer to the new header to add.
@@ -79,32 +154,115 @@ namespace MEM_SENTRY::heap {
         bool removeAllocLL(alloc_header::AllocHeader* alloc);
 
         /**
-         * @brief Helper function to perform Depth First Search (DFS) on the heap graph.
-         * Traverses connected heaps recursively, maintaining a visited set to handle 
-         * cycles in the graph (which occur naturally due to bidirectional connections).
-         * 
-         * @param heap The current heap node being visited.
-         * @param visited Set of already visited heaps to prevent infinite loops.
-         * @param val Reference to the accumulator value (size or count).
-         * @param func The operation to perform on each visited heap (e.g., add size to val).
+         * @brief Internal helper to link a node right before another node.
+         * Used to park walk cursors inside the list.
+         * @param alloc Pointer to the header to insert.
+         * @param before Node to insert in front of, nullptr appends at the tail.
+         */
+        void insertBeforeLL(alloc_header::AllocHeader* alloc, alloc_header::AllocHeader* before);
+
+        /**
+         * @brief Visits the allocations older than `stopId` in chunks of `chunkSize` nodes,
+         * releasing the heap lock between chunks (a cursor node keeps the position).
+         * Blocks adopted from a destroyed heap are always visited: their ids come from
+         * that heap's sequence, but they predate the walk.
+         * @param visit Called under the heap lock; it must not allocate on or free from this heap.
+         * @param chunkSize Nodes visited per lock hold (at least 1).
+         */
+        void walkChunked(uint32_t stopId, void (*visit)(const alloc_header::AllocHeader*, void*), void* context,
+            size_t chunkSize = constants::SNAPSHOT_CHUNK_SIZE);
+
+        /**
+         * @brief Collects every heap reachable from `start` with a Breadth First Search.
+         * The output array doubles as the BFS queue, cycles are cut with m_VisitMark.
+         *
+         * @param start Heap to start from (always the first entry).
+         * @param forward Follow m_AdjHeaps if true, m_InHeaps (reverse edges) otherwise.
+         * @param count [out] number of heaps collected.
+         * @return Heap** malloc'ed array (caller frees), nullptr on failure.
+         *
+         * @note Caller must hold m_graphMutex.
+         */
+        static Heap** collectReachable(Heap* start, bool forward, size_t& count);
+
+        /**
+         * @brief Rebuilds and publishes the closure of `heap`, retiring the previous one.
+         * @note Caller must hold m_graphMutex.
          */
-        void dfs(Heap* heap, std::unordered_set<Heap*>& visited, size_t& val,
-                 const std::function<void(Heap*, size_t&)>& func);
+        static void rebuildReach(Heap* heap);
+
+        /**
+         * @brief Builds a copy of `list` with `heap` appended.
+         * @return HeapList* New malloc'ed list, nullptr on failure.
+         */
+        static HeapList* appendList(const HeapList* list, Heap* heap);
+
+        /**
+         * @brief Builds a copy of `list` without any occurrence of `heap`.
+         * @param result [out] New malloc'ed list, nullptr if nothing is left.
+         * @return false on allocation failure.
+         */
+        static bool removeFromList(const HeapList* list, Heap* heap, HeapList*& result);
+
+        /**
+         * @brief Removes every edge to and from this heap and rebuilds the affected closures.
+         * @note Caller must hold m_graphMutex.
+         */
+        void detachFromGraph();
+
+        /**
+         * @brief Moves every live allocation to the orphan heap by splicing the list.
+         * The registry id is redirected, so the headers don't need to be touched.
+         */
+        void orphanAllocations();
     public:
         /**
          * @brief Construct a new Heap object.
          * @param name The display name for this memory category.
          */
         Heap(const char *name) {
-            std::strncpy(m_name, name, 99);
-            m_name[99] = '\0';
+            m_name = registry::InternName(name);
             m_total = 0;
+            m_count = 0;
+            m_AllocCount = 0;
+            m_FreeCount = 0;
             m_NextAllocId = 1;
+            m_GuardMode = guard::GuardMode::None;
+            m_LifetimeProfile = false;
+            p_Lifetime = nullptr;
 
             p_HeadList = nullptr;
             p_TailList = nullptr;
             p_Reporter = nullptr;
+            m_Id = registry::Acquire(this);
+            m_AdjHeaps = nullptr;
+            p_InHeaps = nullptr;
+            p_Reach = nullptr;
+            m_VisitMark = 0;
+
+            m_ScrubCursor = {};
+            m_ScrubCursor.m_HeapId = m_Id;
+            m_ScrubCursor.m_Signature = constants::MEMSYSTEM_CURSOR_SIGNATURE;
+            m_ScrubParked = false;
         }
+
+        /**
+         * @brief Unregisters the heap.
+         *
+         * - Every edge to and from this heap is removed and the closures of the heaps
+         *   that reached it are rebuilt.
+         * - The heap disappears from registry::ForEachHeap().
+         * - Live allocations are spliced onto the orphan heap in O(1) and the registry
+         *   id is redirected to it, so later `delete`s on those blocks stay correct.
+         *
+         * @warning The heap must not be destroyed while other threads are still
+         * allocating from it or freeing its blocks; frees issued after the destructor
+         * returned are fine.
+         */
+        ~Heap();
+
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
         
         /**
          * @brief Assigns a reporter instance to this heap for memory event logging.
@@ -123,11 +281,68 @@ namespace MEM_SENTRY::heap {
             p_Reporter = reporter;
         }
 
+        /**
+         * @brief Places every new allocation of this heap against a PROT_NONE guard page.
+         *
+         * Overflows (Right) or underflows (Left) then fault on the faulty access instead
+         * of being found by the end marker check on delete. Existing allocations keep
+         * their layout; switching back to None only affects later allocations.
+         *
+         * @warning Each allocation costs at least two pages of address space and two
+         * memory mappings, so use it for the heaps under investigation only.
+         */
+        void SetGuardMode(guard::GuardMode mode) noexcept {
+            m_GuardMode.store(mode, std::memory_order_relaxed);
+        }
+
+        guard::GuardMode GetGuardMode() const noexcept {
+            return m_GuardMode.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Starts (or stops) timestamping the new allocations of this heap.
+         *
+         * When a timestamped block is freed, its lifetime is counted in a per-heap
+         * histogram by size class and log-scale lifetime bucket, lock-free.
+         * Blocks allocated while the profile is off are not counted. Stopping keeps
+         * the histogram (and still counts the timestamped blocks still live).
+         *
+         * @return false if the histogram could not be allocated.
+         */
+        bool SetLifetimeProfile(bool enabled);
+
+        bool ProfilesLifetimes() const noexcept {
+            return m_LifetimeProfile.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Counts the lifetime of a timestamped block being freed.
+         * @param now lifetime::Now() at the free.
+         */
+        void RecordLifetime(const alloc_header::AllocHeader* alloc, uint64_t now) noexcept {
+            lifetime::Histogram* histogram = p_Lifetime.load(std::memory_order_acquire);
+            if (histogram) {
+                histogram->Record(alloc->m_Size, now - alloc->m_Timestamp);
+            }
+        }
+
+        /**
+         * @brief Copies the lifetime histogram: bytes freed by lifetime bucket and size class.
+         * @return lifetime::LifetimeReport Empty if the profile was never started.
+         */
+        lifetime::LifetimeReport GetLifetimeReport() const;
+
         /**
          * @brief Get the name of this heap.
          * @return const char* The name string.
          */
         const char * GetName() const noexcept { return m_name; }
+
+        /**
+         * @brief Get the dense registry id stored in the headers of this heap's allocations.
+         * @note Stable for the heap's lifetime; `registry::Find(id)` maps it back in O(1).
+         */
+        uint16_t GetId() const noexcept { return m_Id; }
         
         /**
          * @brief return a unique Id for a new allocation and increments the counter.
@@ -140,12 +355,24 @@ namespace MEM_SENTRY::heap {
         /**
          * @brief Returns the current total bytes allocated on this heap.
          */
-        int GetTotal() const noexcept { return m_total; }
+        int GetTotal() const noexcept { return m_total.load(std::memory_order_relaxed); }
 
         /**
          * @brief Count active allocations tracked by this heap.
+         * @note O(1), reads a counter maintained by AddAllocation/RemoveAlloc.
+         */
+        int CountAllocations() noexcept { return m_count.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Number of allocations ever added to this heap (never decreases).
+         * @note Differences between two reads give the allocation rate.
+         */
+        uint64_t GetAllocCount() const noexcept { return m_AllocCount.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Number of allocations ever removed from this heap (never decreases).
          */
-        int CountAllocations() noexcept;
+        uint64_t GetFreeCount() const noexcept { return m_FreeCount.load(std::memory_order_relaxed); }
 
         /**
          * @brief Registers a new allocation with this heap.
@@ -163,6 +390,30 @@ namespace MEM_SENTRY::heap {
          */
         void RemoveAlloc(alloc_header::AllocHeader* alloc);
 
+        /**
+         * @brief Changes the user size of a tracked allocation in place.
+         *
+         * @param alloc Header of the allocation (it stays where it is in the list).
+         * @param newSize New user size.
+         * @param onResized Optional, called under the heap lock right after m_Size is
+         * updated (e.g. to move the back canary), so list walkers never see a half
+         * resized block.
+         */
+        void ResizeAlloc(alloc_header::AllocHeader* alloc, uint32_t newSize,
+                         void (*onResized)(alloc_header::AllocHeader*) = nullptr);
+
+        /**
+         * @brief Replaces a tracked allocation by its moved copy.
+         *
+         * `moved` takes the exact list position of `alloc` (a single O(1) relink, the
+         * block never leaves the list), and the heap totals follow the size change.
+         * The alloc id and heap id are the caller's to copy, so they stay stable.
+         *
+         * @param alloc Header currently linked in this heap.
+         * @param moved Header of the new block, not linked anywhere.
+         */
+        void RelinkAlloc(alloc_header::AllocHeader* alloc, alloc_header::AllocHeader* moved);
+
         /**
          * @brief Prints all active allocations between two IDs.
          * Used to detect leaks or inspect memory usage between two points in time.
@@ -172,17 +423,88 @@ namespace MEM_SENTRY::heap {
          */
         void ReportMemory(int bookMark1, int bookMark2);
 
+        /**
+         * @brief Takes a compact snapshot of the live allocations grouped by size class.
+         *
+         * The list is walked with walkChunked(), like SummarizeSites() and the leak
+         * detector: chunks of `SNAPSHOT_CHUNK_SIZE` nodes are added to the size class
+         * totals under the heap lock, which is released between chunks. A cursor node
+         * parked in the list keeps the position, so allocating threads are only blocked
+         * for one chunk.
+         *
+         * Allocations made after the snapshot started are skipped, including the
+         * snapshot's own result storage when snapshotting the DefaultHeap. Blocks adopted
+         * from a destroyed heap are always counted.
+         *
+         * @return snapshot::HeapSnapshot Sorted per size class totals.
+         */
+        snapshot::HeapSnapshot Snapshot();
+
+        /**
+         * @brief Groups the live allocations between two IDs by call site (see MS_NEW).
+         *
+         * The list is walked in chunks like Snapshot(), so allocating threads are only
+         * blocked for one chunk at a time. Untagged allocations share site 0. Blocks
+         * adopted from a destroyed heap are matched against the ids of their old heap.
+         *
+         * @param bookMark1 The starting Allocation ID (inclusive).
+         * @param bookMark2 The ending Allocation ID (inclusive).
+         * @return sites::SiteSummary Per site totals, largest first.
+         */
+        sites::SiteSummary SummarizeSites(int bookMark1 = 0, int bookMark2 = INT32_MAX);
+
+        /**
+         * @brief Visits the live allocations older than `stopId`, walking the list in chunks
+         * like Snapshot(), so allocating threads are only blocked for one chunk at a time.
+         * @param visit Called under the heap lock; it must not allocate on or free from this heap.
+         * @param chunkSize Nodes visited per lock hold, bounds how long an allocating thread can wait.
+         */
+        void ForEachAllocation(uint32_t stopId, void (*visit)(const alloc_header::AllocHeader*, void*), void* context,
+            size_t chunkSize = constants::SNAPSHOT_CHUNK_SIZE) {
+            walkChunked(stopId, visit, context, chunkSize);
+        }
+
+        /**
+         * @brief Id the next allocation of this heap will get. Unlike GetNextId(), doesn't consume it.
+         */
+        uint32_t PeekNextId() const noexcept {
+            return (uint32_t)m_NextAllocId.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Visits the next `maxNodes` allocations of the list, resuming where the
+         * previous call stopped (a cursor node stays parked in the list in between).
+         *
+         * Used by the background scrubber to validate live allocations incrementally:
+         * the heap lock is held for at most `maxNodes` visits per call.
+         *
+         * @param visit Called under the heap lock for every allocation; it must not
+         * allocate on or free from this heap.
+         * @return true when the end of the list was reached (the next call starts over).
+         */
+        bool ScrubStep(size_t maxNodes, void (*visit)(alloc_header::AllocHeader*, void*), void* context);
+
         /**
          * @brief Reserves memory for the adjacency list of connected heaps.
-         * Use this if you know ahead of time how many heaps will be connected 
-         * to this one to avoid reallocations.
          * 
          * @param size The number of heaps to reserve space for.
+         * 
+         * @note No-op since the adjacency list became an immutable published snapshot
+         * sized exactly on every change. Kept for source compatibility.
          */
         void allocateAdjList(size_t size) {
-            m_AdjHeaps.reserve(size);
+            (void)size;
         }
 
+        /**
+         * @brief Copies the current neighbors of this heap without taking any lock.
+         * 
+         * @param out Destination array.
+         * @param capacity Number of entries `out` can hold.
+         * @return size_t Total number of neighbors (may exceed capacity).
+         */
+        size_t GetAdjacentHeaps(Heap** out, size_t capacity) const;
+
         /**
          * @brief Adds a one-way connection from this heap to another target heap.
          * This adds the target heap to this heap's adjacency list. 
@@ -190,44 +512,32 @@ namespace MEM_SENTRY::heap {
          * 
          * @param heap Pointer to the target heap to connect.
          * 
+         * Rebuilds the published closure of every heap that can reach this one.
+         * 
          * @warning [THREAD WARNING] This function acquires a GLOBAL STATIC LOCK on the heap topology.
-         * It will block ALL other threads trying to modify heap connections or query hierarchy stats
-         * until it completes. It does NOT block standard Alloc/Dealloc on other heaps.
+         * It will block ALL other threads trying to modify heap connections until it completes.
+         * It does NOT block hierarchy queries or standard Alloc/Dealloc: readers keep using
+         * the previous published lists until the new ones are swapped in.
          */
         void AddHeap(Heap* heap);
 
         /**
          * @brief Calculates the total memory usage for hierarchical heaps.
-         * This performs a graph traversal (DFS) to sum the total memory size 
-         * of the entire connected component (Cluster) of heaps.
+         * Sums the totals of every heap reachable from this one (Cluster), using the
+         * closure published at the last topology change.
          * 
          * @return size_t Total bytes allocated across the heap graph.
          * 
-         * @warning [THREAD WARNING] This function acquires a GLOBAL STATIC LOCK on the heap topology.
-         * It will block ALL other threads trying to modify heap connections or query hierarchy stats
-         * until it completes. It does NOT block standard Alloc/Dealloc on other heaps.
-         * 
-         * @warning [PERF WARNING] This uses std::unordered_set for traversal, which triggers
-         * dynamic memory allocations on the Default Heap. 
-         * DO NOT use this in high-performance loops (e.g., Game Update) or memory stress tests.
-         * Intended for Debugging/Snapshots only.
+         * @note O(reachable heaps), lock free and allocation free (runs inside an epoch::EpochGuard).
          */
         size_t GetTotalHH();
 
         /**
          * @brief Counts the total number of active allocations in heap hierarchy.
-         * This performs a graph traversal (DFS) to sum the allocation count
-         * of the entire connected heaps (Hierarchy) of heaps.
+         * Sums the allocation counters of every heap reachable from this one (Hierarchy).
          * @return size_t Total count of allocations across the heap graph.
          * 
-         * @warning [THREAD WARNING] This function acquires a GLOBAL STATIC LOCK on the heap topology.
-         * It will block ALL other threads trying to modify heap connections or query hierarchy stats
-         * until it completes. It does NOT block standard Alloc/Dealloc on other heaps.
-         * 
-         * @warning [PERF WARNING] This uses std::unordered_set for traversal, which triggers
-         * dynamic memory allocations on the Default Heap. 
-         * DO NOT use this in high-performance loops (e.g., Game Update) or memory stress tests.
-         * Intended for Debugging/Snapshots only.
+         * @note O(reachable heaps), lock free and allocation free (runs inside an epoch::EpochGuard).
          */
         size_t CountAllocationsHH();
     };
@@ -243,8 +553,22 @@ namespace MEM_SENTRY::heap {
          * @return Heap* Pointer to the global default heap.
          */
         static Heap* GetDefaultHeap() {
-            static Heap defaultHeap("DefaultHeap");
-            return &defaultHeap;
+            // constructed in static storage and never destroyed, so frees issued
+            // by other static destructors at exit still find a live heap.
+            alignas(Heap) static unsigned char storage[sizeof(Heap)];
+            static Heap* defaultHeap = new (storage) Heap("DefaultHeap");
+            return defaultHeap;
+        }
+
+        /**
+         * @brief Retrieves the singleton Orphan Heap.
+         * Adopts the live allocations of every heap destroyed before they were freed.
+         * @return Heap* Pointer to the global orphan heap.
+         */
+        static Heap* GetOrphanHeap() {
+            alignas(Heap) static unsigned char storage[sizeof(Heap)];
+            static Heap* orphanHeap = new (storage) Heap("OrphanHeap");
+            return orphanHeap;
         }
 
         /**
@@ -256,8 +580,8 @@ namespace MEM_SENTRY::heap {
          * @param heap2 Pointer to the second heap.
          * 
          * @warning [THREAD WARNING] This function acquires a GLOBAL STATIC LOCK on the heap topology.
-         * It will block ALL other threads trying to modify heap connections or query hierarchy stats
-         * until it completes. It does NOT block standard Alloc/Dealloc on other heaps.
+         * It will block ALL other threads trying to modify heap connections until it completes.
+         * It does NOT block hierarchy queries or standard Alloc/Dealloc.
          */
         static void ConnectHeaps(Heap* heap1, Heap* heap2){
             if(heap1 && heap2){
@@ -266,4 +590,51 @@ namespace MEM_SENTRY::heap {
             }
         }
     };
+
+    /// @brief Heap of the calling thread's innermost HeapScope, nullptr outside scopes.
+    /// constinit + initial-exec: reading it is a single TLS load, no wrapper call.
+    extern constinit thread_local __attribute__((tls_model("initial-exec"))) Heap* tScopeHeap;
+
+    /**
+     * @brief Heap that untyped allocations (global `operator new`) go to on this thread:
+     * the innermost HeapScope's heap, or the default heap outside any scope.
+     */
+    inline Heap* CurrentHeap() {
+        Heap* heap = tScopeHeap;
+        return heap ? heap : HeapFactory::GetDefaultHeap();
+    }
+
+    /**
+     * @class HeapScope
+     * @brief Routes the global `operator new` of the current thread to a heap while alive.
+     *
+     * Attributes everything a subsystem allocates (strings, vectors, lambdas) to its heap
+     * without touching the call sites:
+     * @code
+     * void AudioSystem::Update() {
+     *     MEM_SENTRY::heap::HeapScope scope(&audioHeap);
+     *     ...
+     * }
+     * @endcode
+     *
+     * Scopes nest (each one restores the heap it replaced) and only affect the thread
+     * that opened them. Explicit `new (heap) T` and ISentry classes keep their heap.
+     * Blocks are freed to the heap they were allocated on, whatever scope is open.
+     */
+    class HeapScope {
+    private:
+        Heap* p_Previous;
+
+    public:
+        explicit HeapScope(Heap* heap) noexcept : p_Previous(tScopeHeap) {
+            tScopeHeap = heap;
+        }
+
+        ~HeapScope() {
+            tScopeHeap = p_Previous;
+        }
+
+        HeapScope(const HeapScope&) = delete;
+        HeapScope& operator=(const HeapScope&) = delete;
+    };
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+#include "mem_sentry/heap.h"
+#include "mem_sentry/mem_sentry.h"
+
+namespace MEM_SENTRY::allocator {
+
+    /**
+     * @struct DefaultHeapSource
+     * @brief Heap used by default-constructed allocators: the one global `operator new`
+     * would use on this thread (see heap::CurrentHeap()).
+     *
+     * A heap source is any type with a static `Get()` returning a `heap::Heap*`.
+     * ISentry<T>::HeapSource is the one of a tracked class.
+     */
+    struct DefaultHeapSource {
+        static heap::Heap* Get() noexcept { return heap::CurrentHeap(); }
+    };
+
+    /**
+     * @class HeapAllocator
+     * @brief Standard allocator that routes container allocations to a Heap.
+     *
+     * Without it every container allocates through the global `operator new` (the
+     * DefaultHeap, or the current HeapScope's heap), whoever owns it.
+     *
+     * @code
+     * std::vector<int, HeapAllocator<int>> samples{HeapAllocator<int>(&audioHeap)};
+     * @endcode
+     *
+     * The heap travels with the container (it propagates on copy, move and swap).
+     * Deallocation is sized, only as a debug check of the container's element count
+     * against the block (see sentry_deallocate_sized()).
+     *
+     * @tparam T Element type.
+     * @tparam HeapSource Supplies the heap of default-constructed allocators.
+     */
+    template<typename T, typename HeapSource = DefaultHeapSource>
+    class HeapAllocator {
+    private:
+        template<typename U, typename S> friend class HeapAllocator;
+
+        /// @brief true when T needs the aligned allocation path.
+        static constexpr bool OVER_ALIGNED = alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        heap::Heap* p_Heap;
+
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+        using is_always_equal = std::false_type;
+
+        template<typename U>
+        struct rebind { using other = HeapAllocator<U, HeapSource>; };
+
+        /**
+         * @brief Allocator bound to the heap of `HeapSource`.
+         */
+        HeapAllocator() noexcept : p_Heap(HeapSource::Get()) {}
+
+        /**
+         * @brief Allocator bound to an explicit heap.
+         */
+        explicit HeapAllocator(heap::Heap* heap) noexcept : p_Heap(heap) {}
+
+        template<typename U>
+        HeapAllocator(const HeapAllocator<U, HeapSource>& other) noexcept : p_Heap(other.p_Heap) {}
+
+        heap::Heap* GetHeap() const noexcept { return p_Heap; }
+
+        T* allocate(size_t count) {
+            if (count > size_t(-1) / sizeof(T)) {
+                throw std::bad_array_new_length();
+            }
+
+            if constexpr (OVER_ALIGNED) {
+                return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T)), p_Heap));
+            } else {
+                return static_cast<T*>(::operator new(count * sizeof(T), p_Heap));
+            }
+        }
+
+        void deallocate(T* ptr, size_t count) noexcept {
+            sentry_deallocate_sized(ptr, count * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const HeapAllocator<U, HeapSource>& other) const noexcept {
+            return p_Heap == other.p_Heap;
+        }
+    };
+
+    /**
+     * @class HeapResource
+     * @brief `std::pmr::memory_resource` adapter of a Heap, for pmr containers.
+     *
+     * @code
+     * HeapResource resource(&audioHeap);
+     * std::pmr::vector<int> samples(&resource);
+     * @endcode
+     */
+    class HeapResource : public std::pmr::memory_resource {
+    private:
+        heap::Heap* p_Heap;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+                return ::operator new(bytes, std::align_val_t(alignment), p_Heap);
+            }
+            return ::operator new(bytes, p_Heap);
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t) override {
+            sentry_deallocate_sized(ptr, bytes);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            const HeapResource* resource = dynamic_cast<const HeapResource*>(&other);
+            return resource && resource->p_Heap == p_Heap;
+        }
+
+    public:
+        explicit HeapResource(heap::Heap* heap) noexcept : p_Heap(heap) {}
+
+        heap::Heap* GetHeap() const noexcept { return p_Heap; }
+    };
+};
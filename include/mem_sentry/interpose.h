@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+
+namespace MEM_SENTRY::heap {
+    class Heap;
+}
+
+namespace MEM_SENTRY::interpose {
+
+    /**
+     * @class BypassScope
+     * @brief Marks the calling thread as being inside MemSentry for the lifetime of the scope.
+     *
+     * When the `memsentry_preload` library interposes malloc, allocations made while a
+     * scope is open go straight to libc instead of being tracked. That is both the
+     * reentrancy guard of the interposer (tracking a block calls malloc for its backing
+     * memory) and what keeps the backing memory of `operator new` from being counted twice.
+     *
+     * Scopes nest. Without the preload library they only cost a thread-local increment.
+     */
+    class BypassScope {
+    public:
+        BypassScope() noexcept;
+        ~BypassScope();
+
+        BypassScope(const BypassScope&) = delete;
+        BypassScope& operator=(const BypassScope&) = delete;
+    };
+
+    /**
+     * @brief True while the calling thread is inside a BypassScope.
+     */
+    bool IsBypassed() noexcept;
+
+    /**
+     * @brief malloc for MemSentry's own tables and buffers (registry names, exporter
+     * buffers, sampler rings, leak tables...).
+     *
+     * Runs inside a BypassScope, so the library's bookkeeping never shows up in the
+     * heap stats it reports, even under the `memsentry_preload` library.
+     * Release the block with std::free().
+     */
+    void* UntrackedMalloc(size_t size) noexcept;
+
+    /**
+     * @brief calloc counterpart of UntrackedMalloc().
+     */
+    void* UntrackedCalloc(size_t count, size_t size) noexcept;
+
+    /**
+     * @brief Sets the heap that tracks interposed malloc family allocations.
+     * Blocks allocated before the change stay on their heap.
+     * @param heap The heap, nullptr restores the default one (see GetHeap()).
+     */
+    void SetHeap(heap::Heap* heap) noexcept;
+
+    /**
+     * @brief Heap tracking interposed malloc family allocations.
+     * Defaults to a process-wide "MallocHeap", kept apart from the default heap of
+     * `operator new` so C and C++ allocations can be told apart in reports.
+     */
+    heap::Heap* GetHeap();
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::heap { class Heap; }
+
+namespace MEM_SENTRY::leaks {
+
+    /// @brief Internal tables of a LeakDetector (defined in leaks.cc).
+    struct LeakGroup;
+    struct AgeMarks;
+
+    /**
+     * @struct LeakEntry
+     * @brief Live allocations of one heap, call site and size class older than the leak age.
+     */
+    struct LeakEntry {
+        /// @brief Interned name of the heap.
+        const char* m_HeapName;
+
+        /// @brief Call site (see sites.h), 0 for untagged allocations.
+        uint32_t m_SiteId;
+
+        /// @brief log2 size class (see snapshot::SizeClassOf()).
+        uint32_t m_SizeClass;
+
+        uint64_t m_Count;
+
+        /// @brief Bytes accounted by the heap (user size + alignment padding).
+        uint64_t m_Bytes;
+
+        /// @brief Age of the oldest block in nanoseconds (a lower bound for blocks without timestamp).
+        uint64_t m_OldestAge;
+
+        /// @brief Allocation id of the oldest block, to find it in ReportMemory().
+        uint32_t m_OldestAllocId;
+    };
+
+    /**
+     * @class LeakReport
+     * @brief Suspected leaks of one pass over every heap, largest first.
+     */
+    class LeakReport {
+    private:
+        std::vector<LeakEntry> m_Entries;
+
+        uint64_t m_TotalCount;
+
+        uint64_t m_TotalBytes;
+
+        /// @brief Suspects left out because a heap had more than `LEAK_MAX_GROUPS` groups.
+        uint64_t m_Dropped;
+
+        uint64_t m_MinAge;
+
+    public:
+        /**
+         * @param minAge Age threshold of the pass, in nanoseconds.
+         */
+        explicit LeakReport(uint64_t minAge = 0);
+
+        /**
+         * @brief Appends a group (the entries are sorted by Sort()).
+         */
+        void Add(const LeakEntry& entry);
+
+        /**
+         * @brief Counts suspects that didn't fit the group table.
+         */
+        void AddDropped(uint64_t count) noexcept { m_Dropped += count; }
+
+        /**
+         * @brief Sorts the entries by bytes, largest first.
+         */
+        void Sort();
+
+        const std::vector<LeakEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        uint64_t GetTotalCount() const noexcept { return m_TotalCount; }
+
+        uint64_t GetTotalBytes() const noexcept { return m_TotalBytes; }
+
+        uint64_t GetDroppedCount() const noexcept { return m_Dropped; }
+
+        uint64_t GetMinAge() const noexcept { return m_MinAge; }
+
+        /**
+         * @brief Prints the report as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+
+    /**
+     * @class LeakDetector
+     * @brief Background thread reporting the live allocations older than an age: the
+     * slow leaks of long running processes that an end of run report never sees.
+     *
+     * Every pass walks each heap's list with Heap::ForEachAllocation(), so a heap lock
+     * is only held for one chunk of `chunkSize` nodes at a time. Suspects are
+     * grouped by heap, call site (MS_NEW) and size class.
+     *
+     * The age of a block comes from its timestamp when its heap profiles lifetimes
+     * (Heap::SetLifetimeProfile()). Otherwise each pass records the heap's next
+     * allocation id with the time: a block whose id is below a mark taken at least
+     * `minAge` ago is at least that old. Such blocks are only flagged after the
+     * detector has run for `minAge`, and their age is a lower bound.
+     *
+     * @note A pass only holds the registry lock to pick the next heap (see
+     * registry::ForEachHeap()). Heaps can be created and destroyed while it runs; a
+     * heap destroyed mid-pass waits for the walk of that heap to finish.
+     */
+    class LeakDetector {
+    private:
+        uint64_t m_MinAge;
+
+        /** @brief Nodes visited per heap lock hold. */
+        size_t m_ChunkSize;
+
+        /** @brief Group table of the heap being walked (malloc'ed once). */
+        LeakGroup* p_Groups;
+
+        /** @brief Tells the groups of the current heap walk from stale ones. */
+        uint64_t m_Generation;
+
+        /** @brief Age marks indexed by heap registry id (malloc'ed once, entries on demand). */
+        AgeMarks** p_Marks;
+
+        /** @brief Serializes passes between ScanNow() and the background thread. */
+        std::mutex m_ScanMutex;
+
+        /** @brief Guards m_Latest. */
+        mutable std::mutex m_ReportMutex;
+
+        LeakReport m_Latest;
+
+        std::atomic<uint64_t> m_Passes;
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Stop;
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitCv;
+
+        /**
+         * @brief Updates the marks of a heap and returns them, nullptr if they can't be allocated.
+         */
+        AgeMarks* marksOf(heap::Heap* heap, uint64_t now);
+
+        /**
+         * @brief Walks one heap and appends its groups to the report.
+         */
+        void scanHeap(heap::Heap* heap, uint64_t now, LeakReport& report);
+
+        void loop(std::chrono::milliseconds interval, std::FILE* out);
+
+    public:
+        /**
+         * @param minAge Live allocations at least this old are reported.
+         * @param chunkSize Nodes visited per heap lock hold (at least 1): smaller chunks
+         * shorten the waits of allocating threads, at the cost of more lock round trips.
+         */
+        explicit LeakDetector(std::chrono::milliseconds minAge, size_t chunkSize = constants::SNAPSHOT_CHUNK_SIZE);
+
+        /**
+         * @brief Stops the background thread and releases the tables.
+         */
+        ~LeakDetector();
+
+        LeakDetector(const LeakDetector&) = delete;
+        LeakDetector& operator=(const LeakDetector&) = delete;
+
+        /**
+         * @brief Starts a pass every `interval` on a low priority thread (see threads::LowerPriority()).
+         * @param out If set, each report with suspects is printed to it.
+         * @return false if the detector is already running.
+         */
+        bool Start(std::chrono::milliseconds interval, std::FILE* out = nullptr);
+
+        /**
+         * @brief Stops the background thread (no-op if it isn't running).
+         */
+        void Stop();
+
+        /**
+         * @brief Runs one pass on the calling thread.
+         * @return LeakReport The suspects of this pass (also kept as the latest report).
+         */
+        LeakReport ScanNow();
+
+        /**
+         * @brief Copy of the report of the last pass.
+         */
+        LeakReport GetReport() const;
+
+        uint64_t PassCount() const noexcept { return m_Passes.load(std::memory_order_relaxed); }
+    };
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::lifetime {
+
+    /**
+     * @brief Upper bounds (exclusive, nanoseconds) of the lifetime buckets, about
+     * half a decade apart. The last bucket has no upper bound.
+     */
+    constexpr uint64_t BUCKET_LIMITS[constants::LIFETIME_BUCKETS - 1] = {
+        1000ull, 3000ull, 10000ull, 30000ull, 100000ull, 300000ull,
+        1000000ull, 3000000ull, 10000000ull, 30000000ull, 100000000ull, 300000000ull,
+        1000000000ull, 3000000000ull, 10000000000ull
+    };
+
+    /**
+     * @brief Returns the lifetime bucket of a duration in nanoseconds.
+     */
+    constexpr uint32_t BucketOf(uint64_t nanoseconds) noexcept {
+        uint32_t bucket = 0;
+        while (bucket < constants::LIFETIME_BUCKETS - 1 && nanoseconds >= BUCKET_LIMITS[bucket]) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief Monotonic time in nanoseconds, the timestamp stored in AllocHeader::m_Timestamp.
+     */
+    uint64_t Now() noexcept;
+
+    /**
+     * @brief Short label of a bucket ("< 3ms", ">= 10s").
+     * @return const char* Static string.
+     */
+    const char* BucketName(uint32_t bucket) noexcept;
+
+    /**
+     * @class Histogram
+     * @brief Frees of one heap counted by size class and lifetime bucket.
+     *
+     * Every cell is a pair of relaxed atomics, so any thread records into it without a lock.
+     * Created by `Heap::SetLifetimeProfile()`, with malloc.
+     */
+    class Histogram {
+    private:
+        std::atomic<uint64_t> m_Counts[constants::SNAPSHOT_SIZE_CLASSES][constants::LIFETIME_BUCKETS];
+
+        std::atomic<uint64_t> m_Bytes[constants::SNAPSHOT_SIZE_CLASSES][constants::LIFETIME_BUCKETS];
+
+    public:
+        Histogram() noexcept;
+
+        /**
+         * @brief Counts the free of a `size` bytes block that lived `nanoseconds`.
+         */
+        void Record(uint32_t size, uint64_t nanoseconds) noexcept;
+
+        uint64_t GetCount(uint32_t sizeClass, uint32_t bucket) const noexcept {
+            return m_Counts[sizeClass][bucket].load(std::memory_order_relaxed);
+        }
+
+        uint64_t GetBytes(uint32_t sizeClass, uint32_t bucket) const noexcept {
+            return m_Bytes[sizeClass][bucket].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Zeroes every cell (frees recorded meanwhile may be kept or lost).
+         */
+        void Reset() noexcept;
+    };
+
+    /**
+     * @struct LifetimeEntry
+     * @brief Freed blocks of one size class that lived for one lifetime bucket.
+     */
+    struct LifetimeEntry {
+        /// @brief log2 size class (see snapshot::SizeClassOf()).
+        uint32_t m_SizeClass;
+
+        /// @brief Lifetime bucket (see BucketOf()).
+        uint32_t m_Bucket;
+
+        uint64_t m_Count;
+
+        /// @brief User bytes of the freed blocks.
+        uint64_t m_Bytes;
+    };
+
+    /**
+     * @class LifetimeReport
+     * @brief Copy of the lifetime histogram of one heap: bytes by lifetime bucket.
+     * Produced by `Heap::GetLifetimeReport()`.
+     */
+    class LifetimeReport {
+    private:
+        const char* m_name;
+
+        /** @brief Non-empty cells, sorted by size class then bucket. */
+        std::vector<LifetimeEntry> m_Entries;
+
+        uint64_t m_BucketCounts[constants::LIFETIME_BUCKETS];
+
+        uint64_t m_BucketBytes[constants::LIFETIME_BUCKETS];
+
+        uint64_t m_TotalCount;
+
+        uint64_t m_TotalBytes;
+
+    public:
+        /**
+         * @param heapName Interned heap name, not copied.
+         */
+        explicit LifetimeReport(const char* heapName);
+
+        /**
+         * @brief Copies the cells of a histogram (nullptr leaves the report empty).
+         */
+        void Assign(const Histogram* histogram);
+
+        const char* GetHeapName() const noexcept { return m_name; }
+
+        const std::vector<LifetimeEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        uint64_t GetBucketCount(uint32_t bucket) const noexcept { return m_BucketCounts[bucket]; }
+
+        uint64_t GetBucketBytes(uint32_t bucket) const noexcept { return m_BucketBytes[bucket]; }
+
+        uint64_t GetTotalCount() const noexcept { return m_TotalCount; }
+
+        uint64_t GetTotalBytes() const noexcept { return m_TotalBytes; }
+
+        /**
+         * @brief Bucket holding the median freed byte of a size class, or of every class
+         * with `SNAPSHOT_SIZE_CLASSES`. `LIFETIME_BUCKETS` if nothing was freed.
+         */
+        uint32_t MedianBucket(uint32_t sizeClass = constants::SNAPSHOT_SIZE_CLASSES) const noexcept;
+
+        /**
+         * @brief Prints the bytes by lifetime bucket, then the median lifetime of each size class.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+};
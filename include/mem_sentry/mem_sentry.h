@@ -6,6 +6,14 @@ namespace MEM_SENTRY::heap {
     class Heap;
 }
 
+namespace MEM_SENTRY::pool {
+    class Pool;
+}
+
+namespace MEM_SENTRY::sites {
+    struct Site;
+}
+
 // --------------------------------------------------------------------------
 // 1. Custom Operators
 // --------------------------------------------------------------------------
@@ -47,4 +55,79 @@ void* operator new[](std::size_t count, std::align_val_t al, const std::nothrow_
 void operator delete(void* ptr, const std::nothrow_t& tag) noexcept;
 void operator delete[](void* ptr, const std::nothrow_t& tag) noexcept;
 void operator delete(void* ptr, std::align_val_t al, const std::nothrow_t& tag) noexcept;
-void operator delete[](void* ptr, std::align_val_t al, const std::nothrow_t& tag) noexcept;
\ No newline at end of file
+void operator delete[](void* ptr, std::align_val_t al, const std::nothrow_t& tag) noexcept;
+// --------------------------------------------------------------------------
+// 4. Resizing
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Grows or shrinks a block without moving it.
+ * Succeeds when the new size fits in the slack of the block's backend chunk
+ * (guarded blocks can't grow). The alloc id, heap and list position are kept.
+ *
+ * @return bool false if the block would have to move (it is left untouched).
+ */
+bool sentry_resize_in_place(void* pMem, size_t newSize) noexcept;
+
+/**
+ * @brief realloc() for tracked blocks.
+ * Resizes in place when possible, otherwise moves the data to a new block that keeps
+ * the alloc id and the heap of the old one (the old block goes through the quarantine).
+ *
+ * @param pMem Block to resize, nullptr allocates a new one on `pHeap`.
+ * @param newSize New size, 0 frees the block and returns nullptr.
+ * @param pHeap Heap for new blocks when pMem is nullptr (the default heap if null).
+ * Existing blocks always stay on their heap.
+ *
+ * @return void* The resized block, nullptr if out of memory (pMem stays valid).
+ */
+void* sentry_realloc(void* pMem, size_t newSize, MEM_SENTRY::heap::Heap* pHeap = nullptr) noexcept;
+
+// --------------------------------------------------------------------------
+// 5. Sized Release
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Frees a block whose size is known to the caller (allocators, sized deletes).
+ * It costs the same as a plain delete: the size is only checked against the header
+ * in debug builds, and the heap is resolved from the registry.
+ *
+ * @param pMem Block to free (nullptr is a no-op).
+ * @param size Size the block was allocated with.
+ */
+void sentry_deallocate_sized(void* pMem, size_t size) noexcept;
+
+// --------------------------------------------------------------------------
+// 6. Pooled Allocation
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Allocates a tracked block from a slot of an object pool (see pool.h).
+ * The block is a regular allocation of `pHeap` (stats, leak reports, canaries) whose
+ * slot goes back to the pool on delete, skipping malloc, free and the quarantine.
+ *
+ * @param pPool The pool, its slot size is the size of the block.
+ * @param pHeap Heap tracking the block (the current heap if null).
+ *
+ * @return void* The user data, nullptr if the pool is at capacity, the heap is guarded
+ * or tracking is disabled: the caller falls back to a regular allocation.
+ */
+void* sentry_allocate_pooled(MEM_SENTRY::pool::Pool* pPool, MEM_SENTRY::heap::Heap* pHeap) noexcept;
+
+// --------------------------------------------------------------------------
+// 7. Call Site Tagging (used through MS_NEW, see sites.h)
+// --------------------------------------------------------------------------
+
+/**
+ * @brief Tracked allocation on `pHeap` (the current heap if null) recording its call site.
+ * Placement deletes with the same arguments release the block if a constructor throws.
+ */
+void* operator new(size_t size, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site);
+void* operator new[](size_t size, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site);
+void* operator new(size_t size, std::align_val_t al, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site);
+void* operator new[](size_t size, std::align_val_t al, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site);
+
+void operator delete(void* pMem, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site) noexcept;
+void operator delete[](void* pMem, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site) noexcept;
+void operator delete(void* pMem, std::align_val_t al, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site) noexcept;
+void operator delete[](void* pMem, std::align_val_t al, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site) noexcept;
@@ -0,0 +1,165 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::exporter {
+
+    /**
+     * @class MetricsExporter
+     * @brief Serializes the counters of every registered Heap into OpenMetrics text.
+     *
+     * Exposed families (one sample per heap, labelled with its name and registry id):
+     * - `memsentry_heap_bytes`                  bytes currently allocated (GetTotal).
+     * - `memsentry_heap_allocations`            live allocations (CountAllocations).
+     * - `memsentry_heap_hierarchy_bytes`        bytes across the heap hierarchy (GetTotalHH).
+     * - `memsentry_heap_hierarchy_allocations`  allocations across the hierarchy (CountAllocationsHH).
+     *
+     * Per-thread counters, when enabled with SetThreadMetrics() (one sample per active
+     * thread, labelled with its index and tid, see threads.h; size the buffer for them):
+     * - `memsentry_thread_allocations_total`    tracked blocks allocated by the thread.
+     * - `memsentry_thread_frees_total`          tracked blocks freed by the thread.
+     * - `memsentry_thread_remote_frees_total`   frees of blocks another thread allocated.
+     * - `memsentry_thread_allocated_bytes_total` user bytes allocated by the thread.
+     *
+     * The output buffer is allocated once in the constructor; rendering a scrape only
+     * formats into it, so scrapes never allocate (and never skew the stats they report).
+     *
+     * The text can be pulled with Format(), written to a file on an interval by a
+     * background thread (StartFile), or served over a minimal local HTTP endpoint (StartHttp).
+     * Only one background mode runs at a time.
+     */
+    class MetricsExporter {
+    private:
+        /** @brief Output buffer (malloc'ed once). */
+        char* p_Buffer;
+
+        /** @brief Capacity of p_Buffer in bytes. */
+        size_t m_Capacity;
+
+        /** @brief Length of the last rendered scrape. */
+        size_t m_Length;
+
+        /** @brief Serializes Format() between the caller and the background thread. */
+        std::mutex m_FormatMutex;
+
+        /** @brief Background thread (file writer or HTTP server). */
+        std::thread m_Thread;
+
+        /** @brief Set to ask the background thread to exit. */
+        std::atomic<bool> m_Stop;
+
+        /** @brief Wakes the file writer early on Stop(). */
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitCv;
+
+        /** @brief Target file and its temporary sibling (file mode). */
+        char m_Path[256];
+        char m_TmpPath[264];
+
+        /** @brief Listening socket (HTTP mode), -1 when unused. */
+        int m_ListenFd;
+
+        /** @brief Whether scrapes include the per-thread families. */
+        std::atomic<bool> m_ThreadMetrics;
+
+        /**
+         * @brief Appends formatted text to the buffer.
+         * @return false if the buffer is full.
+         */
+        bool append(size_t& offset, const char* fmt, ...);
+
+        /**
+         * @brief Appends one metric family (HELP, TYPE and a sample per heap).
+         * @return false if the buffer is full.
+         */
+        bool appendFamily(size_t& offset, const char* name, const char* help, int family);
+
+        /**
+         * @brief Appends one per-thread counter family (HELP, TYPE and a sample per active thread).
+         * @return false if the buffer is full.
+         */
+        bool appendThreadFamily(size_t& offset, const char* name, const char* help, int family);
+
+        /**
+         * @brief Renders a scrape into the buffer.
+         * @note Caller must hold m_FormatMutex.
+         */
+        size_t formatLocked();
+
+        /** @brief Renders and atomically replaces the target file (write + rename). */
+        void writeFile();
+
+        /** @brief Answers one HTTP connection with the current scrape. */
+        void serveClient(int clientFd);
+
+        void fileLoop(std::chrono::milliseconds interval);
+        void httpLoop();
+
+    public:
+        /**
+         * @brief Construct a new Metrics Exporter.
+         * @param capacity Size of the output buffer; scrapes that don't fit fail.
+         */
+        explicit MetricsExporter(size_t capacity = constants::METRICS_BUFFER_SIZE);
+
+        /**
+         * @brief Stops the background thread and releases the buffer.
+         */
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        /**
+         * @brief Renders the current stats of every heap into the internal buffer.
+         * @return size_t Length of the text, 0 if it did not fit in the buffer.
+         */
+        size_t Format();
+
+        /**
+         * @brief Text of the last Format() call (not null terminated past Length()).
+         * @warning Not synchronized with the background thread; use it from the
+         * thread that called Format() when no background mode is running.
+         */
+        const char* Data() const noexcept { return p_Buffer; }
+
+        size_t Length() const noexcept { return m_Length; }
+
+        /**
+         * @brief Starts a background thread rewriting `path` every `interval`.
+         * The file is replaced atomically (temporary file + rename).
+         * @return false if a background mode is already running or the path is too long.
+         */
+        bool StartFile(const char* path, std::chrono::milliseconds interval);
+
+        /**
+         * @brief Starts a background HTTP server on 127.0.0.1:`port`.
+         * Every request (any path) is answered with the current scrape. Clients are served
+         * one at a time, and a send that blocks for more than 500ms drops the client.
+         * @param port TCP port, 0 picks a free one (see GetPort()).
+         * @return false if a background mode is already running or the socket failed.
+         */
+        bool StartHttp(uint16_t port);
+
+        /**
+         * @brief Port the HTTP server listens on, 0 if it isn't running.
+         */
+        uint16_t GetPort() const;
+
+        /**
+         * @brief Stops the background thread (no-op if none is running).
+         */
+        void Stop();
+
+        /**
+         * @brief Adds (or removes) the per-thread counter families to the next scrapes.
+         */
+        void SetThreadMetrics(bool enabled) noexcept { m_ThreadMetrics.store(enabled, std::memory_order_relaxed); }
+    };
+};
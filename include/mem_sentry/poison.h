@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace MEM_SENTRY::poison {
+
+    /**
+     * @enum Kernel
+     * @brief Implementation used by the fill / verify functions.
+     */
+    enum class Kernel : uint8_t {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     * @brief Fills `size` bytes at `dst` with `pattern`.
+     */
+    void Fill(void* dst, size_t size, uint8_t pattern) noexcept;
+
+    /**
+     * @brief Checks that `size` bytes at `src` all equal `pattern`.
+     * @return size_t Offset of the first mismatching byte, `size` if they all match.
+     */
+    size_t Verify(const void* src, size_t size, uint8_t pattern) noexcept;
+
+    /**
+     * @brief Fills `size` bytes at `dst` with a repeated 32-bit `pattern` (e.g. a canary).
+     * Byte `i` receives byte `i % 4` of the pattern in memory order; `size` needn't be
+     * a multiple of 4.
+     */
+    void Fill32(void* dst, size_t size, uint32_t pattern) noexcept;
+
+    /**
+     * @brief Checks a region written by Fill32().
+     * @return size_t Offset of the first mismatching byte, `size` if they all match.
+     */
+    size_t Verify32(const void* src, size_t size, uint32_t pattern) noexcept;
+
+    /**
+     * @brief Kernel picked for this CPU (the widest supported one, unless overridden).
+     */
+    Kernel GetKernel() noexcept;
+
+    /**
+     * @brief Forces a kernel (benchmarks and tests).
+     * @return false if the CPU doesn't support it; the current kernel is kept.
+     */
+    bool SetKernel(Kernel kernel) noexcept;
+
+    /**
+     * @brief Printable name of a kernel.
+     */
+    const char* KernelName(Kernel kernel) noexcept;
+
+    /**
+     * @brief Enables filling new allocations with `ALLOC_FILL_BYTE` (uninitialized
+     * memory pattern), so reads of uninitialized data stand out. Off by default.
+     */
+    void SetAllocFill(bool enabled) noexcept;
+
+    bool GetAllocFill() noexcept;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::pool {
+
+    class Pool;
+
+    /**
+     * @brief Creates a pool of fixed-size tracked slots (see ISentry<T>::usePool()).
+     *
+     * Slot layout: `[Slot prefix][Padding?][Front Canary][Header][User Data][Back Canary]`.
+     * The prefix names the owning pool, so a free finds it from the header alone
+     * (p_OriginalAddress is the slot start). The canary size is the one current at creation.
+     *
+     * Pools live for the whole process, like the default heap: slots of live objects
+     * and the magazines of other threads keep referring to them.
+     *
+     * @param size Bytes of user data per slot.
+     * @param alignment Alignment of the user data (a power of 2, 0 for the default one).
+     * @param capacity Max slots ever carved; once reached, allocations fall back to
+     * the regular path.
+     * @return Pool* The pool, nullptr if `POOL_MAX_POOLS` pools already exist.
+     */
+    Pool* Create(size_t size, size_t alignment, size_t capacity);
+
+    /**
+     * @brief Takes a free slot, from the calling thread's magazine when it has one.
+     * An empty magazine is refilled from the pool's depot (one lock for half a magazine).
+     * @return char* Start of the slot, nullptr if the pool is at capacity.
+     */
+    char* Acquire(Pool* pool) noexcept;
+
+    /**
+     * @brief Gives the slot of a pooled block back to its pool.
+     * @param header Header of a block with ALLOC_FLAG_POOLED, already removed from its heap.
+     */
+    void Release(alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Offset of the user data from the start of a slot.
+     */
+    size_t DataOffset(const Pool* pool) noexcept;
+
+    /**
+     * @brief Bytes of user data of a slot.
+     */
+    size_t SlotSize(const Pool* pool) noexcept;
+
+    /**
+     * @brief Alignment the pool was created with (0 for the default one).
+     */
+    size_t Alignment(const Pool* pool) noexcept;
+
+    /**
+     * @brief Front and back canary size of the pool's blocks.
+     */
+    size_t CanarySize(const Pool* pool) noexcept;
+
+    size_t GetCapacity(const Pool* pool) noexcept;
+
+    /**
+     * @brief Slots carved so far (live blocks plus free slots).
+     */
+    size_t CarvedSlots(const Pool* pool) noexcept;
+
+    /**
+     * @brief Returns the calling thread's magazines to their depots.
+     * Also runs automatically when a thread exits.
+     */
+    void Flush() noexcept;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::quarantine {
+
+    /**
+     * @brief Takes over a block being deleted instead of freeing it right away.
+     *
+     * The user data is poisoned with `QUARANTINE_POISON_BYTE` and the block is queued
+     * in a per-thread FIFO bounded by bytes. The header keeps its freed signature, so a
+     * double delete is still caught while the block sits here, and malloc can't hand
+     * the memory out again meanwhile.
+     *
+     * When the FIFO is over capacity the oldest blocks are evicted in a batch: each one
+     * is checked for writes after free (poison and signature intact) and then freed.
+     *
+     * @param header Header of a regular (malloc'ed) allocation, already removed from
+     * its heap and marked `MEMSYSTEM_FREED_SIGNATURE`.
+     */
+    void Push(alloc_header::AllocHeader* header);
+
+    /**
+     * @brief Verifies and frees every block quarantined by the calling thread.
+     * Also runs automatically when a thread exits.
+     */
+    void Flush();
+
+    /**
+     * @brief Sets the per-thread quarantine size in bytes of user data.
+     * 0 disables the quarantine (blocks are freed on delete, as before).
+     * Threads apply a smaller capacity on their next delete.
+     */
+    void SetThreadCapacity(size_t bytes) noexcept;
+
+    size_t GetThreadCapacity() noexcept;
+
+    /**
+     * @brief User bytes currently held by the calling thread's quarantine.
+     */
+    size_t ThreadBytes() noexcept;
+
+    /**
+     * @brief Number of quarantined blocks found modified after free, process-wide.
+     */
+    uint64_t CorruptionCount() noexcept;
+};
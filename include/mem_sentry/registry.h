@@ -0,0 +1,146 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::heap {
+    class Heap;
+}
+
+namespace MEM_SENTRY::registry {
+
+    /**
+     * @struct HeapSlot
+     * @brief Process-wide registry entry of one heap, indexed by its dense 16-bit id.
+     *
+     * Every allocation header stores the id instead of a `Heap*`, so headers, binary
+     * traces and stats arrays can identify a heap with 2 bytes.
+     *
+     * The indirection is also what allows a Heap to die with live allocations: its slot
+     * is redirected to the orphan heap in O(1), so headers never dangle.
+     *
+     * Reference counting: a live heap owns its slot without touching m_Refs (no cost
+     * on the allocation path). When the heap is destroyed with N live allocations,
+     * m_Refs becomes N and every later free of those blocks releases one reference.
+     * The id is recycled when the last one goes away.
+     *
+     * Every member has a constant initializer so the table is constant-initialized:
+     * heaps created before the registry's translation unit is initialized (e.g. by an
+     * interposed malloc at load time) must not be wiped by a dynamic initializer.
+     */
+    struct HeapSlot {
+        /** @brief Heap currently tracking the allocations of this id. */
+        std::atomic<heap::Heap*> p_Heap{nullptr};
+
+        /** @brief Orphaned allocations still referencing this id. */
+        std::atomic<uint32_t> m_Refs{0};
+
+        /** @brief Bumped each time the id is handed to a new heap (see Generation()). */
+        std::atomic<uint32_t> m_Generation{0};
+
+        /** @brief ForEachHeap() calls currently visiting the heap; Unlist() waits for 0. */
+        std::atomic<uint32_t> m_Visitors{0};
+
+        /** @brief Free list link (next free id), registry internal. */
+        uint32_t m_NextFree = 0;
+
+        /** @brief True while the owning heap is alive and visible to ForEachHeap(). */
+        bool m_Listed = false;
+    };
+
+    /**
+     * @brief Raw access to the slot table, used by the inline lookups below.
+     */
+    HeapSlot* Slots() noexcept;
+
+    /**
+     * @brief Claims a free id for a newly constructed heap.
+     * @param heap The heap that will own the id.
+     * @return uint16_t The id (dense, recently freed ids are reused first).
+     * @throws std::length_error if all `MAX_HEAPS` ids are in use.
+     */
+    uint16_t Acquire(heap::Heap* heap);
+
+    /**
+     * @brief Hides a dying heap from ForEachHeap().
+     * Waits for any enumeration currently visiting it to leave it.
+     */
+    void Unlist(uint16_t id);
+
+    /**
+     * @brief Hands the id of a dying heap over to its orphaned allocations.
+     *
+     * @param id Id of the heap being destroyed.
+     * @param orphan Heap that adopted the allocations.
+     * @param liveAllocations Number of adopted allocations; 0 recycles the id now.
+     */
+    void Orphan(uint16_t id, heap::Heap* orphan, uint32_t liveAllocations);
+
+    /**
+     * @brief Drops one orphaned allocation reference, recycling the id at zero.
+     */
+    void Release(uint16_t id);
+
+    /**
+     * @brief Number of ids currently in use (live heaps + ids kept alive by orphans).
+     */
+    uint32_t CountSlots() noexcept;
+
+    /**
+     * @brief Calls `visit` for every live heap, in id order.
+     *
+     * The registry lock is only held to pick the next listed heap, which is pinned
+     * while `visit` runs without the lock: the heap can't finish its destruction
+     * meanwhile, and `visit` may create heaps or intern names. Heaps created or
+     * destroyed during the enumeration may or may not be visited.
+     *
+     * @warning `visit` must not destroy the heap it is visiting (it would deadlock).
+     */
+    void ForEachHeap(void (*visit)(heap::Heap*, void*), void* context);
+
+    /**
+     * @brief Lambda friendly overload of ForEachHeap().
+     */
+    template<typename Fn>
+    void ForEach(Fn&& fn) {
+        ForEachHeap([](heap::Heap* heap, void* context) {
+            (*static_cast<std::remove_reference_t<Fn>*>(context))(heap);
+        }, (void*)&fn);
+    }
+
+    /**
+     * @brief Returns a stable, process-wide copy of `name`.
+     *
+     * Equal names always return the same pointer, so interned names can be compared
+     * by address. Names are truncated to 99 characters and never freed.
+     */
+    const char* InternName(const char* name);
+
+    /**
+     * @brief O(1) lookup of the heap currently tracking an id.
+     * @return heap::Heap* nullptr if the id is free. For the id of a destroyed heap
+     * this is the orphan heap.
+     */
+    inline heap::Heap* Find(uint16_t id) noexcept {
+        return Slots()[id].p_Heap.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Number of heaps that owned an id so far, including the current one.
+     *
+     * Ids are recycled, so per-id state kept across enumerations (e.g. the previous
+     * counters of a sampler) must also match the generation to belong to the same heap.
+     */
+    inline uint32_t Generation(uint16_t id) noexcept {
+        return Slots()[id].m_Generation.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the heap currently tracking an allocation.
+     */
+    inline heap::Heap* HeapOf(const alloc_header::AllocHeader* alloc) noexcept {
+        return Find(alloc->m_HeapId);
+    }
+};
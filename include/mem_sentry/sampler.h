@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::sampler {
+
+    /**
+     * @struct HeapSample
+     * @brief Counters of one heap at one sampling tick.
+     */
+    struct HeapSample {
+        /// @brief steady_clock time of the tick, in nanoseconds.
+        uint64_t m_Timestamp;
+
+        /// @brief Interned name of the heap (see registry::InternName()).
+        const char* m_name;
+
+        /// @brief Registry id of the heap.
+        uint16_t m_HeapId;
+
+        /// @brief Bytes allocated (Heap::GetTotal()).
+        int64_t m_Bytes;
+
+        /// @brief Live allocations (Heap::CountAllocations()).
+        int64_t m_Count;
+
+        /// @brief Allocations per second since the previous tick (0 on the first one).
+        double m_AllocRate;
+
+        /// @brief Frees per second since the previous tick (0 on the first one).
+        double m_FreeRate;
+    };
+
+    /**
+     * @class StatsSampler
+     * @brief Samples every registered heap into a fixed-size time series ring.
+     *
+     * Each tick (SampleNow(), or the background thread started by Start()) appends
+     * one HeapSample per live heap. When the ring is full the oldest samples are
+     * overwritten, so memory use is fixed at construction.
+     *
+     * Rates are derived from the monotonic Heap::GetAllocCount() / GetFreeCount()
+     * counters, so sampling costs a few relaxed loads per heap and never takes a
+     * heap lock.
+     */
+    class StatsSampler {
+    private:
+        /**
+         * @brief Last counters seen for a heap id, used to compute rates.
+         */
+        struct PrevCounters {
+            uint64_t m_Timestamp;
+            uint32_t m_Generation;
+            uint64_t m_AllocCount;
+            uint64_t m_FreeCount;
+        };
+
+        /** @brief Sample ring (malloc'ed once). */
+        HeapSample* p_Ring;
+
+        /** @brief Capacity of the ring in samples. */
+        size_t m_Capacity;
+
+        /** @brief Total samples ever written; the next one goes to m_Written % m_Capacity. */
+        uint64_t m_Written;
+
+        /** @brief Previous counters indexed by heap id (MAX_HEAPS entries, malloc'ed once). */
+        PrevCounters* p_Prev;
+
+        /** @brief Guards the ring and p_Prev. */
+        mutable std::mutex m_RingMutex;
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Stop;
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitCv;
+
+        void loop(std::chrono::milliseconds interval);
+
+        /**
+         * @brief Copies the samples newer than `window`, of one heap or of all of them.
+         */
+        std::vector<HeapSample> collect(std::chrono::milliseconds window, bool allHeaps, uint16_t heapId) const;
+
+    public:
+        /**
+         * @param capacity Number of samples kept (shared by all heaps).
+         */
+        explicit StatsSampler(size_t capacity = constants::SAMPLER_RING_SIZE);
+
+        /**
+         * @brief Stops the sampling thread and releases the ring.
+         */
+        ~StatsSampler();
+
+        StatsSampler(const StatsSampler&) = delete;
+        StatsSampler& operator=(const StatsSampler&) = delete;
+
+        /**
+         * @brief Starts a background thread calling SampleNow() every `interval`.
+         * @return false if it is already running.
+         */
+        bool Start(std::chrono::milliseconds interval);
+
+        /**
+         * @brief Stops the background thread (no-op if it isn't running).
+         */
+        void Stop();
+
+        /**
+         * @brief Takes one sample of every live heap right now.
+         */
+        void SampleNow();
+
+        /**
+         * @brief Returns the samples of one heap taken within the last `window`, oldest first.
+         * @param heapId Registry id of the heap (see Heap::GetId()).
+         */
+        std::vector<HeapSample> Query(uint16_t heapId, std::chrono::milliseconds window) const;
+
+        /**
+         * @brief Returns the samples of every heap taken within the last `window`, oldest first.
+         */
+        std::vector<HeapSample> Query(std::chrono::milliseconds window) const;
+
+        size_t Capacity() const noexcept { return m_Capacity; }
+
+        /**
+         * @brief Number of samples currently held in the ring.
+         */
+        size_t Size() const;
+    };
+};
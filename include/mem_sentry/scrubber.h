@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::scrubber {
+
+    /**
+     * @class HeapScrubber
+     * @brief Low priority background thread validating live allocations.
+     *
+     * Every tick it advances through each heap's allocation list by at most
+     * `nodesPerTick` nodes (Heap::ScrubStep()), checking the header signature and the
+     * front/back canaries (or the guard slack) of every allocation it visits. A heap
+     * lock is held for one bounded step at a time, so allocating threads barely notice.
+     *
+     * Corruption is reported (once per allocation) as soon as the walk reaches the
+     * block, instead of when it is eventually deleted.
+     *
+     * @note Heaps share a single scrub cursor each, so only one scrubber can run at a time.
+     */
+    class HeapScrubber {
+    private:
+        size_t m_NodesPerTick;
+
+        /** @brief Corrupted allocations found so far. */
+        std::atomic<uint64_t> m_Corruptions;
+
+        /** @brief Allocations validated so far. */
+        std::atomic<uint64_t> m_Checked;
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Stop;
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitCv;
+
+        void loop(std::chrono::milliseconds interval);
+
+    public:
+        explicit HeapScrubber(size_t nodesPerTick = constants::SCRUB_NODES_PER_TICK);
+
+        /**
+         * @brief Stops the background thread.
+         */
+        ~HeapScrubber();
+
+        HeapScrubber(const HeapScrubber&) = delete;
+        HeapScrubber& operator=(const HeapScrubber&) = delete;
+
+        /**
+         * @brief Starts scrubbing every `interval` on a low priority thread (see threads::LowerPriority()).
+         * @return false if this or another scrubber is already running.
+         */
+        bool Start(std::chrono::milliseconds interval);
+
+        /**
+         * @brief Stops the background thread (no-op if it isn't running).
+         */
+        void Stop();
+
+        /**
+         * @brief Runs one tick on the calling thread.
+         * @return size_t Corrupted allocations found by this tick.
+         */
+        size_t ScrubNow();
+
+        uint64_t CorruptionCount() const noexcept { return m_Corruptions.load(std::memory_order_relaxed); }
+
+        uint64_t CheckedCount() const noexcept { return m_Checked.load(std::memory_order_relaxed); }
+    };
+};
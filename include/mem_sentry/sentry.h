@@ -1,24 +1,163 @@
 #pragma once
+#include <new>
+#include <type_traits>
+#include <typeinfo>
 
 #include "mem_sentry/heap.h"
 #include "mem_sentry/mem_sentry.h"
+#include "mem_sentry/heap_allocator.h"
+#include "mem_sentry/pool.h"
+#include "mem_sentry/census.h"
+#include "mem_sentry/sites.h"
 
 namespace MEM_SENTRY::sentry {
 
     /**
-     * @class ISentry
-     * @brief A CRTP base class that automates memory tracking for derived classes.
-     * 
-     * Inherit from this class to force all dynamic allocations (via `new`) of your object
-     * to be routed through the MEM_SENTRY memory system. It automatically manages 
-     * a static heap pointer unique to each derived class type.
-     * 
+     * @class BoundHeap
+     * @brief Heap bound to a tag type at compile time (see ISentry<T, Tag>).
+     *
+     * A tag names its heap:
+     * @code
+     * struct AudioHeapTag { static constexpr const char* Name = "AudioHeap"; };
+     * @endcode
+     *
+     * The storage is constinit, so Get() folds to a link-time constant: no load, no
+     * null check. The heap is constructed during static initialization and never
+     * destroyed (like the default heap).
+     *
+     * @warning Tagged classes must not be allocated from other static initializers,
+     * which may run before the heap is constructed.
+     */
+    template<typename Tag>
+    class BoundHeap {
+    private:
+        alignas(MEM_SENTRY::heap::Heap) static inline constinit unsigned char m_Storage[sizeof(MEM_SENTRY::heap::Heap)] = {};
+
+        static bool construct() {
+            new (m_Storage) MEM_SENTRY::heap::Heap(Tag::Name);
+            return true;
+        }
+
+        static inline const bool m_Constructed = construct();
+
+    public:
+        static MEM_SENTRY::heap::Heap* Get() noexcept {
+            // odr-uses the flag, so its initializer (the construction) is instantiated.
+            (void)&m_Constructed;
+            return std::launder(reinterpret_cast<MEM_SENTRY::heap::Heap*>(m_Storage));
+        }
+    };
+
+    /**
+     * @class ISentryLite
+     * @brief Non-polymorphic CRTP base with the per-class heap routing of ISentry.
+     *
+     * It only has static members, so it adds no bytes to T (empty base) and keeps
+     * trivial types trivial (no vptr, no virtual destructor): they can still be
+     * memcpy'ed and packed in SIMD-friendly arrays.
+     *
+     * Deletes are sized: the compiler passes the static size of the deleted type, which
+     * debug builds check against the block (see sentry_deallocate_sized()). It is only a
+     * check, the free itself is the same as a plain delete.
+     *
+     * Every class also has a census entry (see census.h): live instances and bytes
+     * of T across all heaps. Derived classes count under the class they pass as T.
+     *
+     * @warning Without a virtual destructor, deleting a derived object through a base
+     * pointer is undefined behaviour, as for any non-polymorphic class. Use ISentry<T>
+     * for polymorphic hierarchies.
+     *
      * @tparam T The derived class type (Curiously Recurring Template Pattern).
-     * Example: class MyClass : public ISentry<MyClass> {};
+     * Example: struct Particle : public ISentryLite<Particle> { float x, y, z; };
+     * @tparam Tag Optional heap tag (see BoundHeap): binds the class heap at compile time,
+     * so allocations skip the runtime heap lookup. setHeap() is unavailable then.
      */
-    template<typename T>
-    class ISentry { 
+    template<typename T, typename Tag = void>
+    class ISentryLite { 
     private:
+        /// @brief true when the heap is bound at compile time.
+        static constexpr bool BOUND = !std::is_void_v<Tag>;
+
+        /**
+         * @brief Heap new objects of T are allocated on.
+         */
+        static MEM_SENTRY::heap::Heap* classHeap() noexcept {
+            if constexpr (BOUND) {
+                return BoundHeap<Tag>::Get();
+            } else {
+                checkHeap();
+                return pHeap;
+            }
+        }
+
+        /**
+         * @brief Census id of T, registered (and its name demangled) on first use.
+         */
+        static uint32_t typeId() {
+            static const uint32_t id = MEM_SENTRY::census::RegisterType(typeid(T).name());
+            return id;
+        }
+
+        /**
+         * @brief Instances of T in an array block of `size` bytes. `new T[n]` asks for
+         * n * sizeof(T), plus (Itanium C++ ABI) a cookie holding n when T has a destructor to run.
+         */
+        static constexpr uint64_t instancesOf(size_t size) noexcept {
+            constexpr size_t cookie = std::is_trivially_destructible_v<T> ? 0
+                : (alignof(T) > sizeof(size_t) ? alignof(T) : sizeof(size_t));
+            return size > cookie ? (size - cookie) / sizeof(T) : 0;
+        }
+
+        /**
+         * @brief Counts a new block of the class in the type census.
+         * @param instances Objects of T in the block (see instancesOf() for arrays).
+         * @return void* The block, unchanged (nullptr included).
+         */
+        static void* counted(void* ptr, uint64_t instances = 1) noexcept {
+        #if MEM_SENTRY_ENABLE
+            if(ptr)
+                MEM_SENTRY::census::OnAlloc(typeId(), ptr, instances);
+        #endif
+            return ptr;
+        }
+
+        /**
+         * @brief Uncounts a block of the class before it is freed.
+         */
+        static void uncount(void* ptr) noexcept {
+        #if MEM_SENTRY_ENABLE
+            if(ptr)
+                MEM_SENTRY::census::OnFree(typeId(), ptr);
+        #endif
+        }
+
+        /**
+         * @brief Uncounts an array block of the class, its instances computed again from the header size.
+         */
+        static void uncountArray(void* ptr) noexcept {
+        #if MEM_SENTRY_ENABLE
+            if(ptr)
+                MEM_SENTRY::census::OnFree(typeId(), ptr,
+                    instancesOf(((const MEM_SENTRY::alloc_header::AllocHeader*)ptr - 1)->m_Size));
+        #endif
+        }
+
+        /**
+         * @brief Block from the class pool for an object of exactly T (nullptr: use the heap).
+         * Derived classes and arrays have other sizes, and alignments past the pool's
+         * (`alignof(T)`) can't be met by its slots: both take the regular path.
+         */
+        static void* poolAllocate(size_t size, size_t alignment = 0) noexcept {
+            if(!pPool || size != sizeof(T))
+                return nullptr;
+
+            size_t poolAlignment = MEM_SENTRY::pool::Alignment(pPool);
+            if(alignment > (poolAlignment ? poolAlignment : __STDCPP_DEFAULT_NEW_ALIGNMENT__))
+                return nullptr;
+
+            return sentry_allocate_pooled(pPool, classHeap());
+        }
+
         /**
          * @brief Lazy initialization of the internal heap pointer.
          * 
@@ -31,16 +170,28 @@ namespace MEM_SENTRY::sentry {
 
     public:
         /// @brief The specific heap instance used for allocating objects of type T.
-        /// Unique for every class T due to the template nature of ISentry.
+        /// Unique for every class T due to the template nature of ISentryLite.
         static MEM_SENTRY::heap::Heap* pHeap;
+
+        /// @brief Slot pool of the class, nullptr until usePool() is called.
+        static MEM_SENTRY::pool::Pool* pPool;
         
         /**
-         * @brief Virtual destructor.
-         * @note Adds a virtual table pointer (vptr) to the object
-         * 
-         * Required to ensure derived destructors are called correctly when deleting via ISentry*.
+         * @brief Heap source of the class, for allocators (see allocator::HeapAllocator).
          */
-        virtual ~ISentry() = default; 
+        struct HeapSource {
+            static MEM_SENTRY::heap::Heap* Get() noexcept {
+                return classHeap();
+            }
+        };
+
+        /**
+         * @brief Allocator for containers owned by T: default-constructed, it allocates
+         * from T's heap, so the members of a tracked object follow the object.
+         * Example: std::vector<int, Allocator<int>> m_Items;
+         */
+        template<typename U>
+        using Allocator = MEM_SENTRY::allocator::HeapAllocator<U, HeapSource>;
 
         /**
          * @brief Assigns a specific memory heap to this class type.
@@ -50,9 +201,27 @@ namespace MEM_SENTRY::sentry {
          * @param heap Pointer to the target heap.
          */
         static void setHeap(MEM_SENTRY::heap::Heap* heap){
+            static_assert(!BOUND, "the heap of this class is bound at compile time by its tag");
             pHeap = heap;
         }
 
+        /**
+         * @brief Serves `new T` from a pool of `sizeof(T)` slots.
+         *
+         * Pooled objects are still tracked by the class heap (stats, leak reports,
+         * canaries), but their slot comes from a per-thread magazine and goes back to
+         * it on delete: no malloc, no free, no quarantine. Once `capacity` slots are
+         * in use, allocations fall back to the regular path.
+         *
+         * Call it once at startup, like setHeap(). Without tracking (MEM_SENTRY_ENABLE=0) it has no effect.
+         *
+         * @param capacity Max objects served by the pool at once.
+         */
+        static void usePool(size_t capacity){
+            if(!pPool)
+                pPool = MEM_SENTRY::pool::Create(sizeof(T), alignof(T), capacity);
+        }
+
         // ========================================================================
         // STANDARD ALLOCATION
         // Routes standard `new T` and `new T[]` to the tracked heap.
@@ -63,8 +232,9 @@ namespace MEM_SENTRY::sentry {
          * Allocates memory from the class's assigned heap (pHeap).
          */
         void* operator new(size_t size){
-            checkHeap();
-            return ::operator new(size, pHeap);
+            if(void* ptr = poolAllocate(size))
+                return counted(ptr);
+            return counted(::operator new(size, classHeap()));
         }
 
         /**
@@ -72,8 +242,7 @@ namespace MEM_SENTRY::sentry {
          * Allocates arrays from the class's assigned heap (pHeap).
          */
         void* operator new[](size_t size){
-            checkHeap();
-            return ::operator new(size, pHeap);
+            return counted(::operator new(size, classHeap()), instancesOf(size));
         }
 
         // ========================================================================
@@ -86,16 +255,16 @@ namespace MEM_SENTRY::sentry {
          * Used automatically for types with `alignas(X)` specifiers.
          */
         void* operator new(size_t size, std::align_val_t alignment){
-            checkHeap();
-            return ::operator new(size, alignment, pHeap);
+            if(void* ptr = poolAllocate(size, (size_t)alignment))
+                return counted(ptr);
+            return counted(::operator new(size, alignment, classHeap()));
         }
 
         /**
          * @brief Aligned array operator new[] override.
          */
         void* operator new[](size_t size, std::align_val_t alignment){
-            checkHeap();
-            return ::operator new(size, alignment, pHeap);
+            return counted(::operator new(size, alignment, classHeap()), instancesOf(size));
         }
 
         // ========================================================================
@@ -104,29 +273,51 @@ namespace MEM_SENTRY::sentry {
         // ========================================================================
 
         void* operator new(size_t size, const std::nothrow_t& tag) noexcept {
-            checkHeap();
-            try { return ::operator new(size, pHeap); }
+            if(void* ptr = poolAllocate(size))
+                return counted(ptr);
+            try { return counted(::operator new(size, classHeap())); }
             catch(...) { return nullptr; }
         }
 
         void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
-            checkHeap();
-            try { return ::operator new(size, pHeap); }
+            try { return counted(::operator new(size, classHeap()), instancesOf(size)); }
             catch(...) { return nullptr; }
         }
 
         void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
-            checkHeap();
-            try { return ::operator new(size, alignment, pHeap); }
+            if(void* ptr = poolAllocate(size, (size_t)alignment))
+                return counted(ptr);
+            try { return counted(::operator new(size, alignment, classHeap())); }
             catch(...) { return nullptr; }
         }
 
         void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
-            checkHeap();
-            try { return ::operator new(size, alignment, pHeap); }
+            try { return counted(::operator new(size, alignment, classHeap()), instancesOf(size)); }
             catch(...) { return nullptr; }
         }
 
+        /// @brief Placement deletes: release the block when a constructor throws. The class
+        /// deletes hide the global ones, so without them the block would leak.
+        void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr);
+        }
+
+        void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+            uncountArray(ptr);
+            ::operator delete(ptr);
+        }
+
+        void operator delete(void* ptr, std::align_val_t al, const std::nothrow_t&) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr, al);
+        }
+
+        void operator delete[](void* ptr, std::align_val_t al, const std::nothrow_t&) noexcept {
+            uncountArray(ptr);
+            ::operator delete(ptr, al);
+        }
+
         // ========================================================================
         // RESTORATION (PASS-THROUGHS)
         // These operators are normally hidden when a class defines its own `new`.
@@ -152,18 +343,128 @@ namespace MEM_SENTRY::sentry {
          * Usage: `new (mySpecificHeap) T()`
          */
         void* operator new(size_t size, MEM_SENTRY::heap::Heap* h) {
-            return ::operator new(size, h);
+            return counted(::operator new(size, h));
         }
 
         /**
          * @brief Explicit Heap Override (Aligned).
          */
         void* operator new(size_t size, std::align_val_t al, MEM_SENTRY::heap::Heap* h) {
-            return ::operator new(size, al, h);
+            return counted(::operator new(size, al, h));
+        }
+
+        /// @brief Placement deletes of the heap overrides (a throwing constructor).
+        void operator delete(void* ptr, MEM_SENTRY::heap::Heap*) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr);
+        }
+
+        void operator delete(void* ptr, std::align_val_t al, MEM_SENTRY::heap::Heap*) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr, al);
+        }
+
+        // ========================================================================
+        // CALL SITE TAGGING
+        // `MS_NEW(heap) T(...)` (see sites.h); a null heap means the class heap.
+        // ========================================================================
+
+        void* operator new(size_t size, MEM_SENTRY::heap::Heap* h, MEM_SENTRY::sites::Site site) {
+            return counted(::operator new(size, h ? h : classHeap(), site));
+        }
+
+        void* operator new[](size_t size, MEM_SENTRY::heap::Heap* h, MEM_SENTRY::sites::Site site) {
+            return counted(::operator new[](size, h ? h : classHeap(), site), instancesOf(size));
+        }
+
+        void* operator new(size_t size, std::align_val_t al, MEM_SENTRY::heap::Heap* h, MEM_SENTRY::sites::Site site) {
+            return counted(::operator new(size, al, h ? h : classHeap(), site));
+        }
+
+        void* operator new[](size_t size, std::align_val_t al, MEM_SENTRY::heap::Heap* h, MEM_SENTRY::sites::Site site) {
+            return counted(::operator new[](size, al, h ? h : classHeap(), site), instancesOf(size));
+        }
+
+        /// @brief Placement deletes: release the block when a constructor throws.
+        void operator delete(void* ptr, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr);
+        }
+
+        void operator delete[](void* ptr, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+            uncountArray(ptr);
+            ::operator delete[](ptr);
+        }
+
+        void operator delete(void* ptr, std::align_val_t al, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+            uncount(ptr);
+            ::operator delete(ptr, al);
+        }
+
+        void operator delete[](void* ptr, std::align_val_t al, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+            uncountArray(ptr);
+            ::operator delete[](ptr, al);
+        }
+
+        // ========================================================================
+        // SIZED DEALLOCATION
+        // `size` is the static size of the deleted type (the dynamic one for ISentry).
+        // Arrays keep the unsized form: a sized delete[] would force an array cookie
+        // in front of trivial element arrays. They were allocated with the scalar
+        // global new, so they are released with the scalar global delete.
+        // ========================================================================
+
+        void operator delete(void* ptr, size_t size) noexcept {
+            uncount(ptr);
+            sentry_deallocate_sized(ptr, size);
+        }
+
+        void operator delete(void* ptr, size_t size, std::align_val_t) noexcept {
+            uncount(ptr);
+            sentry_deallocate_sized(ptr, size);
+        }
+
+        void operator delete[](void* ptr) noexcept {
+            uncountArray(ptr);
+            ::operator delete(ptr);
+        }
+
+        void operator delete[](void* ptr, std::align_val_t al) noexcept {
+            uncountArray(ptr);
+            ::operator delete(ptr, al);
         }
     };
 
+    /**
+     * @class ISentry
+     * @brief A CRTP base class that automates memory tracking for derived classes.
+     * 
+     * Inherit from this class to force all dynamic allocations (via `new`) of your object
+     * to be routed through the MEM_SENTRY memory system. It automatically manages 
+     * a static heap pointer unique to each derived class type.
+     *
+     * The polymorphic flavour of ISentryLite: same routing, plus a virtual destructor.
+     * A heap tag binds the heap at compile time: `class Voice : public ISentry<Voice, AudioHeapTag>`.
+     * 
+     * @tparam T The derived class type (Curiously Recurring Template Pattern).
+     * Example: class MyClass : public ISentry<MyClass> {};
+     */
+    template<typename T, typename Tag = void>
+    class ISentry : public ISentryLite<T, Tag> {
+    public:
+        /**
+         * @brief Virtual destructor.
+         * @note Adds a virtual table pointer (vptr) to the object
+         * 
+         * Required to ensure derived destructors are called correctly when deleting via ISentry*.
+         */
+        virtual ~ISentry() = default; 
+    };
+
     // Static member initialization
-    template<typename T>
-    MEM_SENTRY::heap::Heap* ISentry<T>::pHeap = nullptr;
+    template<typename T, typename Tag>
+    MEM_SENTRY::heap::Heap* ISentryLite<T, Tag>::pHeap = nullptr;
+
+    template<typename T, typename Tag>
+    MEM_SENTRY::pool::Pool* ISentryLite<T, Tag>::pPool = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,207 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::shared_stats {
+
+    /// @brief "MSST": identifies a MemSentry shared stats region.
+    constexpr uint32_t SHARED_STATS_MAGIC = 0x4D535354;
+
+    /// @brief Bumped whenever SharedStatsHeader or SharedHeapEntry change.
+    constexpr uint32_t SHARED_STATS_VERSION = 1;
+
+    /// @brief Room for an interned heap name (names are truncated to 99 characters).
+    constexpr size_t SHARED_NAME_SIZE = 100;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "shared stats need lock-free 64-bit atomics to be readable from another process");
+
+    /**
+     * @struct SharedHeapEntry
+     * @brief Counters of one heap, at index `heap id` of the shared region.
+     *
+     * Protected by a sequence lock: the publisher makes m_Sequence odd, updates the
+     * fields and makes it even again. Readers retry until they see the same even
+     * value before and after copying (see ReadHeapEntry()), so they never block
+     * the publisher and never see a half-written entry.
+     */
+    struct alignas(constants::CACHE_LINE_SIZE) SharedHeapEntry {
+        std::atomic<uint32_t> m_Sequence;
+
+        /// @brief 1 while the heap owning this id is alive.
+        std::atomic<uint32_t> m_Live;
+
+        std::atomic<int64_t> m_Bytes;
+        std::atomic<int64_t> m_Count;
+        std::atomic<uint64_t> m_AllocCount;
+        std::atomic<uint64_t> m_FreeCount;
+
+        char m_Name[SHARED_NAME_SIZE];
+    };
+
+    /**
+     * @struct SharedStatsHeader
+     * @brief Start of the shared region, followed by `m_MaxHeaps` SharedHeapEntry.
+     */
+    struct alignas(constants::CACHE_LINE_SIZE) SharedStatsHeader {
+        uint32_t m_Magic;
+        uint32_t m_Version;
+        uint32_t m_MaxHeaps;
+        uint32_t m_EntrySize;
+        uint32_t m_Pid;
+
+        /// @brief One past the highest heap id ever published; readers scan [0, m_SlotCount).
+        std::atomic<uint32_t> m_SlotCount;
+
+        /// @brief Number of completed publish passes.
+        std::atomic<uint64_t> m_Ticks;
+
+        /// @brief CLOCK_MONOTONIC time of the last pass, in nanoseconds.
+        std::atomic<uint64_t> m_UpdateNs;
+    };
+
+    /**
+     * @brief Plain copy of a SharedHeapEntry, as returned to readers.
+     */
+    struct SharedHeapStats {
+        bool m_Live;
+        int64_t m_Bytes;
+        int64_t m_Count;
+        uint64_t m_AllocCount;
+        uint64_t m_FreeCount;
+        char m_Name[SHARED_NAME_SIZE];
+    };
+
+    /**
+     * @brief Size in bytes of a shared region holding `maxHeaps` entries.
+     */
+    constexpr size_t RegionSize(size_t maxHeaps) noexcept {
+        return sizeof(SharedStatsHeader) + maxHeaps * sizeof(SharedHeapEntry);
+    }
+
+    /**
+     * @brief Entry array that follows the header.
+     */
+    inline SharedHeapEntry* Entries(SharedStatsHeader* header) noexcept {
+        return reinterpret_cast<SharedHeapEntry*>(header + 1);
+    }
+
+    inline const SharedHeapEntry* Entries(const SharedStatsHeader* header) noexcept {
+        return reinterpret_cast<const SharedHeapEntry*>(header + 1);
+    }
+
+    /**
+     * @brief Copies one entry consistently, without writing to the shared region.
+     * @return false if no consistent copy was seen after `maxRetries` attempts
+     * (e.g. the publisher died in the middle of an update).
+     */
+    inline bool ReadHeapEntry(const SharedHeapEntry& entry, SharedHeapStats& out, int maxRetries = 64) {
+        for (int attempt = 0; attempt < maxRetries; ++attempt) {
+            uint32_t before = entry.m_Sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+
+            out.m_Live = entry.m_Live.load(std::memory_order_relaxed) != 0;
+            out.m_Bytes = entry.m_Bytes.load(std::memory_order_relaxed);
+            out.m_Count = entry.m_Count.load(std::memory_order_relaxed);
+            out.m_AllocCount = entry.m_AllocCount.load(std::memory_order_relaxed);
+            out.m_FreeCount = entry.m_FreeCount.load(std::memory_order_relaxed);
+            std::memcpy(out.m_Name, entry.m_Name, SHARED_NAME_SIZE);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry.m_Sequence.load(std::memory_order_relaxed) == before) {
+                out.m_Name[SHARED_NAME_SIZE - 1] = '\0';
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @class SharedStatsPublisher
+     * @brief Publishes the counters of every heap into a POSIX shared memory region.
+     *
+     * Another process (e.g. `memsentry-top`) can map the region read-only and watch
+     * the heaps live: it never calls into this process, and its reads never block
+     * or slow down the publisher.
+     *
+     * Entries are indexed by heap id, so a pass only touches the cache lines of the
+     * heaps that exist. Publishing reads the same relaxed counters as GetTotal() /
+     * CountAllocations() and never takes a heap lock.
+     */
+    class SharedStatsPublisher {
+    private:
+        /** @brief Mapped region, nullptr until Open() succeeds. */
+        SharedStatsHeader* p_Region;
+
+        /** @brief Ids published by the current pass (MAX_HEAPS flags). */
+        uint8_t* p_Seen;
+
+        /** @brief shm object name, unlinked on Close(). */
+        char m_Name[64];
+
+        /** @brief Serializes PublishNow() between the caller and the background thread. */
+        std::mutex m_PublishMutex;
+
+        std::thread m_Thread;
+        std::atomic<bool> m_Stop;
+        std::mutex m_WaitMutex;
+        std::condition_variable m_WaitCv;
+
+        void loop(std::chrono::milliseconds interval);
+
+    public:
+        SharedStatsPublisher();
+
+        /**
+         * @brief Stops publishing and removes the shared region.
+         */
+        ~SharedStatsPublisher();
+
+        SharedStatsPublisher(const SharedStatsPublisher&) = delete;
+        SharedStatsPublisher& operator=(const SharedStatsPublisher&) = delete;
+
+        /**
+         * @brief Creates (or replaces) and maps the shared region.
+         * @param name shm object name such as "/memsentry.app"; nullptr uses
+         * "/memsentry.<pid>".
+         * @return false if the region could not be created.
+         */
+        bool Open(const char* name = nullptr);
+
+        /**
+         * @brief Stops publishing, unmaps and unlinks the region.
+         */
+        void Close();
+
+        /**
+         * @brief Name of the shm object (empty before Open()).
+         */
+        const char* GetName() const noexcept { return m_Name; }
+
+        /**
+         * @brief Writes the current counters of every heap into the region.
+         */
+        void PublishNow();
+
+        /**
+         * @brief Starts a background thread calling PublishNow() every `interval`.
+         * @return false if the region isn't open or the thread is already running.
+         */
+        bool Start(std::chrono::milliseconds interval);
+
+        /**
+         * @brief Stops the background thread (no-op if it isn't running).
+         */
+        void Stop();
+    };
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <source_location>
+#include <vector>
+
+#include "mem_sentry/constants.h"
+
+namespace MEM_SENTRY::sites {
+
+    /**
+     * @struct Site
+     * @brief Call site tag of a tracked allocation, passed to the MS_NEW operators.
+     */
+    struct Site {
+        /// @brief Interned site id (see Intern()), 0 for an unknown site.
+        uint32_t m_Id;
+    };
+
+    /**
+     * @struct SiteInfo
+     * @brief Source location of an interned site. The strings have static storage.
+     */
+    struct SiteInfo {
+        const char* m_File;
+        const char* m_Function;
+        uint32_t m_Line;
+        uint32_t m_Column;
+    };
+
+    /**
+     * @brief Returns the process-wide id of a source location, interning it on first use.
+     *
+     * The table is lock-free (open addressing, claimed with a CAS) and keyed by line,
+     * column and file, so the same location compiled in several translation units
+     * gets one id. Only the id is stored in the allocation header.
+     *
+     * @return uint32_t The id (1 based), 0 if the `SITE_TABLE_SIZE` entries are all taken.
+     */
+    uint32_t Intern(const std::source_location& location) noexcept;
+
+    /**
+     * @brief Source location of a site id, nullptr for 0 or an unknown id.
+     */
+    const SiteInfo* Lookup(uint32_t id) noexcept;
+
+    /**
+     * @brief Site of the caller: the default argument is evaluated where Here() is called.
+     */
+    inline Site Here(const std::source_location& location = std::source_location::current()) noexcept {
+    #if MEM_SENTRY_ENABLE
+        return Site{Intern(location)};
+    #else
+        (void)location;
+        return Site{0};
+    #endif
+    }
+
+    /**
+     * @struct SiteEntry
+     * @brief Aggregated live allocations of one call site.
+     */
+    struct SiteEntry {
+        /// @brief Site id, 0 groups the untagged allocations.
+        uint32_t m_SiteId;
+
+        uint32_t m_Count;
+
+        /// @brief Bytes accounted by the heap (user size + alignment padding).
+        uint64_t m_Bytes;
+    };
+
+    /**
+     * @class SiteSummary
+     * @brief Live allocations of one heap grouped by call site, largest first.
+     * Produced by `Heap::SummarizeSites()`.
+     */
+    class SiteSummary {
+    private:
+        const char* m_name;
+
+        std::vector<SiteEntry> m_Entries;
+
+        uint64_t m_TotalCount;
+
+        uint64_t m_TotalBytes;
+
+    public:
+        /**
+         * @param heapName Interned heap name, not copied.
+         */
+        explicit SiteSummary(const char* heapName);
+
+        /**
+         * @brief Builds the sorted entry list from per-site accumulators.
+         * @param counts Array of `SITE_TABLE_SIZE + 1` counters indexed by site id.
+         * @param bytes Array of `SITE_TABLE_SIZE + 1` byte accumulators indexed by site id.
+         */
+        void Assign(const uint32_t* counts, const uint64_t* bytes);
+
+        const char* GetHeapName() const noexcept { return m_name; }
+
+        const std::vector<SiteEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        uint64_t GetTotalCount() const noexcept { return m_TotalCount; }
+
+        uint64_t GetTotalBytes() const noexcept { return m_TotalBytes; }
+
+        /**
+         * @brief Prints the summary as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+};
+
+/**
+ * @brief Tracked `new` that records the call site in the allocation header.
+ * Usage: `MS_NEW(&audioHeap) Voice(args)`, `MS_NEW(nullptr) char[64]` (current heap).
+ */
+#define MS_NEW(heap) new ((heap), MEM_SENTRY::sites::Here())
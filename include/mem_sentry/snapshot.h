@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace MEM_SENTRY::snapshot {
+
+    /**
+     * @struct SnapshotEntry
+     * @brief Aggregated live allocations of one size class.
+     *
+     * A size class groups every allocation whose user size falls into
+     * `(2^(m_SizeClass - 1), 2^m_SizeClass]`, so a whole heap collapses into
+     * at most 33 entries.
+     */
+    struct SnapshotEntry {
+        /// @brief log2 bucket of the user size (upper bound is `1 << m_SizeClass`).
+        uint32_t m_SizeClass;
+
+        /// @brief Number of live allocations in this bucket.
+        uint32_t m_Count;
+
+        /// @brief Bytes accounted by the heap (user size + alignment padding).
+        uint64_t m_Bytes;
+    };
+
+    /**
+     * @struct DiffEntry
+     * @brief Signed change of one size class between two snapshots.
+     */
+    struct DiffEntry {
+        uint32_t m_SizeClass;
+        int64_t m_CountDelta;
+        int64_t m_BytesDelta;
+    };
+
+    /**
+     * @brief Returns the size class (log2 bucket) for a user size.
+     */
+    constexpr uint32_t SizeClassOf(uint32_t size) noexcept {
+        uint32_t sizeClass = 0;
+        while (sizeClass < 32 && (uint64_t(1) << sizeClass) < size) {
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+
+    /**
+     * @class HeapSnapshot
+     * @brief Compact, sorted picture of the live allocations of one Heap.
+     *
+     * Produced by `Heap::Snapshot()`. Entries are sorted by size class and only
+     * non-empty classes are stored.
+     *
+     * @note The snapshot is taken incrementally (see `Heap::Snapshot()`), so it is
+     * not an atomic picture of the heap: it contains every allocation that was live
+     * when the snapshot started and was still live when the walk reached it.
+     */
+    class HeapSnapshot {
+    private:
+        /** @brief Interned name of the heap this snapshot was taken from. */
+        const char* m_name;
+
+        /** @brief Non-empty size classes, sorted ascending. */
+        std::vector<SnapshotEntry> m_Entries;
+
+        /** @brief Sum of all entry counts. */
+        uint64_t m_TotalCount;
+
+        /** @brief Sum of all entry bytes. */
+        uint64_t m_TotalBytes;
+
+    public:
+        /**
+         * @param heapName Heap name, interned (see registry::InternName()) so the
+         * snapshot never points at the caller's string.
+         */
+        explicit HeapSnapshot(const char* heapName);
+
+        /**
+         * @brief Builds the sorted entry list from per-class accumulators.
+         * @param counts Array of 33 counters indexed by size class.
+         * @param bytes Array of 33 byte accumulators indexed by size class.
+         */
+        void Assign(const uint32_t* counts, const uint64_t* bytes);
+
+        const char* GetHeapName() const noexcept { return m_name; }
+
+        const std::vector<SnapshotEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        uint64_t GetTotalCount() const noexcept { return m_TotalCount; }
+
+        uint64_t GetTotalBytes() const noexcept { return m_TotalBytes; }
+
+        /**
+         * @brief Prints the snapshot as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+
+    /**
+     * @class HeapSnapshotDiff
+     * @brief Per size class difference between two snapshots of the same heap.
+     *
+     * Only size classes whose count or bytes changed are stored.
+     */
+    class HeapSnapshotDiff {
+    private:
+        const char* m_name;
+
+        std::vector<DiffEntry> m_Entries;
+
+        int64_t m_CountDelta;
+
+        int64_t m_BytesDelta;
+
+    public:
+        /**
+         * @brief Computes `after - before` with a merge join over the sorted entries.
+         * @note Both snapshots are expected to come from the same heap; the diff is
+         * named after `after`.
+         */
+        HeapSnapshotDiff(const HeapSnapshot& before, const HeapSnapshot& after);
+
+        const char* GetHeapName() const noexcept { return m_name; }
+
+        const std::vector<DiffEntry>& GetEntries() const noexcept { return m_Entries; }
+
+        int64_t GetCountDelta() const noexcept { return m_CountDelta; }
+
+        int64_t GetBytesDelta() const noexcept { return m_BytesDelta; }
+
+        /**
+         * @brief Prints the diff as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+
+    /**
+     * @brief Convenience wrapper around the `HeapSnapshotDiff` constructor.
+     */
+    inline HeapSnapshotDiff Diff(const HeapSnapshot& before, const HeapSnapshot& after) {
+        return HeapSnapshotDiff(before, after);
+    }
+};
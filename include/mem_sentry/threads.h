@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "mem_sentry/alloc_header.h"
+
+namespace MEM_SENTRY::threads {
+
+    /**
+     * @struct ThreadStats
+     * @brief Allocation counters of one thread, across all heaps.
+     */
+    struct ThreadStats {
+        /// @brief Index stored in AllocHeader::m_ThreadIndex (1 based, 0 groups the threads past the table).
+        uint16_t m_Index;
+
+        /// @brief Kernel thread id of the thread, 0 for the shared entry.
+        int32_t m_Tid;
+
+        /// @brief Tracked blocks allocated by the thread.
+        uint64_t m_Allocs;
+
+        /// @brief Tracked blocks freed by the thread, whoever allocated them.
+        uint64_t m_Frees;
+
+        /// @brief User bytes allocated by the thread (resizes included).
+        uint64_t m_AllocatedBytes;
+
+        /// @brief User bytes freed by the thread (resizes included).
+        uint64_t m_FreedBytes;
+
+        /// @brief Frees, by this thread, of blocks another thread allocated.
+        uint64_t m_RemoteFrees;
+
+        /// @brief Blocks allocated by this thread and freed by another one.
+        uint64_t m_FreedRemotely;
+    };
+
+    /// @brief Value of tThreadIndex before the thread's first tracked allocation.
+    constexpr uint16_t UNASSIGNED = UINT16_MAX;
+
+    /// @brief Index of the calling thread, UNASSIGNED until it is first needed.
+    /// constinit + initial-exec: reading it is a single TLS load.
+    extern constinit thread_local __attribute__((tls_model("initial-exec"))) uint16_t tThreadIndex;
+
+    /**
+     * @brief Gives the calling thread the next free index (0 once `THREAD_MAX_THREADS` are taken).
+     * Indexes are never reused: the counters of a finished thread stay readable.
+     */
+    uint16_t Assign() noexcept;
+
+    /**
+     * @brief Index stamped into the blocks allocated by the calling thread.
+     */
+    inline uint16_t Current() noexcept {
+        uint16_t index = tThreadIndex;
+        return index != UNASSIGNED ? index : Assign();
+    }
+
+    /**
+     * @brief Counts a new block on the thread in its header. Lock-free.
+     */
+    void OnAlloc(const alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Counts the free of a block on the calling thread, and a remote free if another thread allocated it.
+     */
+    void OnFree(const alloc_header::AllocHeader* header) noexcept;
+
+    /**
+     * @brief Counts the growth (or shrink) of a block resized from `oldSize` on the calling thread.
+     */
+    void OnResize(const alloc_header::AllocHeader* header, uint32_t oldSize) noexcept;
+
+    /**
+     * @brief Entries in use, indexes `0 .. Count() - 1` (the shared entry 0 is always counted).
+     */
+    uint32_t Count() noexcept;
+
+    /**
+     * @brief Current counters of a thread. Each one is read atomically, not all of them together.
+     * Doesn't allocate, so it can be used from reporters.
+     */
+    ThreadStats GetStats(uint16_t index) noexcept;
+
+    /**
+     * @brief Moves the calling thread to SCHED_BATCH with a `THREAD_BACKGROUND_NICE` nice value.
+     *
+     * Used by the background threads (scrubber, leak detector). They take heap locks, and
+     * std::mutex has no priority inheritance: under SCHED_IDLE a loaded CPU could starve
+     * them while they hold one, blocking every thread allocating on that heap. Batch
+     * threads keep a fair, if small, share of the CPU. Best effort: failures are ignored.
+     */
+    void LowerPriority() noexcept;
+
+    /**
+     * @class ThreadSnapshot
+     * @brief Counters of every thread that allocated or freed a tracked block, busiest first.
+     *
+     * @code
+     * MEM_SENTRY::threads::ThreadSnapshot::Take().Dump();
+     * @endcode
+     */
+    class ThreadSnapshot {
+    private:
+        std::vector<ThreadStats> m_Entries;
+
+        uint64_t m_TotalAllocs;
+
+        uint64_t m_TotalFrees;
+
+        uint64_t m_TotalRemoteFrees;
+
+        ThreadSnapshot();
+
+    public:
+        /**
+         * @brief Reads the counters of every thread, sorted by allocated bytes.
+         */
+        static ThreadSnapshot Take();
+
+        const std::vector<ThreadStats>& GetEntries() const noexcept { return m_Entries; }
+
+        /**
+         * @brief Entry of a thread index, nullptr if the thread has no activity.
+         */
+        const ThreadStats* Find(uint16_t index) const noexcept;
+
+        uint64_t GetTotalAllocs() const noexcept { return m_TotalAllocs; }
+
+        uint64_t GetTotalFrees() const noexcept { return m_TotalFrees; }
+
+        uint64_t GetTotalRemoteFrees() const noexcept { return m_TotalRemoteFrees; }
+
+        /**
+         * @brief Share of the frees made on another thread than the allocating one (0 to 1).
+         */
+        double GetRemoteFreeRatio() const noexcept {
+            return m_TotalFrees ? (double)m_TotalRemoteFrees / (double)m_TotalFrees : 0.0;
+        }
+
+        /**
+         * @brief Prints the snapshot as a plain-text table.
+         * @param out Destination stream (stdout by default).
+         */
+        void Dump(std::FILE* out = stdout) const;
+    };
+};
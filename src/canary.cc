@@ -0,0 +1,109 @@
+#include <atomic>
+#include <chrono>
+
+#include "mem_sentry/canary.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/guard_pages.h"
+#include "mem_sentry/poison.h"
+
+namespace {
+    std::atomic<size_t> gCanarySize{MEM_SENTRY::constants::CANARY_DEFAULT_SIZE};
+    std::atomic<uint32_t> gSeedStreams{0};
+
+    /**
+     * @brief xorshift32 state, seeded per thread from the clock and a stream counter.
+     */
+    struct SeedState {
+        uint32_t m_State = 0;
+
+        uint32_t next() {
+            if (!m_State) {
+                uint64_t ticks = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+                uint32_t stream = gSeedStreams.fetch_add(0x9E3779B9u, std::memory_order_relaxed);
+                m_State = (uint32_t)(ticks ^ (ticks >> 32)) ^ stream ^ (uint32_t)(uintptr_t)this;
+                if (!m_State) m_State = 0x2545F491u;
+            }
+
+            m_State ^= m_State << 13;
+            m_State ^= m_State >> 17;
+            m_State ^= m_State << 5;
+            return m_State;
+        }
+    };
+
+    thread_local SeedState tSeed;
+
+    const unsigned char* frontCanary(const MEM_SENTRY::alloc_header::AllocHeader* header) {
+        return (const unsigned char*)header - header->m_CanarySize;
+    }
+
+    const unsigned char* backCanary(const MEM_SENTRY::alloc_header::AllocHeader* header) {
+        return (const unsigned char*)(header + 1) + header->m_Size;
+    }
+}
+
+const char* MEM_SENTRY::canary::StatusName(Status status) noexcept {
+    switch (status) {
+        case Status::Ok:           return "ok";
+        case Status::BadSignature: return "header signature overwritten";
+        case Status::FrontCanary:  return "front canary overwritten (underflow)";
+        case Status::BackCanary:   return "back canary overwritten (overflow)";
+        case Status::GuardSlack:   return "guard slack overwritten (overflow)";
+    }
+    return "unknown";
+}
+
+void MEM_SENTRY::canary::SetCanarySize(size_t bytes) noexcept {
+    bytes = (bytes + 15) & ~size_t(15);
+    if (bytes > constants::CANARY_MAX_SIZE) bytes = constants::CANARY_MAX_SIZE;
+
+    gCanarySize.store(bytes, std::memory_order_relaxed);
+}
+
+size_t MEM_SENTRY::canary::GetCanarySize() noexcept {
+    return gCanarySize.load(std::memory_order_relaxed);
+}
+
+uint32_t MEM_SENTRY::canary::NextSeed() noexcept {
+    uint32_t seed;
+    do {
+        seed = tSeed.next();
+    } while (!seed);
+    return seed;
+}
+
+void MEM_SENTRY::canary::Write(alloc_header::AllocHeader* header) noexcept {
+    if (!header->m_CanarySize) {
+        return;
+    }
+
+    poison::Fill32((void*)frontCanary(header), header->m_CanarySize, header->m_CanarySeed);
+    // the back canary uses the complemented value, so a block copied over its
+    // neighbour's front canary doesn't go unnoticed.
+    poison::Fill32((void*)backCanary(header), header->m_CanarySize, ~header->m_CanarySeed);
+}
+
+MEM_SENTRY::canary::Status MEM_SENTRY::canary::Check(const alloc_header::AllocHeader* header) noexcept {
+    if (header->m_Signature != (uint32_t)constants::MEMSYSTEM_SIGNATURE) {
+        return Status::BadSignature;
+    }
+
+    guard::GuardMode guardMode = (guard::GuardMode)(header->m_Flags & alloc_header::ALLOC_FLAG_GUARD_MASK);
+    if (guardMode != guard::GuardMode::None) {
+        return guard::CheckSlack(header + 1, header->m_Size, guardMode) ? Status::Ok : Status::GuardSlack;
+    }
+
+    if (header->m_CanarySize > constants::CANARY_MAX_SIZE) {
+        return Status::BadSignature;
+    }
+
+    if (poison::Verify32(frontCanary(header), header->m_CanarySize, header->m_CanarySeed) != header->m_CanarySize) {
+        return Status::FrontCanary;
+    }
+
+    if (poison::Verify32(backCanary(header), header->m_CanarySize, ~header->m_CanarySeed) != header->m_CanarySize) {
+        return Status::BackCanary;
+    }
+
+    return Status::Ok;
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+
+#include "mem_sentry/census.h"
+#include "mem_sentry/alloc_header.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/interpose.h"
+
+namespace {
+    /**
+     * @struct TypeSlot
+     * @brief Counters of one type, on their own cache line: types are updated by any thread.
+     */
+    struct alignas(MEM_SENTRY::constants::CACHE_LINE_SIZE) TypeSlot {
+        /// @brief Set once the type is registered (entry 0 is the overflow entry).
+        std::atomic<const char*> p_Name{nullptr};
+
+        std::atomic<uint64_t> m_Live{0};
+        std::atomic<uint64_t> m_Bytes{0};
+        std::atomic<uint64_t> m_PeakBytes{0};
+    };
+
+    constinit TypeSlot gTypes[MEM_SENTRY::constants::CENSUS_MAX_TYPES];
+
+    /// @brief Next free entry; entry 0 collects the types registered past the table size.
+    constinit std::atomic<uint32_t> gTypeCount{1};
+
+    constexpr const char* OVERFLOW_NAME = "(other types)";
+
+    uint32_t blockSize(const void* block) {
+        return ((const MEM_SENTRY::alloc_header::AllocHeader*)block - 1)->m_Size;
+    }
+}
+
+uint32_t MEM_SENTRY::census::RegisterType(const char* mangledName) {
+    uint32_t id = gTypeCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (id >= constants::CENSUS_MAX_TYPES) {
+        gTypes[0].p_Name.store(OVERFLOW_NAME, std::memory_order_release);
+        return 0;
+    }
+
+    int status = 0;
+    char* name;
+    {
+        interpose::BypassScope bypass;
+        name = abi::__cxa_demangle(mangledName, nullptr, nullptr, &status);
+    }
+
+    // the demangled name lives as long as the process; keep the mangled one if it fails.
+    gTypes[id].p_Name.store(status == 0 && name ? name : mangledName, std::memory_order_release);
+    return id;
+}
+
+void MEM_SENTRY::census::OnAlloc(uint32_t typeId, const void* block, uint64_t instances) noexcept {
+    TypeSlot& slot = gTypes[typeId];
+    uint64_t size = blockSize(block);
+
+    slot.m_Live.fetch_add(instances, std::memory_order_relaxed);
+    uint64_t bytes = slot.m_Bytes.fetch_add(size, std::memory_order_relaxed) + size;
+
+    uint64_t peak = slot.m_PeakBytes.load(std::memory_order_relaxed);
+    while (bytes > peak && !slot.m_PeakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+void MEM_SENTRY::census::OnFree(uint32_t typeId, const void* block, uint64_t instances) noexcept {
+    TypeSlot& slot = gTypes[typeId];
+
+    slot.m_Live.fetch_sub(instances, std::memory_order_relaxed);
+    slot.m_Bytes.fetch_sub(blockSize(block), std::memory_order_relaxed);
+}
+
+MEM_SENTRY::census::TypeCensus::TypeCensus() : m_TotalLive(0), m_TotalBytes(0) {
+}
+
+MEM_SENTRY::census::TypeCensus MEM_SENTRY::census::TypeCensus::Take() {
+    TypeCensus census;
+
+    uint32_t count = gTypeCount.load(std::memory_order_relaxed);
+    if (count > constants::CENSUS_MAX_TYPES) {
+        count = constants::CENSUS_MAX_TYPES;
+    }
+
+    census.m_Entries.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const char* name = gTypes[i].p_Name.load(std::memory_order_acquire);
+        uint64_t peak = gTypes[i].m_PeakBytes.load(std::memory_order_relaxed);
+
+        if (!name || !peak) {
+            continue;
+        }
+
+        TypeEntry entry{name,
+            gTypes[i].m_Live.load(std::memory_order_relaxed),
+            gTypes[i].m_Bytes.load(std::memory_order_relaxed),
+            peak};
+
+        census.m_Entries.push_back(entry);
+        census.m_TotalLive += entry.m_Live;
+        census.m_TotalBytes += entry.m_Bytes;
+    }
+
+    std::sort(census.m_Entries.begin(), census.m_Entries.end(), [](const TypeEntry& a, const TypeEntry& b) {
+        return a.m_Bytes != b.m_Bytes ? a.m_Bytes > b.m_Bytes : a.m_PeakBytes > b.m_PeakBytes;
+    });
+
+    return census;
+}
+
+const MEM_SENTRY::census::TypeEntry* MEM_SENTRY::census::TypeCensus::Find(const char* name) const noexcept {
+    for (const TypeEntry& entry : m_Entries) {
+        if (std::strcmp(entry.m_Name, name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void MEM_SENTRY::census::TypeCensus::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Type Census ===\n");
+    std::fprintf(out, "%-32s %12s %16s %16s\n", "Type", "Live", "Bytes", "Peak Bytes");
+
+    for (const TypeEntry& entry : m_Entries) {
+        std::fprintf(out, "%-32s %12" PRIu64 " %16" PRIu64 " %16" PRIu64 "\n",
+            entry.m_Name, entry.m_Live, entry.m_Bytes, entry.m_PeakBytes);
+    }
+
+    std::fprintf(out, "%-32s %12" PRIu64 " %16" PRIu64 "\n", "Total", m_TotalLive, m_TotalBytes);
+}
@@ -1,11 +1,17 @@
 #include "mem_sentry/reporter.h"
 #include "mem_sentry/heap.h"
+#include "mem_sentry/registry.h"
+#include "mem_sentry/sites.h"
+#include "mem_sentry/threads.h"
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 
 
 void MEM_SENTRY::reporter::ConsoleReporter::onAlloc(alloc_header::AllocHeader* alloc) {
-    if (!alloc || !alloc->p_Heap) return;
+    heap::Heap* pHeap = alloc ? registry::HeapOf(alloc) : nullptr;
+    if (!pHeap) return;
 
     const char* CLR_BORDER = "\033[36m";   // Cyan
     const char* CLR_LABEL  = "\033[1;37m"; // Bold White
@@ -24,7 +30,7 @@ void MEM_SENTRY::reporter::ConsoleReporter::onAlloc(alloc_header::AllocHeader* a
 
     std::printf("%s║%s Heap:           %s%-38s %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
-        alloc->p_Heap->GetName(), CLR_BORDER, CLR_RESET);
+        pHeap->GetName(), CLR_BORDER, CLR_RESET);
 
     std::printf("%s║%s Size:           %s%-6d bytes (Align: %-2d)        %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
@@ -33,7 +39,7 @@ void MEM_SENTRY::reporter::ConsoleReporter::onAlloc(alloc_header::AllocHeader* a
 
     std::printf("%s║%s Heap Total:     %s%-38d %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
-        alloc->p_Heap->GetTotal(), CLR_BORDER, CLR_RESET);
+        pHeap->GetTotal(), CLR_BORDER, CLR_RESET);
 
     std::cout << CLR_BORDER
               << "╚═════════════════════════════════════════════════════════╝"
@@ -41,7 +47,8 @@ void MEM_SENTRY::reporter::ConsoleReporter::onAlloc(alloc_header::AllocHeader* a
 }
 
 void MEM_SENTRY::reporter::ConsoleReporter::onDealloc(alloc_header::AllocHeader* alloc) {
-    if (!alloc || !alloc->p_Heap) return;
+    heap::Heap* pHeap = alloc ? registry::HeapOf(alloc) : nullptr;
+    if (!pHeap) return;
 
     const char* CLR_BORDER = "\033[36m";   // Cyan
     const char* CLR_LABEL  = "\033[1;37m"; // Bold White
@@ -60,7 +67,7 @@ void MEM_SENTRY::reporter::ConsoleReporter::onDealloc(alloc_header::AllocHeader*
 
     std::printf("%s║%s Heap:           %s%-38s %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
-        alloc->p_Heap->GetName(), CLR_BORDER, CLR_RESET);
+        pHeap->GetName(), CLR_BORDER, CLR_RESET);
 
     std::printf("%s║%s Freed:          %s%-6d bytes (Align: %-2d)        %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
@@ -69,7 +76,7 @@ void MEM_SENTRY::reporter::ConsoleReporter::onDealloc(alloc_header::AllocHeader*
 
     std::printf("%s║%s Heap Total:     %s%-38d %s║%s\n",
         CLR_BORDER, CLR_LABEL, CLR_VAL,
-        alloc->p_Heap->GetTotal(), CLR_BORDER, CLR_RESET);
+        pHeap->GetTotal(), CLR_BORDER, CLR_RESET);
 
     std::cout << CLR_BORDER
               << "╚═════════════════════════════════════════════════════════╝"
@@ -96,10 +103,14 @@ void MEM_SENTRY::reporter::ConsoleReporter::report(alloc_header::AllocHeader* p_
         CLR_BORDER, CLR_LABEL, "Signature:", CLR_VAL, p_Alloc->m_Signature, CLR_BORDER, CLR_RESET);
 
     // Heap Info
-    const char* heapName = p_Alloc->p_Heap ? p_Alloc->p_Heap->GetName() : "ORPHANED/UNKNOWN";
+    heap::Heap* pHeap = registry::HeapOf(p_Alloc);
+    const char* heapName = pHeap ? pHeap->GetName() : "ORPHANED/UNKNOWN";
     std::printf("%s║%s %-15s %s%-38s %s║%s\n", 
         CLR_BORDER, CLR_LABEL, "Heap Name:", CLR_VAL, heapName, CLR_BORDER, CLR_RESET);
 
+    std::printf("%s║%s %-15s %s%-38d %s║%s\n", 
+        CLR_BORDER, CLR_LABEL, "Heap Id:", CLR_VAL, p_Alloc->m_HeapId, CLR_BORDER, CLR_RESET);
+
     std::cout << CLR_BORDER << "╠----------------------------------------------------------╣" << CLR_RESET << "\n";
 
     // Size Info
@@ -119,11 +130,29 @@ void MEM_SENTRY::reporter::ConsoleReporter::report(alloc_header::AllocHeader* p_
     std::printf("%s║%s %-15s %s%p                           %s║%s\n", 
         CLR_BORDER, CLR_LABEL, "Raw Address:", CLR_VAL, p_Alloc->p_OriginalAddress, CLR_BORDER, CLR_RESET);
 
+    // Call Site Info (MS_NEW allocations)
+    if (const sites::SiteInfo* site = sites::Lookup(p_Alloc->m_SiteId)) {
+        const char* file = std::strrchr(site->m_File, '/');
+        char location[64];
+        std::snprintf(location, sizeof(location), "%s:%u", file ? file + 1 : site->m_File, site->m_Line);
+
+        std::printf("%s║%s %-15s %s%-38.38s %s║%s\n",
+            CLR_BORDER, CLR_LABEL, "Call Site:", CLR_VAL, location, CLR_BORDER, CLR_RESET);
+    }
+
+    // Thread Info (allocating thread)
+    threads::ThreadStats thread = threads::GetStats(p_Alloc->m_ThreadIndex);
+    char threadLabel[48];
+    std::snprintf(threadLabel, sizeof(threadLabel), "#%u (tid %d)", (unsigned)p_Alloc->m_ThreadIndex, (int)thread.m_Tid);
+
+    std::printf("%s║%s %-15s %s%-38.38s %s║%s\n",
+        CLR_BORDER, CLR_LABEL, "Thread:", CLR_VAL, threadLabel, CLR_BORDER, CLR_RESET);
+
     // Footer with Heap Total
-    if (p_Alloc->p_Heap) {
+    if (pHeap) {
         std::cout << CLR_BORDER << "╠----------------------------------------------------------╣" << CLR_RESET << "\n";
         std::printf("%s║%s %-15s %s%-31d bytes %s║%s\n", 
-            CLR_BORDER, CLR_LABEL, "Heap Total Now:", CLR_VAL, p_Alloc->p_Heap->GetTotal(), CLR_BORDER, CLR_RESET);
+            CLR_BORDER, CLR_LABEL, "Heap Total Now:", CLR_VAL, pHeap->GetTotal(), CLR_BORDER, CLR_RESET);
     }
 
     std::cout << CLR_BORDER << "╚══════════════════════════════════════════════════════════╝" << CLR_RESET << "\n" << std::endl;
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "mem_sentry/context.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/interpose.h"
+
+constinit thread_local uint16_t MEM_SENTRY::context::tContextId = 0;
+
+namespace {
+    /**
+     * @struct ContextSlot
+     * @brief Counters of one context, on their own cache line: any thread updates them.
+     */
+    struct alignas(MEM_SENTRY::constants::CACHE_LINE_SIZE) ContextSlot {
+        std::atomic<const char*> p_Name{nullptr};
+
+        std::atomic<uint64_t> m_Scopes{0};
+        std::atomic<uint64_t> m_Allocs{0};
+        std::atomic<uint64_t> m_Allocated{0};
+        std::atomic<uint64_t> m_Retained{0};
+        std::atomic<uint64_t> m_Peak{0};
+    };
+
+    /// @brief Index 0 is "no context" and is never counted.
+    constinit ContextSlot gContexts[MEM_SENTRY::constants::CONTEXT_MAX_CONTEXTS + 1];
+
+    constinit uint32_t gContextCount = 0;
+
+    /// @brief Serializes registration only; the counters are lock-free.
+    std::mutex gRegisterLock;
+
+    void raisePeak(ContextSlot& slot, uint64_t retained) {
+        uint64_t peak = slot.m_Peak.load(std::memory_order_relaxed);
+        while (retained > peak && !slot.m_Peak.compare_exchange_weak(peak, retained, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+uint16_t MEM_SENTRY::context::Register(const char* name) {
+    std::lock_guard<std::mutex> lock(gRegisterLock);
+
+    for (uint32_t id = 1; id <= gContextCount; ++id) {
+        if (std::strcmp(gContexts[id].p_Name.load(std::memory_order_relaxed), name) == 0) {
+            return (uint16_t)id;
+        }
+    }
+
+    if (gContextCount == constants::CONTEXT_MAX_CONTEXTS) {
+        std::printf("Error: cannot register more than %zu allocation contexts\n", constants::CONTEXT_MAX_CONTEXTS);
+        return 0;
+    }
+
+    size_t length = std::strlen(name) + 1;
+    char* copy = (char*) interpose::UntrackedMalloc(length);
+
+    if (!copy) {
+        return 0;
+    }
+
+    std::memcpy(copy, name, length);
+
+    uint32_t id = ++gContextCount;
+    gContexts[id].p_Name.store(copy, std::memory_order_release);
+
+    return (uint16_t)id;
+}
+
+void MEM_SENTRY::context::OnAlloc(const alloc_header::AllocHeader* header) noexcept {
+    if (!header->m_ContextId) {
+        return;
+    }
+
+    ContextSlot& slot = gContexts[header->m_ContextId];
+
+    slot.m_Allocs.fetch_add(1, std::memory_order_relaxed);
+    slot.m_Allocated.fetch_add(header->m_Size, std::memory_order_relaxed);
+    raisePeak(slot, slot.m_Retained.fetch_add(header->m_Size, std::memory_order_relaxed) + header->m_Size);
+}
+
+void MEM_SENTRY::context::OnFree(const alloc_header::AllocHeader* header) noexcept {
+    if (!header->m_ContextId) {
+        return;
+    }
+
+    gContexts[header->m_ContextId].m_Retained.fetch_sub(header->m_Size, std::memory_order_relaxed);
+}
+
+void MEM_SENTRY::context::OnResize(const alloc_header::AllocHeader* header, uint32_t oldSize) noexcept {
+    if (!header->m_ContextId || header->m_Size == oldSize) {
+        return;
+    }
+
+    ContextSlot& slot = gContexts[header->m_ContextId];
+
+    if (header->m_Size > oldSize) {
+        uint64_t grown = header->m_Size - oldSize;
+        slot.m_Allocated.fetch_add(grown, std::memory_order_relaxed);
+        raisePeak(slot, slot.m_Retained.fetch_add(grown, std::memory_order_relaxed) + grown);
+    } else {
+        slot.m_Retained.fetch_sub(oldSize - header->m_Size, std::memory_order_relaxed);
+    }
+}
+
+MEM_SENTRY::context::ContextStats MEM_SENTRY::context::GetStats(uint16_t id) noexcept {
+    if (id == 0 || id > constants::CONTEXT_MAX_CONTEXTS) {
+        return ContextStats{};
+    }
+
+    const ContextSlot& slot = gContexts[id];
+
+    return ContextStats{
+        slot.p_Name.load(std::memory_order_acquire),
+        slot.m_Scopes.load(std::memory_order_relaxed),
+        slot.m_Allocs.load(std::memory_order_relaxed),
+        slot.m_Allocated.load(std::memory_order_relaxed),
+        slot.m_Retained.load(std::memory_order_relaxed),
+        slot.m_Peak.load(std::memory_order_relaxed)
+    };
+}
+
+void MEM_SENTRY::context::Dump(std::FILE* out) {
+    ContextStats stats[constants::CONTEXT_MAX_CONTEXTS];
+    size_t count = 0;
+
+    for (uint32_t id = 1; id <= constants::CONTEXT_MAX_CONTEXTS; ++id) {
+        ContextStats entry = GetStats((uint16_t)id);
+        if (!entry.m_Name) break;
+        stats[count++] = entry;
+    }
+
+    std::sort(stats, stats + count, [](const ContextStats& a, const ContextStats& b) {
+        return a.m_Peak > b.m_Peak;
+    });
+
+    std::fprintf(out, "=== Allocation Contexts ===\n");
+    std::fprintf(out, "%-24s %10s %12s %16s %16s %16s\n", "Context", "Scopes", "Allocs", "Allocated", "Retained", "Peak");
+
+    for (size_t i = 0; i < count; ++i) {
+        std::fprintf(out, "%-24s %10" PRIu64 " %12" PRIu64 " %16" PRIu64 " %16" PRIu64 " %16" PRIu64 "\n",
+            stats[i].m_Name, stats[i].m_Scopes, stats[i].m_Allocs, stats[i].m_Allocated, stats[i].m_Retained, stats[i].m_Peak);
+    }
+}
+
+MEM_SENTRY::context::ContextScope::ContextScope(uint16_t id) noexcept : m_Previous(tContextId) {
+    // the hooks index the table with the current id unchecked: never let a bad one in.
+    if (id > constants::CONTEXT_MAX_CONTEXTS) {
+        id = 0;
+    }
+
+    if (id) {
+        gContexts[id].m_Scopes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    tContextId = id;
+}
@@ -0,0 +1,165 @@
+#include <cstdlib>
+#include <mutex>
+
+#include "mem_sentry/epoch.h"
+#include "mem_sentry/constants.h"
+
+namespace {
+    /**
+     * @brief Per-thread reader slot, one cache line each to avoid false sharing.
+     * m_Epoch == 0 means the owning thread is outside any guard.
+     */
+    struct alignas(MEM_SENTRY::constants::CACHE_LINE_SIZE) ReaderSlot {
+        std::atomic<uint64_t> m_Epoch{0};
+        std::atomic<bool> m_Used{false};
+    };
+
+    /**
+     * @brief Retired block waiting for readers, allocated with malloc.
+     */
+    struct RetiredNode {
+        void* p_Block;
+        void (*p_Deleter)(void*);
+        uint64_t m_Epoch;
+        RetiredNode* p_Next;
+    };
+
+    ReaderSlot g_Slots[MEM_SENTRY::constants::MAX_EPOCH_READERS];
+
+    /// @brief global epoch, starts at 1 so 0 can mean "inactive".
+    std::atomic<uint64_t> g_Epoch{1};
+
+    /// @brief readers inside a guard without a slot; reclamation waits for them.
+    std::atomic<uint32_t> g_OverflowReaders{0};
+
+    std::mutex g_RetireMutex;
+    RetiredNode* g_RetiredHead = nullptr;
+
+    /**
+     * @brief Thread-local slot ownership, returns the slot at thread exit.
+     */
+    struct SlotOwner {
+        int m_Index = -1;
+        uint32_t m_Depth = 0;
+
+        SlotOwner() {
+            for (int i = 0; i < (int)MEM_SENTRY::constants::MAX_EPOCH_READERS; ++i) {
+                bool expected = false;
+                if (g_Slots[i].m_Used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                    m_Index = i;
+                    return;
+                }
+            }
+        }
+
+        ~SlotOwner() {
+            if (m_Index >= 0) {
+                g_Slots[m_Index].m_Epoch.store(0, std::memory_order_release);
+                g_Slots[m_Index].m_Used.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local SlotOwner t_Slot;
+}
+
+MEM_SENTRY::epoch::EpochGuard::EpochGuard() noexcept {
+    SlotOwner& owner = t_Slot;
+
+    if (owner.m_Depth++ != 0) {
+        return;
+    }
+
+    if (owner.m_Index < 0) {
+        g_OverflowReaders.fetch_add(1, std::memory_order_seq_cst);
+        return;
+    }
+
+    g_Slots[owner.m_Index].m_Epoch.store(g_Epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    // the slot store must be visible before any read of a published pointer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+MEM_SENTRY::epoch::EpochGuard::~EpochGuard() noexcept {
+    SlotOwner& owner = t_Slot;
+
+    if (--owner.m_Depth != 0) {
+        return;
+    }
+
+    if (owner.m_Index < 0) {
+        g_OverflowReaders.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    g_Slots[owner.m_Index].m_Epoch.store(0, std::memory_order_release);
+}
+
+void MEM_SENTRY::epoch::Retire(void* ptr, void (*deleter)(void*)) {
+    if (!ptr) return;
+
+    RetiredNode* node = (RetiredNode*) std::malloc(sizeof(RetiredNode));
+
+    // the unpublish happened before this point: bump the epoch so that readers
+    // entering from now on are known not to see `ptr`.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = g_Epoch.fetch_add(1, std::memory_order_seq_cst);
+
+    if (!node) {
+        // can't defer without memory: wait for the readers in place.
+        while (Reclaim() != 0 || g_OverflowReaders.load(std::memory_order_acquire)) {}
+        deleter(ptr);
+        return;
+    }
+
+    node->p_Block = ptr;
+    node->p_Deleter = deleter;
+    node->m_Epoch = epoch;
+
+    {
+        std::lock_guard<std::mutex> lock(g_RetireMutex);
+        node->p_Next = g_RetiredHead;
+        g_RetiredHead = node;
+    }
+
+    Reclaim();
+}
+
+size_t MEM_SENTRY::epoch::Reclaim() {
+    std::lock_guard<std::mutex> lock(g_RetireMutex);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (g_OverflowReaders.load(std::memory_order_acquire)) {
+        size_t pending = 0;
+        for (RetiredNode* node = g_RetiredHead; node; node = node->p_Next) ++pending;
+        return pending;
+    }
+
+    // oldest epoch still observed by an active reader.
+    uint64_t minEpoch = UINT64_MAX;
+    for (ReaderSlot& slot : g_Slots) {
+        uint64_t epoch = slot.m_Epoch.load(std::memory_order_acquire);
+        if (epoch && epoch < minEpoch) minEpoch = epoch;
+    }
+
+    size_t pending = 0;
+    RetiredNode** link = &g_RetiredHead;
+
+    while (*link) {
+        RetiredNode* node = *link;
+
+        // readers at epoch <= node->m_Epoch may have loaded the block before it was unpublished.
+        if (node->m_Epoch < minEpoch) {
+            *link = node->p_Next;
+            node->p_Deleter(node->p_Block);
+            std::free(node);
+        } else {
+            link = &node->p_Next;
+            ++pending;
+        }
+    }
+
+    return pending;
+}
@@ -0,0 +1,244 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mem_sentry/guard_pages.h"
+#include "mem_sentry/alloc_header.h"
+#include "mem_sentry/constants.h"
+
+namespace {
+    constexpr size_t HEADER_SIZE = sizeof(MEM_SENTRY::alloc_header::AllocHeader);
+
+    /**
+     * @brief A freed block: start of the mapping and its size in pages (guard included).
+     */
+    struct FreedBlock {
+        void* p_Base;
+        size_t m_Pages;
+    };
+
+    /**
+     * @brief Freed blocks waiting to be reused or unmapped.
+     *
+     * Everything lives in static storage or malloc'ed memory: the guard pool serves
+     * operator new, so it must never allocate through it.
+     */
+    struct GuardPool {
+        std::mutex m_Mutex;
+
+        /// @brief FIFO of quarantined blocks (oldest at m_Head).
+        FreedBlock* p_Quarantine = nullptr;
+        size_t m_QuarantineCapacity = 0;
+        size_t m_Head = 0;
+        size_t m_Length = 0;
+        size_t m_QuarantineBytes = 0;
+
+        /// @brief Blocks that left the quarantine, by page count.
+        void* m_Cache[MEM_SENTRY::constants::GUARD_REUSE_MAX_PAGES + 1][MEM_SENTRY::constants::GUARD_REUSE_PER_SIZE];
+        size_t m_CacheCount[MEM_SENTRY::constants::GUARD_REUSE_MAX_PAGES + 1] = {};
+        size_t m_CacheBytes = 0;
+    };
+
+    GuardPool& pool() {
+        static GuardPool instance;
+        return instance;
+    }
+
+    size_t pageSize() {
+        static const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+        return page;
+    }
+
+    /**
+     * @brief Alignment actually used for the user data.
+     * Without a requested alignment, the largest power of two dividing `size` is
+     * enough for any object of that size (sizeof is a multiple of alignof).
+     */
+    size_t effectiveAlignment(size_t size, size_t alignment) {
+        if (alignment) {
+            return alignment < 8 ? 8 : alignment;
+        }
+
+        size_t natural = size & (~size + 1);
+        if (natural < 8) natural = 8;
+        if (natural > 16) natural = 16;
+        return natural;
+    }
+
+    /**
+     * @brief Accessible pages needed by a block (header, data and alignment slack).
+     */
+    size_t dataPages(size_t size, size_t alignment) {
+        size_t page = pageSize();
+        return (HEADER_SIZE + size + alignment - 1 + page - 1) / page;
+    }
+
+    char* dataStart(char* base, size_t size, size_t alignment, MEM_SENTRY::guard::GuardMode mode) {
+        size_t page = pageSize();
+
+        if (mode == MEM_SENTRY::guard::GuardMode::Right) {
+            uintptr_t end = (uintptr_t)base + dataPages(size, alignment) * page;
+            return (char*)((end - size) & ~(uintptr_t)(alignment - 1));
+        }
+
+        uintptr_t start = (uintptr_t)base + page + HEADER_SIZE;
+        return (char*)((start + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    char* accessibleStart(char* base, MEM_SENTRY::guard::GuardMode mode) {
+        return mode == MEM_SENTRY::guard::GuardMode::Left ? base + pageSize() : base;
+    }
+
+    /**
+     * @brief Hands a block that left the quarantine to the reuse cache, or unmaps it.
+     * @note Caller must hold the pool mutex.
+     */
+    void retire(GuardPool& guardPool, const FreedBlock& block) {
+        size_t bytes = block.m_Pages * pageSize();
+
+        if (block.m_Pages <= MEM_SENTRY::constants::GUARD_REUSE_MAX_PAGES
+            && guardPool.m_CacheCount[block.m_Pages] < MEM_SENTRY::constants::GUARD_REUSE_PER_SIZE) {
+            guardPool.m_Cache[block.m_Pages][guardPool.m_CacheCount[block.m_Pages]++] = block.p_Base;
+            guardPool.m_CacheBytes += bytes;
+            return;
+        }
+
+        ::munmap(block.p_Base, bytes);
+    }
+}
+
+void* MEM_SENTRY::guard::Allocate(size_t size, size_t alignment, GuardMode mode, void** base) {
+    alignment = effectiveAlignment(size, alignment);
+
+    size_t page = pageSize();
+    size_t accessible = dataPages(size, alignment);
+    size_t pages = accessible + 1;
+
+    char* pBase = nullptr;
+
+    {
+        GuardPool& guardPool = pool();
+        std::lock_guard<std::mutex> lock(guardPool.m_Mutex);
+
+        if (pages <= constants::GUARD_REUSE_MAX_PAGES && guardPool.m_CacheCount[pages]) {
+            pBase = (char*)guardPool.m_Cache[pages][--guardPool.m_CacheCount[pages]];
+            guardPool.m_CacheBytes -= pages * page;
+        }
+    }
+
+    if (!pBase) {
+        void* mapping = ::mmap(nullptr, pages * page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            return nullptr;
+        }
+        pBase = (char*)mapping;
+    }
+
+    // the guard page is never made accessible: it stays PROT_NONE from mmap (or from Free()).
+    if (::mprotect(accessibleStart(pBase, mode), accessible * page, PROT_READ | PROT_WRITE) != 0) {
+        ::munmap(pBase, pages * page);
+        return nullptr;
+    }
+
+    char* pData = dataStart(pBase, size, alignment, mode);
+
+    if (mode == GuardMode::Right) {
+        char* pEnd = pBase + accessible * page;
+        std::memset(pData + size, constants::GUARD_SLACK_BYTE, (size_t)(pEnd - (pData + size)));
+    }
+
+    *base = pBase;
+    return pData;
+}
+
+bool MEM_SENTRY::guard::CheckSlack(const void* data, size_t size, GuardMode mode) {
+    if (mode != GuardMode::Right) {
+        return true;
+    }
+
+    // slack ends at the guard page, i.e. at the next page boundary after the data.
+    const unsigned char* pSlack = (const unsigned char*)data + size;
+    uintptr_t end = ((uintptr_t)pSlack + pageSize() - 1) & ~(uintptr_t)(pageSize() - 1);
+
+    for (; (uintptr_t)pSlack < end; ++pSlack) {
+        if (*pSlack != constants::GUARD_SLACK_BYTE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MEM_SENTRY::guard::Free(void* base, size_t size, size_t alignment) {
+    alignment = effectiveAlignment(size, alignment);
+
+    size_t page = pageSize();
+    size_t pages = dataPages(size, alignment) + 1;
+    size_t bytes = pages * page;
+
+    // any later access faults; the pages are given back to the kernel but the
+    // address range stays reserved, so it can't be handed out by malloc meanwhile.
+    ::mprotect(base, bytes, PROT_NONE);
+    ::madvise(base, bytes, MADV_DONTNEED);
+
+    GuardPool& guardPool = pool();
+    std::lock_guard<std::mutex> lock(guardPool.m_Mutex);
+
+    if (!guardPool.p_Quarantine) {
+        guardPool.m_QuarantineCapacity = constants::GUARD_QUARANTINE_BYTES / (2 * page);
+        guardPool.p_Quarantine = (FreedBlock*)std::malloc(guardPool.m_QuarantineCapacity * sizeof(FreedBlock));
+
+        if (!guardPool.p_Quarantine) {
+            guardPool.m_QuarantineCapacity = 0;
+            ::munmap(base, bytes);
+            return;
+        }
+    }
+
+    // evict the oldest blocks until the new one fits.
+    while (guardPool.m_Length && (guardPool.m_Length == guardPool.m_QuarantineCapacity
+           || guardPool.m_QuarantineBytes + bytes > constants::GUARD_QUARANTINE_BYTES)) {
+        FreedBlock oldest = guardPool.p_Quarantine[guardPool.m_Head];
+        guardPool.m_Head = (guardPool.m_Head + 1) % guardPool.m_QuarantineCapacity;
+        guardPool.m_Length--;
+        guardPool.m_QuarantineBytes -= oldest.m_Pages * page;
+
+        retire(guardPool, oldest);
+    }
+
+    size_t tail = (guardPool.m_Head + guardPool.m_Length) % guardPool.m_QuarantineCapacity;
+    guardPool.p_Quarantine[tail] = {base, pages};
+    guardPool.m_Length++;
+    guardPool.m_QuarantineBytes += bytes;
+}
+
+size_t MEM_SENTRY::guard::CachedBytes() noexcept {
+    GuardPool& guardPool = pool();
+    std::lock_guard<std::mutex> lock(guardPool.m_Mutex);
+    return guardPool.m_QuarantineBytes + guardPool.m_CacheBytes;
+}
+
+void MEM_SENTRY::guard::Trim() {
+    GuardPool& guardPool = pool();
+    std::lock_guard<std::mutex> lock(guardPool.m_Mutex);
+
+    size_t page = pageSize();
+
+    for (; guardPool.m_Length; guardPool.m_Length--) {
+        FreedBlock& block = guardPool.p_Quarantine[guardPool.m_Head];
+        ::munmap(block.p_Base, block.m_Pages * page);
+        guardPool.m_Head = (guardPool.m_Head + 1) % guardPool.m_QuarantineCapacity;
+    }
+    guardPool.m_QuarantineBytes = 0;
+
+    for (size_t pages = 0; pages <= constants::GUARD_REUSE_MAX_PAGES; ++pages) {
+        while (guardPool.m_CacheCount[pages]) {
+            ::munmap(guardPool.m_Cache[pages][--guardPool.m_CacheCount[pages]], pages * page);
+        }
+    }
+    guardPool.m_CacheBytes = 0;
+}
@@ -1,9 +1,16 @@
 #include <iostream>
-#include <unordered_set>
+#include <cstdlib>
 #include <mutex>
+#include <new>
+#include <vector>
 
 #include "mem_sentry/heap.h"
 #include "mem_sentry/alloc_header.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/epoch.h"
+#include "mem_sentry/interpose.h"
+
+constinit thread_local MEM_SENTRY::heap::Heap* MEM_SENTRY::heap::tScopeHeap = nullptr;
 
 bool MEM_SENTRY::heap::Heap::addAllocLL(alloc_header::AllocHeader* alloc){
     if(!alloc) 
@@ -75,24 +82,30 @@ bool MEM_SENTRY::heap::Heap::removeAllocLL(alloc_header::AllocHeader* alloc){
     return true;
 }
 
-int MEM_SENTRY::heap::Heap::CountAllocations() noexcept {
-    std::lock_guard<std::mutex> lock(m_llMutex);
+void MEM_SENTRY::heap::Heap::insertBeforeLL(alloc_header::AllocHeader* alloc, alloc_header::AllocHeader* before){
+    if(!before){
+        addAllocLL(alloc);
+        return;
+    }
 
-    int count = 0;
-    alloc_header::AllocHeader* tmp = p_HeadList;
-    
-    while(tmp){
-        ++count; 
-        tmp = tmp->p_Next; 
+    alloc->p_Next = before;
+    alloc->p_Prev = before->p_Prev;
+
+    if(before->p_Prev){
+        before->p_Prev->p_Next = alloc;
+    } else {
+        p_HeadList = alloc;
     }
-    
-    return count;
+
+    before->p_Prev = alloc;
 }
 
 void MEM_SENTRY::heap::Heap::AddAllocation(alloc_header::AllocHeader* alloc) {
     std::lock_guard<std::mutex> lock(m_llMutex);
     
-    m_total += alloc->m_Size + alloc->m_Alignment;
+    m_total.fetch_add(alloc->m_Size + alloc->m_Alignment, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_AllocCount.fetch_add(1, std::memory_order_relaxed);
 
     if (p_Reporter) {
         p_Reporter->onAlloc(alloc);
@@ -104,17 +117,65 @@ void MEM_SENTRY::heap::Heap::AddAllocation(alloc_header::AllocHeader* alloc) {
 }
 
 void MEM_SENTRY::heap::Heap::RemoveAlloc(alloc_header::AllocHeader* alloc) {
+    uint16_t heapId = alloc->m_HeapId;
+
+    {
+        std::lock_guard<std::mutex> lock(m_llMutex);
+
+        m_total.fetch_sub(alloc->m_Size + alloc->m_Alignment, std::memory_order_relaxed);
+        m_count.fetch_sub(1, std::memory_order_relaxed);
+        m_FreeCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (p_Reporter) {
+            p_Reporter->onDealloc(alloc);
+        }
+
+        if(!removeAllocLL(alloc)){
+            std::printf("Error: error while manipulating Heap Allocations Linked List\n");
+        }
+    }
+
+    // the block was adopted from a destroyed heap: drop its reference on the dead heap's slot.
+    if(heapId != m_Id){
+        registry::Release(heapId);
+    }
+}
+
+void MEM_SENTRY::heap::Heap::ResizeAlloc(alloc_header::AllocHeader* alloc, uint32_t newSize,
+    void (*onResized)(alloc_header::AllocHeader*)) {
     std::lock_guard<std::mutex> lock(m_llMutex);
 
-    m_total -= alloc->m_Size + alloc->m_Alignment;
+    m_total.fetch_add((int)newSize - (int)alloc->m_Size, std::memory_order_relaxed);
+    alloc->m_Size = newSize;
 
-    if (p_Reporter) {
-        p_Reporter->onDealloc(alloc);
+    if (onResized) {
+        onResized(alloc);
     }
+}
 
-    if(!removeAllocLL(alloc)){
-        std::printf("Error: error while manipulating Heap Allocations Linked List\n");
+void MEM_SENTRY::heap::Heap::RelinkAlloc(alloc_header::AllocHeader* alloc, alloc_header::AllocHeader* moved) {
+    std::lock_guard<std::mutex> lock(m_llMutex);
+
+    m_total.fetch_add((int)(moved->m_Size + moved->m_Alignment) - (int)(alloc->m_Size + alloc->m_Alignment),
+        std::memory_order_relaxed);
+
+    moved->p_Prev = alloc->p_Prev;
+    moved->p_Next = alloc->p_Next;
+
+    if (moved->p_Prev) {
+        moved->p_Prev->p_Next = moved;
+    } else {
+        p_HeadList = moved;
     }
+
+    if (moved->p_Next) {
+        moved->p_Next->p_Prev = moved;
+    } else {
+        p_TailList = moved;
+    }
+
+    alloc->p_Prev = nullptr;
+    alloc->p_Next = nullptr;
 }
 
 void MEM_SENTRY::heap::Heap::ReportMemory(int bookMark1, int bookMark2){
@@ -129,6 +190,11 @@ void MEM_SENTRY::heap::Heap::ReportMemory(int bookMark1, int bookMark2){
     int total = 0;
 
     while(tmp && tmp->m_AllocId <= bookMark2){
+        if(tmp->m_Signature == (uint32_t)constants::MEMSYSTEM_CURSOR_SIGNATURE){
+            tmp = tmp->p_Next;
+            continue;
+        }
+
         total += tmp->m_Size;
         if (p_Reporter) {
             p_Reporter->report(tmp);
@@ -138,57 +204,493 @@ void MEM_SENTRY::heap::Heap::ReportMemory(int bookMark1, int bookMark2){
     }
 }
 
+MEM_SENTRY::snapshot::HeapSnapshot MEM_SENTRY::heap::Heap::Snapshot(){
+    using constants::SNAPSHOT_SIZE_CLASSES;
+
+    struct Totals {
+        uint32_t m_Counts[SNAPSHOT_SIZE_CLASSES];
+        uint64_t m_Bytes[SNAPSHOT_SIZE_CLASSES];
+    };
+
+    Totals totals{};
+
+    // everything allocated from now on is newer than the snapshot.
+    const uint32_t stopId = (uint32_t)m_NextAllocId.load(std::memory_order_relaxed);
+
+    walkChunked(stopId, [](const alloc_header::AllocHeader* alloc, void* context){
+        Totals* totals = (Totals*)context;
+
+        uint32_t sizeClass = snapshot::SizeClassOf(alloc->m_Size);
+        ++totals->m_Counts[sizeClass];
+        totals->m_Bytes[sizeClass] += alloc->m_Size + alloc->m_Alignment;
+    }, &totals);
+
+    snapshot::HeapSnapshot result(m_name);
+    result.Assign(totals.m_Counts, totals.m_Bytes);
+
+    return result;
+}
+
+void MEM_SENTRY::heap::Heap::walkChunked(uint32_t stopId, void (*visit)(const alloc_header::AllocHeader*, void*), void* context,
+    size_t chunkSize){
+    if(!chunkSize)
+        chunkSize = 1;
+
+    alloc_header::AllocHeader cursor{};
+    cursor.m_HeapId = m_Id;
+    cursor.m_Signature = constants::MEMSYSTEM_CURSOR_SIGNATURE;
+
+    {
+        std::lock_guard<std::mutex> lock(m_llMutex);
+        insertBeforeLL(&cursor, p_HeadList);
+    }
+
+    bool done = false;
+    while(!done){
+        std::lock_guard<std::mutex> lock(m_llMutex);
+
+        alloc_header::AllocHeader* node = cursor.p_Next;
+        size_t visited = 0;
+
+        while(node && visited < chunkSize){
+            ++visited;
+
+            // blocks adopted from a destroyed heap carry ids of that heap's sequence,
+            // but they all predate the walk.
+            if(node->m_Signature != (uint32_t)constants::MEMSYSTEM_CURSOR_SIGNATURE &&
+                (node->m_AllocId < stopId || node->m_HeapId != m_Id)){
+                visit(node, context);
+            }
+
+            node = node->p_Next;
+        }
+
+        // park the cursor in front of the first unvisited node.
+        removeAllocLL(&cursor);
+
+        if(node){
+            insertBeforeLL(&cursor, node);
+        } else {
+            done = true;
+        }
+    }
+}
+
+MEM_SENTRY::sites::SiteSummary MEM_SENTRY::heap::Heap::SummarizeSites(int bookMark1, int bookMark2){
+    struct Totals {
+        uint32_t* p_Counts;
+        uint64_t* p_Bytes;
+        uint32_t m_First;
+        uint32_t m_Last;
+    };
+
+    // allocated before the walk starts, so they are newer than what it visits.
+    std::vector<uint32_t> counts(constants::SITE_TABLE_SIZE + 1, 0);
+    std::vector<uint64_t> bytes(constants::SITE_TABLE_SIZE + 1, 0);
+
+    Totals totals{counts.data(), bytes.data(), (uint32_t)(bookMark1 < 0 ? 0 : bookMark1), (uint32_t)(bookMark2 < 0 ? 0 : bookMark2)};
+
+    const uint32_t stopId = (uint32_t)m_NextAllocId.load(std::memory_order_relaxed);
+
+    walkChunked(stopId, [](const alloc_header::AllocHeader* alloc, void* context){
+        Totals* totals = (Totals*)context;
+
+        if(alloc->m_AllocId < totals->m_First || alloc->m_AllocId > totals->m_Last)
+            return;
+
+        uint32_t site = alloc->m_SiteId <= constants::SITE_TABLE_SIZE ? alloc->m_SiteId : 0;
+        ++totals->p_Counts[site];
+        totals->p_Bytes[site] += alloc->m_Size + alloc->m_Alignment;
+    }, &totals);
+
+    sites::SiteSummary result(m_name);
+    result.Assign(counts.data(), bytes.data());
+
+    return result;
+}
+
+bool MEM_SENTRY::heap::Heap::ScrubStep(size_t maxNodes, void (*visit)(alloc_header::AllocHeader*, void*), void* context){
+    std::lock_guard<std::mutex> lock(m_llMutex);
+
+    alloc_header::AllocHeader* node = p_HeadList;
+
+    if(m_ScrubParked){
+        node = m_ScrubCursor.p_Next;
+        removeAllocLL(&m_ScrubCursor);
+        m_ScrubParked = false;
+    }
+
+    size_t visited = 0;
+    while(node && visited < maxNodes){
+        if(node->m_Signature != (uint32_t)constants::MEMSYSTEM_CURSOR_SIGNATURE){
+            visit(node, context);
+            ++visited;
+        }
+
+        node = node->p_Next;
+    }
+
+    if(!node){
+        return true;
+    }
+
+    // park the cursor in front of the first unvisited node.
+    insertBeforeLL(&m_ScrubCursor, node);
+    m_ScrubParked = true;
+
+    return false;
+}
+
 std::mutex MEM_SENTRY::heap::Heap::m_graphMutex;
+uint64_t MEM_SENTRY::heap::Heap::m_VisitEpoch = 0;
+
+MEM_SENTRY::heap::Heap::~Heap(){
+    registry::Unlist(m_Id);
+
+    {
+        std::lock_guard<std::mutex> lock(Heap::m_graphMutex);
+
+        detachFromGraph();
+
+        // readers may still be inside a guard holding the closure.
+        epoch::Retire(p_Reach.exchange(nullptr, std::memory_order_acq_rel), std::free);
+    }
+
+    orphanAllocations();
+
+    // frees must not race with the destructor (see its note), so nobody records anymore.
+    std::free(p_Lifetime.exchange(nullptr, std::memory_order_acq_rel));
+}
+
+bool MEM_SENTRY::heap::Heap::SetLifetimeProfile(bool enabled){
+    if(enabled && !p_Lifetime.load(std::memory_order_acquire)){
+        void* memory = interpose::UntrackedMalloc(sizeof(lifetime::Histogram));
+
+        if(!memory){
+            return false;
+        }
+
+        lifetime::Histogram* histogram = new (memory) lifetime::Histogram();
+        lifetime::Histogram* expected = nullptr;
+
+        // another thread may have enabled it first.
+        if(!p_Lifetime.compare_exchange_strong(expected, histogram, std::memory_order_acq_rel)){
+            std::free(memory);
+        }
+    }
+
+    m_LifetimeProfile.store(enabled, std::memory_order_relaxed);
+    return true;
+}
+
+MEM_SENTRY::lifetime::LifetimeReport MEM_SENTRY::heap::Heap::GetLifetimeReport() const {
+    lifetime::LifetimeReport report(m_name);
+    report.Assign(p_Lifetime.load(std::memory_order_acquire));
+    return report;
+}
+
+void MEM_SENTRY::heap::Heap::orphanAllocations(){
+    Heap* orphan = HeapFactory::GetOrphanHeap();
+
+    std::lock_guard<std::mutex> lock(m_llMutex);
+
+    uint32_t live = (uint32_t)m_count.load(std::memory_order_relaxed);
+
+    // the scrub cursor belongs to this heap, it must not follow the allocations.
+    if(m_ScrubParked){
+        removeAllocLL(&m_ScrubCursor);
+        m_ScrubParked = false;
+    }
+
+    if(!p_HeadList){
+        registry::Orphan(m_Id, orphan, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> orphanLock(orphan->m_llMutex);
+
+        // O(1) splice of the whole list onto the orphan's tail.
+        if(orphan->p_TailList){
+            orphan->p_TailList->p_Next = p_HeadList;
+            p_HeadList->p_Prev = orphan->p_TailList;
+        } else {
+            orphan->p_HeadList = p_HeadList;
+        }
+        orphan->p_TailList = p_TailList;
+
+        orphan->m_total.fetch_add(m_total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        orphan->m_count.fetch_add(live, std::memory_order_relaxed);
+
+        registry::Orphan(m_Id, orphan, live);
+    }
+
+    p_HeadList = nullptr;
+    p_TailList = nullptr;
+    m_total.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+}
+
+MEM_SENTRY::heap::HeapList* MEM_SENTRY::heap::Heap::appendList(const HeapList* list, Heap* heap){
+    size_t count = list ? list->m_Count : 0;
+
+    HeapList* grown = (HeapList*) std::malloc(sizeof(HeapList) + count * sizeof(Heap*));
+
+    if(!grown)
+        return nullptr;
+
+    if(count){
+        std::memcpy(grown->m_Heaps, list->m_Heaps, count * sizeof(Heap*));
+    }
+
+    grown->m_Heaps[count] = heap;
+    grown->m_Count = count + 1;
+
+    return grown;
+}
+
+bool MEM_SENTRY::heap::Heap::removeFromList(const HeapList* list, Heap* heap, HeapList*& result){
+    result = nullptr;
+
+    if(!list)
+        return true;
+
+    size_t kept = 0;
+    for(size_t i = 0; i < list->m_Count; ++i){
+        if(list->m_Heaps[i] != heap) ++kept;
+    }
+
+    if(!kept)
+        return true;
+
+    result = (HeapList*) std::malloc(sizeof(HeapList) + (kept - 1) * sizeof(Heap*));
+
+    if(!result)
+        return false;
+
+    result->m_Count = 0;
+    for(size_t i = 0; i < list->m_Count; ++i){
+        if(list->m_Heaps[i] != heap){
+            result->m_Heaps[result->m_Count++] = list->m_Heaps[i];
+        }
+    }
+
+    return true;
+}
+
+void MEM_SENTRY::heap::Heap::detachFromGraph(){
+    // heaps whose closure contains this one, collected before the edges go away.
+    size_t count = 0;
+    Heap** sources = collectReachable(this, false, count);
+
+    HeapList* adj = m_AdjHeaps.exchange(nullptr, std::memory_order_seq_cst);
+
+    if(adj){
+        for(size_t i = 0; i < adj->m_Count; ++i){
+            Heap* neighbor = adj->m_Heaps[i];
+            HeapList* in = nullptr;
+
+            if(neighbor == this || !removeFromList(neighbor->p_InHeaps, this, in))
+                continue;
+
+            std::free(neighbor->p_InHeaps);
+            neighbor->p_InHeaps = in;
+        }
+
+        epoch::Retire(adj, std::free);
+    }
+
+    if(p_InHeaps){
+        for(size_t i = 0; i < p_InHeaps->m_Count; ++i){
+            Heap* predecessor = p_InHeaps->m_Heaps[i];
+            HeapList* out = nullptr;
+
+            if(predecessor == this || !removeFromList(predecessor->m_AdjHeaps.load(std::memory_order_relaxed), this, out))
+                continue;
+
+            epoch::Retire(predecessor->m_AdjHeaps.exchange(out, std::memory_order_seq_cst), std::free);
+        }
+
+        std::free(p_InHeaps);
+        p_InHeaps = nullptr;
+    }
+
+    if(!sources){
+        std::printf("Error: out of memory while rebuilding the Heap Hierarchy\n");
+        return;
+    }
+
+    for(size_t i = 0; i < count; ++i){
+        if(sources[i] != this){
+            rebuildReach(sources[i]);
+        }
+    }
+
+    std::free(sources);
+}
+
+MEM_SENTRY::heap::Heap** MEM_SENTRY::heap::Heap::collectReachable(Heap* start, bool forward, size_t& count){
+    size_t capacity = 8;
+    Heap** heaps = (Heap**) std::malloc(capacity * sizeof(Heap*));
+    count = 0;
+
+    if(!heaps)
+        return nullptr;
+
+    const uint64_t mark = ++m_VisitEpoch;
+
+    start->m_VisitMark = mark;
+    heaps[count++] = start;
+
+    // the output array is the BFS queue: everything before `head` is expanded.
+    for(size_t head = 0; head < count; ++head){
+        // writers are serialized by m_graphMutex, so the lists can't be retired under us.
+        const HeapList* edges = forward ? heaps[head]->m_AdjHeaps.load(std::memory_order_relaxed)
+                                        : heaps[head]->p_InHeaps;
+
+        if(!edges)
+            continue;
+
+        for(size_t i = 0; i < edges->m_Count; ++i){
+            Heap* heap = edges->m_Heaps[i];
+
+            if(heap->m_VisitMark == mark)
+                continue;
+
+            if(count == capacity){
+                capacity *= 2;
+                Heap** grown = (Heap**) std::realloc(heaps, capacity * sizeof(Heap*));
+
+                if(!grown){
+                    std::free(heaps);
+                    return nullptr;
+                }
+
+                heaps = grown;
+            }
+
+            heap->m_VisitMark = mark;
+            heaps[count++] = heap;
+        }
+    }
+
+    return heaps;
+}
+
+void MEM_SENTRY::heap::Heap::rebuildReach(Heap* heap){
+    size_t count = 0;
+    Heap** heaps = collectReachable(heap, true, count);
+
+    if(!heaps){
+        std::printf("Error: out of memory while rebuilding the Heap Hierarchy\n");
+        return;
+    }
+
+    HeapList* reach = (HeapList*) std::malloc(sizeof(HeapList) + (count - 1) * sizeof(Heap*));
+
+    if(!reach){
+        std::free(heaps);
+        std::printf("Error: out of memory while rebuilding the Heap Hierarchy\n");
+        return;
+    }
+
+    reach->m_Count = count;
+    std::memcpy(reach->m_Heaps, heaps, count * sizeof(Heap*));
+    std::free(heaps);
+
+    HeapList* old = heap->p_Reach.exchange(reach, std::memory_order_seq_cst);
+    epoch::Retire(old, std::free);
+}
 
 void MEM_SENTRY::heap::Heap::AddHeap(Heap* heap) {
     std::lock_guard<std::mutex> lock(Heap::m_graphMutex);
 
-    if (heap) {
-        m_AdjHeaps.push_back(heap);
+    if (!heap) {
+        return;
     }
-}
 
-void MEM_SENTRY::heap::Heap::dfs(Heap* currentHeap, std::unordered_set<Heap*>& visited, size_t& val,
-    const std::function<void(Heap*, size_t&)>& func) {
+    HeapList* adj = appendList(m_AdjHeaps.load(std::memory_order_relaxed), heap);
+    HeapList* in = appendList(heap->p_InHeaps, this);
 
-    if(visited.count(currentHeap)){
+    if(!adj || !in){
+        std::free(adj);
+        std::free(in);
+        std::printf("Error: out of memory while rebuilding the Heap Hierarchy\n");
         return;
     }
 
-    visited.insert(currentHeap);
-    func(currentHeap, val);
+    // copy-on-write: publish the new adjacency list, readers keep the old one alive.
+    HeapList* oldAdj = m_AdjHeaps.exchange(adj, std::memory_order_seq_cst);
+    epoch::Retire(oldAdj, std::free);
 
-    for(auto heap : currentHeap->m_AdjHeaps){
-        dfs(heap, visited, val, func);
+    // the reverse list is only read by writers under the mutex.
+    std::free(heap->p_InHeaps);
+    heap->p_InHeaps = in;
+
+    // every heap that reaches `this` now also reaches `heap`'s closure.
+    size_t count = 0;
+    Heap** sources = collectReachable(this, false, count);
+
+    if(!sources){
+        std::printf("Error: out of memory while rebuilding the Heap Hierarchy\n");
+        return;
+    }
+
+    for(size_t i = 0; i < count; ++i){
+        rebuildReach(sources[i]);
+    }
+
+    std::free(sources);
+}
+
+size_t MEM_SENTRY::heap::Heap::GetAdjacentHeaps(Heap** out, size_t capacity) const {
+    epoch::EpochGuard guard;
+
+    const HeapList* adj = m_AdjHeaps.load(std::memory_order_acquire);
+
+    if(!adj){
+        return 0;
     }
+
+    for(size_t i = 0; i < adj->m_Count && i < capacity; ++i){
+        out[i] = adj->m_Heaps[i];
+    }
+
+    return adj->m_Count;
 }
 
 size_t MEM_SENTRY::heap::Heap::GetTotalHH(){
-    std::lock_guard<std::mutex> lock(Heap::m_graphMutex);
-    std::unordered_set<Heap*> visited;
+    epoch::EpochGuard guard;
 
-    size_t total = 0;
+    const HeapList* reach = p_Reach.load(std::memory_order_acquire);
 
-    const auto lamda = [](Heap* heap, size_t& val){
-        val += heap->GetTotal();
-    };
+    if(!reach){
+        return GetTotal();
+    }
 
-    dfs(this, visited, total, lamda);
+    size_t total = 0;
+
+    for(size_t i = 0; i < reach->m_Count; ++i){
+        total += reach->m_Heaps[i]->GetTotal();
+    }
 
     return total;
 }
 
 size_t MEM_SENTRY::heap::Heap::CountAllocationsHH(){
-    std::lock_guard<std::mutex> lock(Heap::m_graphMutex);
-    std::unordered_set<Heap*> visited;
+    epoch::EpochGuard guard;
 
-    size_t total = 0;
+    const HeapList* reach = p_Reach.load(std::memory_order_acquire);
 
-    const auto lamda = [](Heap* heap, size_t& val){
-        val += heap->CountAllocations();
-    };
+    if(!reach){
+        return CountAllocations();
+    }
 
-    dfs(this, visited, total, lamda);
+    size_t total = 0;
+
+    for(size_t i = 0; i < reach->m_Count; ++i){
+        total += reach->m_Heaps[i]->CountAllocations();
+    }
 
     return total;
 }
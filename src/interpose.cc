@@ -0,0 +1,51 @@
+#include <atomic>
+#include <cstdlib>
+
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/heap.h"
+
+namespace {
+    /// @brief initial-exec: reaching the counter must never allocate, even from a
+    /// preloaded library (the default TLS model may malloc the thread's block).
+    __attribute__((tls_model("initial-exec"))) thread_local unsigned tBypassDepth = 0;
+
+    std::atomic<MEM_SENTRY::heap::Heap*> gHeap{nullptr};
+
+    MEM_SENTRY::heap::Heap* mallocHeap() {
+        // never destroyed, like the default heap: libc keeps freeing blocks after static destructors.
+        alignas(MEM_SENTRY::heap::Heap) static unsigned char storage[sizeof(MEM_SENTRY::heap::Heap)];
+        static MEM_SENTRY::heap::Heap* heap = new (storage) MEM_SENTRY::heap::Heap("MallocHeap");
+        return heap;
+    }
+}
+
+MEM_SENTRY::interpose::BypassScope::BypassScope() noexcept {
+    ++tBypassDepth;
+}
+
+MEM_SENTRY::interpose::BypassScope::~BypassScope() {
+    --tBypassDepth;
+}
+
+bool MEM_SENTRY::interpose::IsBypassed() noexcept {
+    return tBypassDepth != 0;
+}
+
+void* MEM_SENTRY::interpose::UntrackedMalloc(size_t size) noexcept {
+    BypassScope bypass;
+    return std::malloc(size);
+}
+
+void* MEM_SENTRY::interpose::UntrackedCalloc(size_t count, size_t size) noexcept {
+    BypassScope bypass;
+    return std::calloc(count, size);
+}
+
+void MEM_SENTRY::interpose::SetHeap(heap::Heap* heap) noexcept {
+    gHeap.store(heap, std::memory_order_release);
+}
+
+MEM_SENTRY::heap::Heap* MEM_SENTRY::interpose::GetHeap() {
+    heap::Heap* heap = gHeap.load(std::memory_order_acquire);
+    return heap ? heap : mallocHeap();
+}
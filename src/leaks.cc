@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <new>
+
+#include "mem_sentry/leaks.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/lifetime.h"
+#include "mem_sentry/registry.h"
+#include "mem_sentry/sites.h"
+#include "mem_sentry/snapshot.h"
+#include "mem_sentry/threads.h"
+
+/**
+ * @struct LeakGroup
+ * @brief Slot of the per-heap open addressing table keyed by (site, size class).
+ */
+struct MEM_SENTRY::leaks::LeakGroup {
+    /// @brief Heap walk that filled the slot; other values mean empty.
+    uint64_t m_Generation;
+
+    uint32_t m_SiteId;
+    uint32_t m_SizeClass;
+    uint64_t m_Count;
+    uint64_t m_Bytes;
+    uint64_t m_OldestAge;
+    uint32_t m_OldestAllocId;
+};
+
+/**
+ * @struct AgeMarks
+ * @brief Ring of (time, next alloc id) marks of one heap, oldest at m_Head.
+ */
+struct MEM_SENTRY::leaks::AgeMarks {
+    struct Mark {
+        uint64_t m_Time;
+        uint32_t m_NextId;
+    };
+
+    /// @brief Registry generation of the heap the marks were taken on: a registry id can be reused by a later heap.
+    uint32_t m_HeapGeneration;
+
+    uint32_t m_Count;
+    uint32_t m_Head;
+    Mark m_Marks[constants::LEAK_AGE_MARKS];
+
+    const Mark& at(uint32_t i) const {
+        return m_Marks[(m_Head + i) % constants::LEAK_AGE_MARKS];
+    }
+
+    const Mark& newest() const {
+        return at(m_Count - 1);
+    }
+};
+
+namespace {
+    static_assert((MEM_SENTRY::constants::LEAK_MAX_GROUPS & (MEM_SENTRY::constants::LEAK_MAX_GROUPS - 1)) == 0,
+        "LEAK_MAX_GROUPS must be a power of 2");
+
+    /**
+     * @brief Prints a duration in nanoseconds with a readable unit.
+     */
+    const char* formatAge(uint64_t nanoseconds, char* out, size_t capacity) {
+        if (nanoseconds >= 1000000000ull) {
+            std::snprintf(out, capacity, "%.1fs", nanoseconds / 1e9);
+        } else if (nanoseconds >= 1000000ull) {
+            std::snprintf(out, capacity, "%.1fms", nanoseconds / 1e6);
+        } else {
+            std::snprintf(out, capacity, "%.1fus", nanoseconds / 1e3);
+        }
+        return out;
+    }
+
+    /**
+     * @struct ScanContext
+     * @brief State shared with the ForEachAllocation() visitor of one heap.
+     */
+    struct ScanContext {
+        uint16_t m_HeapId;
+        uint64_t m_Now;
+        uint64_t m_MinAge;
+        uint64_t m_Generation;
+
+        /// @brief Blocks of this heap with a lower id are at least m_MinAge old.
+        uint32_t m_Threshold;
+
+        const MEM_SENTRY::leaks::AgeMarks* p_Marks;
+
+        MEM_SENTRY::leaks::LeakGroup* p_Groups;
+        size_t m_Used;
+        uint64_t m_Dropped;
+    };
+
+    /**
+     * @brief Lower bound of the age of an untimestamped block: the time of the first
+     * mark taken after it was allocated.
+     */
+    uint64_t ageFromMarks(const ScanContext* scan, uint32_t allocId) {
+        for (uint32_t i = 0; i < scan->p_Marks->m_Count; ++i) {
+            const auto& mark = scan->p_Marks->at(i);
+            if (allocId < mark.m_NextId) {
+                return scan->m_Now - mark.m_Time;
+            }
+        }
+        return 0;
+    }
+
+    void visitSuspect(const MEM_SENTRY::alloc_header::AllocHeader* alloc, void* context) {
+        ScanContext* scan = (ScanContext*)context;
+        uint64_t age;
+
+        if (alloc->m_Timestamp) {
+            age = scan->m_Now > alloc->m_Timestamp ? scan->m_Now - alloc->m_Timestamp : 0;
+            if (age < scan->m_MinAge) return;
+        } else if (alloc->m_HeapId == scan->m_HeapId && alloc->m_AllocId < scan->m_Threshold) {
+            // blocks adopted from a destroyed heap have ids of another sequence: skipped.
+            age = ageFromMarks(scan, alloc->m_AllocId);
+        } else {
+            return;
+        }
+
+        constexpr size_t MASK = MEM_SENTRY::constants::LEAK_MAX_GROUPS - 1;
+
+        uint32_t sizeClass = MEM_SENTRY::snapshot::SizeClassOf(alloc->m_Size);
+        size_t index = (alloc->m_SiteId * 0x9E3779B1u ^ sizeClass * 0x85EBCA77u) & MASK;
+
+        for (size_t probe = 0; probe < MEM_SENTRY::constants::LEAK_MAX_GROUPS; ++probe, index = (index + 1) & MASK) {
+            auto& group = scan->p_Groups[index];
+
+            if (group.m_Generation != scan->m_Generation) {
+                group = {scan->m_Generation, alloc->m_SiteId, sizeClass, 0, 0, 0, 0};
+                ++scan->m_Used;
+            } else if (group.m_SiteId != alloc->m_SiteId || group.m_SizeClass != sizeClass) {
+                continue;
+            }
+
+            ++group.m_Count;
+            group.m_Bytes += alloc->m_Size + alloc->m_Alignment;
+
+            if (age >= group.m_OldestAge) {
+                group.m_OldestAge = age;
+                group.m_OldestAllocId = alloc->m_AllocId;
+            }
+            return;
+        }
+
+        ++scan->m_Dropped;
+    }
+}
+
+MEM_SENTRY::leaks::LeakReport::LeakReport(uint64_t minAge)
+    : m_TotalCount(0), m_TotalBytes(0), m_Dropped(0), m_MinAge(minAge) {
+}
+
+void MEM_SENTRY::leaks::LeakReport::Add(const LeakEntry& entry) {
+    m_Entries.push_back(entry);
+    m_TotalCount += entry.m_Count;
+    m_TotalBytes += entry.m_Bytes;
+}
+
+void MEM_SENTRY::leaks::LeakReport::Sort() {
+    std::sort(m_Entries.begin(), m_Entries.end(), [](const LeakEntry& a, const LeakEntry& b) {
+        return a.m_Bytes != b.m_Bytes ? a.m_Bytes > b.m_Bytes : a.m_OldestAge > b.m_OldestAge;
+    });
+}
+
+void MEM_SENTRY::leaks::LeakReport::Dump(std::FILE* out) const {
+    char age[32];
+
+    std::fprintf(out, "=== Suspected Leaks (older than %s) ===\n", formatAge(m_MinAge, age, sizeof(age)));
+    std::fprintf(out, "%12s %16s %10s %-14s %-20s %s\n", "Count", "Bytes", "Oldest", "Size Class", "Heap", "Site");
+
+    for (const LeakEntry& entry : m_Entries) {
+        char sizeClass[24];
+        std::snprintf(sizeClass, sizeof(sizeClass), "<= %" PRIu64, uint64_t(1) << entry.m_SizeClass);
+
+        std::fprintf(out, "%12" PRIu64 " %16" PRIu64 " %10s %-14s %-20s ",
+            entry.m_Count, entry.m_Bytes, formatAge(entry.m_OldestAge, age, sizeof(age)), sizeClass, entry.m_HeapName);
+
+        if (const sites::SiteInfo* info = sites::Lookup(entry.m_SiteId)) {
+            std::fprintf(out, "%s:%" PRIu32 " (#%u)\n", info->m_File, info->m_Line, entry.m_OldestAllocId);
+        } else {
+            std::fprintf(out, "(untagged) (#%u)\n", entry.m_OldestAllocId);
+        }
+    }
+
+    std::fprintf(out, "%12" PRIu64 " %16" PRIu64 "  Total", m_TotalCount, m_TotalBytes);
+
+    if (m_Dropped) {
+        std::fprintf(out, " (+%" PRIu64 " ungrouped)", m_Dropped);
+    }
+    std::fprintf(out, "\n");
+}
+
+MEM_SENTRY::leaks::LeakDetector::LeakDetector(std::chrono::milliseconds minAge, size_t chunkSize)
+    : m_MinAge((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(minAge).count()),
+      m_ChunkSize(chunkSize ? chunkSize : 1), m_Generation(0), m_Latest(m_MinAge), m_Passes(0), m_Stop(false) {
+    p_Groups = (LeakGroup*) interpose::UntrackedCalloc(constants::LEAK_MAX_GROUPS, sizeof(LeakGroup));
+    p_Marks = (AgeMarks**) interpose::UntrackedCalloc(constants::MAX_HEAPS, sizeof(AgeMarks*));
+
+    if (!p_Groups || !p_Marks) {
+        std::free(p_Groups);
+        std::free(p_Marks);
+        throw std::bad_alloc();
+    }
+}
+
+MEM_SENTRY::leaks::LeakDetector::~LeakDetector() {
+    Stop();
+
+    for (size_t i = 0; i < constants::MAX_HEAPS; ++i) {
+        std::free(p_Marks[i]);
+    }
+
+    std::free(p_Marks);
+    std::free(p_Groups);
+}
+
+MEM_SENTRY::leaks::AgeMarks* MEM_SENTRY::leaks::LeakDetector::marksOf(heap::Heap* heap, uint64_t now) {
+    AgeMarks*& marks = p_Marks[heap->GetId()];
+    uint32_t generation = registry::Generation(heap->GetId());
+
+    if (!marks) {
+        marks = (AgeMarks*) interpose::UntrackedMalloc(sizeof(AgeMarks));
+
+        if (!marks) return nullptr;
+
+        marks->m_HeapGeneration = generation;
+        marks->m_Count = 0;
+        marks->m_Head = 0;
+    }
+
+    uint32_t nextId = heap->PeekNextId();
+
+    // another heap got the registry id: its ids start over.
+    if (marks->m_HeapGeneration != generation || (marks->m_Count && nextId < marks->newest().m_NextId)) {
+        marks->m_HeapGeneration = generation;
+        marks->m_Count = 0;
+        marks->m_Head = 0;
+    }
+
+    // spaced so the ring covers twice the leak age.
+    uint64_t spacing = m_MinAge / (constants::LEAK_AGE_MARKS / 2);
+
+    if (marks->m_Count && now - marks->newest().m_Time < spacing) {
+        return marks;
+    }
+
+    if (marks->m_Count < constants::LEAK_AGE_MARKS) {
+        marks->m_Marks[(marks->m_Head + marks->m_Count) % constants::LEAK_AGE_MARKS] = {now, nextId};
+        ++marks->m_Count;
+    } else {
+        marks->m_Marks[marks->m_Head] = {now, nextId};
+        marks->m_Head = (marks->m_Head + 1) % constants::LEAK_AGE_MARKS;
+    }
+
+    return marks;
+}
+
+void MEM_SENTRY::leaks::LeakDetector::scanHeap(heap::Heap* heap, uint64_t now, LeakReport& report) {
+    ScanContext scan{heap->GetId(), now, m_MinAge, ++m_Generation, 0, marksOf(heap, now), p_Groups, 0, 0};
+
+    if (scan.p_Marks) {
+        // the newest mark old enough: every block allocated before it is a suspect.
+        for (uint32_t i = 0; i < scan.p_Marks->m_Count; ++i) {
+            const auto& mark = scan.p_Marks->at(i);
+            if (now - mark.m_Time >= m_MinAge) {
+                scan.m_Threshold = mark.m_NextId;
+            }
+        }
+    }
+
+    heap->ForEachAllocation(UINT32_MAX, visitSuspect, &scan, m_ChunkSize);
+
+    for (size_t i = 0; scan.m_Used && i < constants::LEAK_MAX_GROUPS; ++i) {
+        const LeakGroup& group = p_Groups[i];
+
+        if (group.m_Generation == scan.m_Generation) {
+            report.Add({heap->GetName(), group.m_SiteId, group.m_SizeClass, group.m_Count,
+                group.m_Bytes, group.m_OldestAge, group.m_OldestAllocId});
+        }
+    }
+
+    report.AddDropped(scan.m_Dropped);
+}
+
+MEM_SENTRY::leaks::LeakReport MEM_SENTRY::leaks::LeakDetector::ScanNow() {
+    std::lock_guard<std::mutex> lock(m_ScanMutex);
+
+    uint64_t now = lifetime::Now();
+    LeakReport report(m_MinAge);
+
+    // the registry lock is only taken to pick the next heap: the walk runs outside it,
+    // with the heap pinned so it can't be destroyed under the scan.
+    registry::ForEach([&](heap::Heap* heap) {
+        scanHeap(heap, now, report);
+    });
+
+    report.Sort();
+
+    {
+        std::lock_guard<std::mutex> reportLock(m_ReportMutex);
+        m_Latest = report;
+    }
+
+    m_Passes.fetch_add(1, std::memory_order_relaxed);
+    return report;
+}
+
+MEM_SENTRY::leaks::LeakReport MEM_SENTRY::leaks::LeakDetector::GetReport() const {
+    std::lock_guard<std::mutex> lock(m_ReportMutex);
+    return m_Latest;
+}
+
+void MEM_SENTRY::leaks::LeakDetector::loop(std::chrono::milliseconds interval, std::FILE* out) {
+    threads::LowerPriority();
+
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        LeakReport report = ScanNow();
+
+        if (out && report.GetTotalCount()) {
+            report.Dump(out);
+            std::fflush(out);
+        }
+
+        std::unique_lock<std::mutex> lock(m_WaitMutex);
+        m_WaitCv.wait_for(lock, interval, [this] { return m_Stop.load(std::memory_order_acquire); });
+    }
+}
+
+bool MEM_SENTRY::leaks::LeakDetector::Start(std::chrono::milliseconds interval, std::FILE* out) {
+    if (m_Thread.joinable()) {
+        return false;
+    }
+
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&LeakDetector::loop, this, interval, out);
+
+    return true;
+}
+
+void MEM_SENTRY::leaks::LeakDetector::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        m_Stop.store(true, std::memory_order_release);
+    }
+    m_WaitCv.notify_all();
+
+    m_Thread.join();
+}
@@ -0,0 +1,131 @@
+#include <cinttypes>
+#include <ctime>
+
+#include "mem_sentry/lifetime.h"
+#include "mem_sentry/snapshot.h"
+
+namespace {
+    constexpr const char* BUCKET_NAMES[MEM_SENTRY::constants::LIFETIME_BUCKETS] = {
+        "< 1us", "< 3us", "< 10us", "< 30us", "< 100us", "< 300us",
+        "< 1ms", "< 3ms", "< 10ms", "< 30ms", "< 100ms", "< 300ms",
+        "< 1s", "< 3s", "< 10s", ">= 10s"
+    };
+}
+
+uint64_t MEM_SENTRY::lifetime::Now() noexcept {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+const char* MEM_SENTRY::lifetime::BucketName(uint32_t bucket) noexcept {
+    return bucket < constants::LIFETIME_BUCKETS ? BUCKET_NAMES[bucket] : "(none)";
+}
+
+MEM_SENTRY::lifetime::Histogram::Histogram() noexcept {
+    Reset();
+}
+
+void MEM_SENTRY::lifetime::Histogram::Record(uint32_t size, uint64_t nanoseconds) noexcept {
+    uint32_t sizeClass = snapshot::SizeClassOf(size);
+    uint32_t bucket = BucketOf(nanoseconds);
+
+    m_Counts[sizeClass][bucket].fetch_add(1, std::memory_order_relaxed);
+    m_Bytes[sizeClass][bucket].fetch_add(size, std::memory_order_relaxed);
+}
+
+void MEM_SENTRY::lifetime::Histogram::Reset() noexcept {
+    for (size_t i = 0; i < constants::SNAPSHOT_SIZE_CLASSES; ++i) {
+        for (size_t j = 0; j < constants::LIFETIME_BUCKETS; ++j) {
+            m_Counts[i][j].store(0, std::memory_order_relaxed);
+            m_Bytes[i][j].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+MEM_SENTRY::lifetime::LifetimeReport::LifetimeReport(const char* heapName)
+    : m_name(heapName), m_BucketCounts{}, m_BucketBytes{}, m_TotalCount(0), m_TotalBytes(0) {
+}
+
+void MEM_SENTRY::lifetime::LifetimeReport::Assign(const Histogram* histogram) {
+    m_Entries.clear();
+
+    for (uint32_t j = 0; j < constants::LIFETIME_BUCKETS; ++j) {
+        m_BucketCounts[j] = 0;
+        m_BucketBytes[j] = 0;
+    }
+
+    m_TotalCount = 0;
+    m_TotalBytes = 0;
+
+    if (!histogram) return;
+
+    // cells are visited in (size class, bucket) order, so the result is already sorted.
+    for (uint32_t i = 0; i < constants::SNAPSHOT_SIZE_CLASSES; ++i) {
+        for (uint32_t j = 0; j < constants::LIFETIME_BUCKETS; ++j) {
+            uint64_t count = histogram->GetCount(i, j);
+            if (!count) continue;
+
+            uint64_t bytes = histogram->GetBytes(i, j);
+
+            m_Entries.push_back({i, j, count, bytes});
+            m_BucketCounts[j] += count;
+            m_BucketBytes[j] += bytes;
+            m_TotalCount += count;
+            m_TotalBytes += bytes;
+        }
+    }
+}
+
+uint32_t MEM_SENTRY::lifetime::LifetimeReport::MedianBucket(uint32_t sizeClass) const noexcept {
+    uint64_t bytes[constants::LIFETIME_BUCKETS] = {};
+    uint64_t total = 0;
+
+    for (const LifetimeEntry& entry : m_Entries) {
+        if (sizeClass != constants::SNAPSHOT_SIZE_CLASSES && entry.m_SizeClass != sizeClass) continue;
+
+        bytes[entry.m_Bucket] += entry.m_Bytes;
+        total += entry.m_Bytes;
+    }
+
+    uint64_t seen = 0;
+    for (uint32_t j = 0; j < constants::LIFETIME_BUCKETS; ++j) {
+        seen += bytes[j];
+        if (total && seen * 2 >= total) {
+            return j;
+        }
+    }
+
+    return constants::LIFETIME_BUCKETS;
+}
+
+void MEM_SENTRY::lifetime::LifetimeReport::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Lifetimes: %s ===\n", m_name);
+    std::fprintf(out, "%-14s %12s %16s %8s\n", "Lifetime", "Frees", "Bytes", "Bytes %");
+
+    for (uint32_t j = 0; j < constants::LIFETIME_BUCKETS; ++j) {
+        if (!m_BucketCounts[j]) continue;
+
+        std::fprintf(out, "%-14s %12" PRIu64 " %16" PRIu64 " %7.1f%%\n", BucketName(j),
+            m_BucketCounts[j], m_BucketBytes[j], m_TotalBytes ? 100.0 * m_BucketBytes[j] / m_TotalBytes : 0.0);
+    }
+
+    std::fprintf(out, "%-14s %12" PRIu64 " %16" PRIu64 "\n", "Total", m_TotalCount, m_TotalBytes);
+
+    std::fprintf(out, "%-14s %12s %16s %16s\n", "Size Class", "Frees", "Bytes", "Median Lifetime");
+
+    size_t i = 0;
+    while (i < m_Entries.size()) {
+        uint32_t sizeClass = m_Entries[i].m_SizeClass;
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+
+        for (; i < m_Entries.size() && m_Entries[i].m_SizeClass == sizeClass; ++i) {
+            count += m_Entries[i].m_Count;
+            bytes += m_Entries[i].m_Bytes;
+        }
+
+        std::fprintf(out, "<= %-11" PRIu64 " %12" PRIu64 " %16" PRIu64 " %16s\n",
+            uint64_t(1) << sizeClass, count, bytes, BucketName(MedianBucket(sizeClass)));
+    }
+}
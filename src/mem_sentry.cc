@@ -1,10 +1,24 @@
 #include <assert.h>
+#include <cstdio>
 #include <cstdint>
+#include <cstring>
+#include <malloc.h>
 #include <new>
 
 #include "mem_sentry/heap.h"
 #include "mem_sentry/alloc_header.h"
 #include "mem_sentry/constants.h"
+#include "mem_sentry/registry.h"
+#include "mem_sentry/guard_pages.h"
+#include "mem_sentry/quarantine.h"
+#include "mem_sentry/poison.h"
+#include "mem_sentry/canary.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/pool.h"
+#include "mem_sentry/sites.h"
+#include "mem_sentry/context.h"
+#include "mem_sentry/threads.h"
+#include "mem_sentry/lifetime.h"
 
 // ============================================================================
 // INTERNAL HELPER FUNCTIONS
@@ -24,14 +38,71 @@
 void set_alloc_header(size_t size, size_t alignment, char* originalAddr,
     MEM_SENTRY::alloc_header::AllocHeader* pHeader, MEM_SENTRY::heap::Heap *pHeap){
 
-    pHeader->p_Heap = pHeap;
+    pHeader->m_HeapId = pHeap->GetId();
     pHeader->m_Size = size;
     pHeader->m_Alignment = alignment; 
     pHeader->m_Signature = MEM_SENTRY::constants::MEMSYSTEM_SIGNATURE;
     pHeader->m_AllocId = pHeap->GetNextId();
+    pHeader->m_Flags = 0;
+    pHeader->m_CanarySize = 0;
+    pHeader->m_CanarySeed = 0;
+    pHeader->m_ScrubReported = 0;
+    pHeader->m_SiteId = 0;
+    pHeader->m_ContextId = MEM_SENTRY::context::Current();
+    pHeader->m_ThreadIndex = MEM_SENTRY::threads::Current();
+    pHeader->m_Timestamp = pHeap->ProfilesLifetimes() ? MEM_SENTRY::lifetime::Now() : 0;
     pHeader->p_OriginalAddress = originalAddr;
 }
 
+/**
+ * @brief Creates a block placed against a guard page (see guard::Allocate()).
+ * Layout: [Guard?] [Header] [User Data] [Slack] [Guard?]
+ * There are no canaries: the guard page (and the slack check) replaces them.
+ *
+ * @param size Bytes requested by the user.
+ * @param alignment Alignment requirement, 0 for the default one.
+ * @param mode Guard placement of the heap.
+ * @param pHeap The heap the allocation will belong to.
+ *
+ * @return AllocHeader* Header of the new block, not yet added to the heap.
+ */
+MEM_SENTRY::alloc_header::AllocHeader* sentry_create_guarded(size_t size, size_t alignment, MEM_SENTRY::guard::GuardMode mode,
+    MEM_SENTRY::heap::Heap *pHeap){
+
+    void* base = nullptr;
+    char* pMem = (char*) MEM_SENTRY::guard::Allocate(size, alignment, mode, &base);
+
+    if(!pMem)
+        return nullptr;
+
+    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) (
+        pMem - sizeof(MEM_SENTRY::alloc_header::AllocHeader)
+    );
+
+    set_alloc_header(size, alignment, (char*)base, pHeader, pHeap);
+
+    // GuardMode values match the ALLOC_FLAG_GUARD_* bits.
+    pHeader->m_Flags = (uint8_t)mode;
+
+    if(MEM_SENTRY::poison::GetAllocFill())
+        MEM_SENTRY::poison::Fill(pMem, size, MEM_SENTRY::constants::ALLOC_FILL_BYTE);
+
+    return pHeader;
+}
+
+/**
+ * @brief Gets the backing memory of a tracked block from malloc.
+ * Inside a BypassScope, so an interposed malloc (see interpose.h) doesn't track it again.
+ *
+ * @param size Bytes to allocate.
+ *
+ * @return void* The raw block, nullptr if out of memory.
+ */
+void* sentry_backend_malloc(size_t size){
+    MEM_SENTRY::interpose::BypassScope bypass;
+    return malloc(size);
+}
+
 /**
  * @brief Calculates a valid alignment size.
  * Ensures the requested alignment is a power of 2 and is at least as large
@@ -60,22 +131,34 @@ size_t calculate_aligned_memory_size(std::align_val_t alignment){
 // ============================================================================
 
 /**
- * @brief Allocates standard (unaligned/default aligned) memory.
- * Layout: [Header] [User Data] [Footer]
+ * @brief Allocates tracked memory, aligned or not.
+ * Layout: [Padding?] [Front Canary] [Header] [User Data (Aligned)] [Back Canary]
+ * Uses pointer arithmetic to guarantee the user data starts on the requested boundary.
  * 
  * @param size Bytes requested by the user.
- * @param pHeap The heap to track this allocation.
+ * @param alignment Alignment requirement (must be power of 2), 0 for the default
+ * alignment of malloc.
+ * @param pHeap The heap the allocation will belong to.
  * 
- * @return void* Pointer to the start of the user data.
+ * @return AllocHeader* Header of the new block, not yet added to the heap
+ * (nullptr if the backend is out of memory).
  */
-void* sentry_allocate(size_t size, MEM_SENTRY::heap::Heap *pHeap){
+MEM_SENTRY::alloc_header::AllocHeader* sentry_create_block(size_t size, size_t alignment, MEM_SENTRY::heap::Heap *pHeap){
     if(size == 0) 
         size = 1;
-    
-    size_t total_requested_memory = size + sizeof(MEM_SENTRY::alloc_header::AllocHeader) + sizeof(int);
+
+    // the header can't record larger alignments, which guard::Free() needs to unmap the block.
+    MEM_SENTRY::guard::GuardMode guardMode = pHeap->GetGuardMode();
+    if(guardMode != MEM_SENTRY::guard::GuardMode::None && alignment <= MEM_SENTRY::constants::GUARD_MAX_ALIGNMENT)
+        return sentry_create_guarded(size, alignment, guardMode, pHeap);
+
+    const size_t header_size = sizeof(MEM_SENTRY::alloc_header::AllocHeader);
+    const size_t canary_size = MEM_SENTRY::canary::GetCanarySize();
+
+    size_t total_requested_memory = alignment + canary_size + header_size + size + canary_size;
     
     void* ptr;
-    while ((ptr = malloc(total_requested_memory)) == nullptr){
+    while ((ptr = sentry_backend_malloc(total_requested_memory)) == nullptr){
         std::new_handler nh = std::get_new_handler();
 
         if(nh){
@@ -88,88 +171,122 @@ void* sentry_allocate(size_t size, MEM_SENTRY::heap::Heap *pHeap){
     if(!ptr) 
         return nullptr;
 
-    char* pMem = (char *)ptr;
+    char *pOriginalMem = (char *) ptr;
+
+    // canary_size is a multiple of 16, so without explicit alignment the data keeps malloc's.
+    uintptr_t data_addr = (uintptr_t) pOriginalMem + canary_size + header_size;
 
-    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) pMem;
-    
-    set_alloc_header(size, 0, (char*)pHeader, pHeader, pHeap);
-    
-    pHeap->AddAllocation(pHeader);
-    
-    void *pStartBlock = pMem + sizeof(MEM_SENTRY::alloc_header::AllocHeader);
-    
-    int *pEndMarker = (int*) ((char*) pStartBlock + size);
+    if(alignment){
+        // the alignment must be power of 2, which is gauranteed via `calculate_aligned_memory_size()`
+        size_t mask = alignment - 1;
+        data_addr = (data_addr + mask) & ~mask;
+    }
 
-    *pEndMarker = MEM_SENTRY::constants::MEMSYSTEM_ENDMARKER;
+    char* pMem = (char*) data_addr;
 
-    return pStartBlock;
+    // backward header_size bytes to get the header address.
+    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) (pMem - header_size);
+
+    set_alloc_header(size, alignment, pOriginalMem, pHeader, pHeap);
+
+    pHeader->m_CanarySize = (uint8_t)canary_size;
+    pHeader->m_CanarySeed = MEM_SENTRY::canary::NextSeed();
+    MEM_SENTRY::canary::Write(pHeader);
+
+    if(MEM_SENTRY::poison::GetAllocFill())
+        MEM_SENTRY::poison::Fill(pMem, size, MEM_SENTRY::constants::ALLOC_FILL_BYTE);
+
+    return pHeader;
 }
 
 /**
- * @brief Allocates aligned memory.
- * Layout: [Padding?] [Header] [User Data (Aligned)] [Footer] [?Padding]
- * Uses pointer arithmetic to guarantee the user data starts on the requested boundary.
+ * @brief Allocates tracked memory, aligned or not.
  * 
  * @param size Bytes requested by the user.
- * @param alignment Alignment requirement (must be power of 2).
+ * @param alignment Alignment requirement (must be power of 2), 0 for the default one.
  * @param pHeap The heap to track this allocation.
+ * @param siteId Call site of the allocation (see sites.h), 0 if untagged.
  * 
- * @return void* Pointer to the aligned user data.
+ * @return void* Pointer to the user data.
  */
-void* sentry_allocate_aligned(size_t size, size_t alignment, MEM_SENTRY::heap::Heap *pHeap){
-    if(size == 0) 
-        size = 1;
-
-    uint16_t header_size = sizeof(MEM_SENTRY::alloc_header::AllocHeader);
-    size_t total_requested_memory = size + alignment + header_size + sizeof(int); // int for the signature at the end of data.
-    
-    void* ptr;
-    while ((ptr = malloc(total_requested_memory)) == nullptr){
-        std::new_handler nh = std::get_new_handler();
-
-        if(nh){
-            nh();
-        } else {
-            break;
-        }
-    }
+void* sentry_allocate_block(size_t size, size_t alignment, MEM_SENTRY::heap::Heap *pHeap, uint32_t siteId = 0){
+    MEM_SENTRY::alloc_header::AllocHeader* pHeader = sentry_create_block(size, alignment, pHeap);
 
-    if(!ptr) 
+    if(!pHeader)
         return nullptr;
 
-    char *pOriginalMem = (char *) ptr;
+    pHeader->m_SiteId = siteId;
+    MEM_SENTRY::context::OnAlloc(pHeader);
+    MEM_SENTRY::threads::OnAlloc(pHeader);
 
-    uintptr_t rawAddr = (uintptr_t) pOriginalMem;
+    pHeap->AddAllocation(pHeader);
 
-    size_t data_size = size + sizeof(int); // data + signature.
+    return pHeader + 1;
+}
 
-    uintptr_t potential_data_start = rawAddr + header_size; 
+/**
+ * @brief Allocates standard (unaligned/default aligned) memory.
+ * 
+ * @param size Bytes requested by the user.
+ * @param pHeap The heap to track this allocation.
+ * 
+ * @return void* Pointer to the start of the user data.
+ */
+void* sentry_allocate(size_t size, MEM_SENTRY::heap::Heap *pHeap){
+    return sentry_allocate_block(size, 0, pHeap);
+}
 
-    // the alignment must be power of 2, which is gauranteed via `calculate_aligned_memory_size()`
-    size_t mask = alignment - 1;
-    uintptr_t aligned_data_addr = (potential_data_start + mask) & ~mask;
-    
-    char* pMem = (char*) aligned_data_addr;
+/**
+ * @brief Allocates aligned memory.
+ * 
+ * @param size Bytes requested by the user.
+ * @param alignment Alignment requirement (must be power of 2).
+ * @param pHeap The heap to track this allocation.
+ * 
+ * @return void* Pointer to the aligned user data.
+ */
+void* sentry_allocate_aligned(size_t size, size_t alignment, MEM_SENTRY::heap::Heap *pHeap){
+    return sentry_allocate_block(size, alignment, pHeap);
+}
 
-    // add end signature at the end.
-    int* signature_addr = (int*)(pMem + size);
-    *signature_addr = MEM_SENTRY::constants::MEMSYSTEM_ENDMARKER;
+void sentry_release_block(MEM_SENTRY::alloc_header::AllocHeader *pHeader);
 
-    // backward header_size bytes to get the header address.
-    char* header_addr = (char*)(pMem - header_size); 
-    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) header_addr;
+/**
+ * @brief Checks the canaries of a tracked block, unlinks it from its heap and releases it.
+ *
+ * @param pHeader Header of the block (signature already checked).
+ * @param pHeap The heap currently tracking the block.
+ */
+void sentry_free_tracked(MEM_SENTRY::alloc_header::AllocHeader *pHeader, MEM_SENTRY::heap::Heap *pHeap){
+    /*
+        make sure the canaries (or the guard slack) are intact to catch writes beyond the array.
+    */
+    MEM_SENTRY::canary::Status status = MEM_SENTRY::canary::Check(pHeader);
+    if(status != MEM_SENTRY::canary::Status::Ok){
+        std::printf("Error: allocation #%u (%u bytes) corrupted: %s\n",
+            pHeader->m_AllocId, pHeader->m_Size, MEM_SENTRY::canary::StatusName(status));
+    }
+    assert(status == MEM_SENTRY::canary::Status::Ok);
 
-    set_alloc_header(size, alignment, pOriginalMem, pHeader, pHeap);
+    MEM_SENTRY::context::OnFree(pHeader);
+    MEM_SENTRY::threads::OnFree(pHeader);
 
-    pHeap->AddAllocation(pHeader);
+    if(pHeader->m_Timestamp){
+        pHeap->RecordLifetime(pHeader, MEM_SENTRY::lifetime::Now());
+    }
 
-    return pMem;
+    pHeap->RemoveAlloc(pHeader);
+
+    // poisoned and held back for a while, so writes after free can be detected.
+    sentry_release_block(pHeader);
 }
 
 /**
  * @brief Unified deallocation function.
  * Works for both standard and aligned allocations because it retrieves
  * the 'p_OriginalAddress' from the header.
+ * Regular blocks are released through the per-thread quarantine (see quarantine::Push()),
+ * guarded blocks through the guard page pool.
  * 
  * @param pMem Pointer to the user data to free.
  */
@@ -184,19 +301,127 @@ void sentry_deallocate(void *pMem){
     // to make sure we don't free data that is not allocated by our memory manager.
     assert(pHeader->m_Signature == MEM_SENTRY::constants::MEMSYSTEM_SIGNATURE);
 
-    // mark as freed memory.
+    sentry_free_tracked(pHeader, MEM_SENTRY::registry::HeapOf(pHeader));
+}
+
+/**
+ * @brief Releases the block of a header that was already unlinked from its heap
+ * (marks it freed and hands it to the guard page pool or the quarantine).
+ *
+ * @param pHeader Header of the block, no longer in any heap list.
+ */
+void sentry_release_block(MEM_SENTRY::alloc_header::AllocHeader *pHeader){
     pHeader->m_Signature = MEM_SENTRY::constants::MEMSYSTEM_FREED_SIGNATURE;
 
-    int* pEndMarker = (int*) ((char *)pMem + pHeader->m_Size);
+    // pool slots are reused right away (the freed signature still catches a double delete).
+    if(pHeader->m_Flags & MEM_SENTRY::alloc_header::ALLOC_FLAG_POOLED){
+        MEM_SENTRY::pool::Release(pHeader);
+        return;
+    }
 
-    /*
-        make sure the end marker is with our signature to avoid free beyond the array.
-    */ 
-    assert(*pEndMarker == MEM_SENTRY::constants::MEMSYSTEM_ENDMARKER); 
+    MEM_SENTRY::guard::GuardMode guardMode = (MEM_SENTRY::guard::GuardMode)
+        (pHeader->m_Flags & MEM_SENTRY::alloc_header::ALLOC_FLAG_GUARD_MASK);
 
-    pHeader->p_Heap->RemoveAlloc(pHeader);
+    if(guardMode != MEM_SENTRY::guard::GuardMode::None){
+        MEM_SENTRY::guard::Free(pHeader->p_OriginalAddress, pHeader->m_Size, pHeader->m_Alignment);
+        return;
+    }
 
-    free(pHeader->p_OriginalAddress);
+    MEM_SENTRY::quarantine::Push(pHeader);
+}
+
+/**
+ * @brief Tries to change the size of a tracked block without moving it.
+ * Regular blocks can grow up to the usable size of their malloc chunk (the back
+ * canary moves with the end of the data); guarded and pooled blocks only "resize" to the same size.
+ *
+ * @param pMem Pointer to the user data.
+ * @param newSize New size in bytes.
+ *
+ * @return bool true if the block now holds `newSize` bytes.
+ */
+bool sentry_resize_block(void *pMem, size_t newSize){
+    if(newSize == 0)
+        newSize = 1;
+
+    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) (
+        (char *)pMem - sizeof(MEM_SENTRY::alloc_header::AllocHeader)
+    );
+
+    assert(pHeader->m_Signature == MEM_SENTRY::constants::MEMSYSTEM_SIGNATURE);
+
+    if(newSize == pHeader->m_Size)
+        return true;
+
+    if(newSize > UINT32_MAX || (pHeader->m_Flags & (MEM_SENTRY::alloc_header::ALLOC_FLAG_GUARD_MASK
+        | MEM_SENTRY::alloc_header::ALLOC_FLAG_POOLED)))
+        return false;
+
+    size_t offset = (size_t)((char*)pMem - (char*)pHeader->p_OriginalAddress);
+    size_t usable = malloc_usable_size(pHeader->p_OriginalAddress);
+
+    if(offset + newSize + pHeader->m_CanarySize > usable)
+        return false;
+
+    size_t oldSize = pHeader->m_Size;
+
+    // the back canary is rewritten under the heap lock, so the scrubber never sees it half moved.
+    MEM_SENTRY::registry::HeapOf(pHeader)->ResizeAlloc(pHeader, (uint32_t)newSize, MEM_SENTRY::canary::Write);
+    MEM_SENTRY::context::OnResize(pHeader, (uint32_t)oldSize);
+    MEM_SENTRY::threads::OnResize(pHeader, (uint32_t)oldSize);
+
+    if(newSize > oldSize && MEM_SENTRY::poison::GetAllocFill())
+        MEM_SENTRY::poison::Fill((char*)pMem + oldSize, newSize - oldSize, MEM_SENTRY::constants::ALLOC_FILL_BYTE);
+
+    return true;
+}
+
+/**
+ * @brief Resizes a tracked block, in place when possible.
+ * Otherwise the data is copied to a new block that takes the old one's place in the
+ * heap list (same alloc id, one relink) and the old block is released like a delete.
+ *
+ * @param pMem Pointer to the user data (must not be null).
+ * @param newSize New size in bytes (must not be 0).
+ *
+ * @return void* Pointer to the resized data, nullptr if out of memory (pMem is untouched).
+ */
+void* sentry_realloc_block(void *pMem, size_t newSize){
+    if(sentry_resize_block(pMem, newSize))
+        return pMem;
+
+    MEM_SENTRY::alloc_header::AllocHeader *pOld = (MEM_SENTRY::alloc_header::AllocHeader *) pMem - 1;
+
+    MEM_SENTRY::canary::Status status = MEM_SENTRY::canary::Check(pOld);
+    if(status != MEM_SENTRY::canary::Status::Ok){
+        std::printf("Error: allocation #%u (%u bytes) corrupted: %s\n",
+            pOld->m_AllocId, pOld->m_Size, MEM_SENTRY::canary::StatusName(status));
+    }
+    assert(status == MEM_SENTRY::canary::Status::Ok);
+
+    MEM_SENTRY::heap::Heap* pHeap = MEM_SENTRY::registry::HeapOf(pOld);
+
+    MEM_SENTRY::alloc_header::AllocHeader *pNew = sentry_create_block(newSize, pOld->m_Alignment, pHeap);
+    if(!pNew)
+        return nullptr;
+
+    // the moved block keeps its identity (and, for adopted blocks, its registry reference).
+    pNew->m_AllocId = pOld->m_AllocId;
+    pNew->m_HeapId = pOld->m_HeapId;
+    pNew->m_SiteId = pOld->m_SiteId;
+    pNew->m_ContextId = pOld->m_ContextId;
+    pNew->m_ThreadIndex = pOld->m_ThreadIndex;
+    pNew->m_Timestamp = pOld->m_Timestamp;
+    MEM_SENTRY::context::OnResize(pNew, pOld->m_Size);
+    MEM_SENTRY::threads::OnResize(pNew, pOld->m_Size);
+
+    std::memcpy(pNew + 1, pMem, pOld->m_Size < pNew->m_Size ? pOld->m_Size : pNew->m_Size);
+
+    pHeap->RelinkAlloc(pOld, pNew);
+
+    sentry_release_block(pOld);
+
+    return pNew + 1;
 }
 
 // ============================================================================
@@ -219,7 +444,7 @@ void* operator new(size_t size, MEM_SENTRY::heap::Heap *pHeap) {
 }
 
 void* operator new(size_t size) {
-    return ::operator new(size, MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+    return ::operator new(size, MEM_SENTRY::heap::CurrentHeap());
 }    
 
 void operator delete (void *pMem) noexcept {
@@ -232,7 +457,7 @@ void operator delete (void *pMem) noexcept {
 
 // --- Standard Array ---
 void* operator new[](size_t size){
-    return ::operator new(size, MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+    return ::operator new(size, MEM_SENTRY::heap::CurrentHeap());
 }
 
 void operator delete[](void* pMem) noexcept {
@@ -257,7 +482,7 @@ void* operator new(size_t size, std::align_val_t alignment, MEM_SENTRY::heap::He
 }
 
 void* operator new(size_t size, std::align_val_t alignment){
-    return ::operator new(size, alignment, MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+    return ::operator new(size, alignment, MEM_SENTRY::heap::CurrentHeap());
 }
 
 void  operator delete(void* pMem, std::align_val_t al) noexcept{
@@ -285,7 +510,7 @@ void* operator new(std::size_t size, const std::nothrow_t& tag) noexcept {
     if(size == 0)  
         size = 1;
 #if MEM_SENTRY_ENABLE
-    return sentry_allocate(size, MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+    return sentry_allocate(size, MEM_SENTRY::heap::CurrentHeap());
 #else
     return malloc(size);
 #endif
@@ -298,7 +523,7 @@ void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
 void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t& tag) noexcept {
     size_t alignment_size = calculate_aligned_memory_size(al);
 #if MEM_SENTRY_ENABLE
-    return sentry_allocate_aligned(size, alignment_size, MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+    return sentry_allocate_aligned(size, alignment_size, MEM_SENTRY::heap::CurrentHeap());
 #else
     return std::aligned_alloc(size, alignment_size);
 #endif
@@ -346,4 +571,171 @@ void operator delete(void* ptr, std::size_t sz, std::align_val_t al) noexcept {
 
 void operator delete[](void* ptr, std::size_t sz, std::align_val_t al) noexcept {
     ::operator delete[](ptr, al);
-}
\ No newline at end of file
+}
+// ============================================================================
+// RESIZING
+// ============================================================================
+
+bool sentry_resize_in_place(void* pMem, size_t newSize) noexcept {
+    if(!pMem)
+        return false;
+#if MEM_SENTRY_ENABLE
+    return sentry_resize_block(pMem, newSize);
+#else
+    return newSize <= malloc_usable_size(pMem);
+#endif
+}
+
+void* sentry_realloc(void* pMem, size_t newSize, MEM_SENTRY::heap::Heap* pHeap) noexcept {
+#if MEM_SENTRY_ENABLE
+    if(!pMem){
+        if(!pHeap)
+            pHeap = MEM_SENTRY::heap::CurrentHeap();
+
+        return sentry_allocate(newSize, pHeap);
+    }
+
+    if(newSize == 0){
+        sentry_deallocate(pMem);
+        return nullptr;
+    }
+
+    return sentry_realloc_block(pMem, newSize);
+#else
+    if(newSize == 0){
+        free(pMem);
+        return nullptr;
+    }
+
+    return realloc(pMem, newSize);
+#endif
+}
+
+// ============================================================================
+// SIZED RELEASE
+// ============================================================================
+
+void sentry_deallocate_sized(void* pMem, size_t size) noexcept {
+#if MEM_SENTRY_ENABLE
+    if(!pMem)
+        return;
+
+    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) pMem - 1;
+
+    assert(pHeader->m_Signature == MEM_SENTRY::constants::MEMSYSTEM_SIGNATURE);
+    assert(pHeader->m_Size == (size ? size : 1) && "sized deallocation doesn't match the allocation size");
+    (void)size;
+
+    sentry_free_tracked(pHeader, MEM_SENTRY::registry::HeapOf(pHeader));
+#else
+    free(pMem);
+#endif
+}
+
+// ============================================================================
+// POOLED ALLOCATION
+// ============================================================================
+
+void* sentry_allocate_pooled(MEM_SENTRY::pool::Pool* pPool, MEM_SENTRY::heap::Heap* pHeap) noexcept {
+#if MEM_SENTRY_ENABLE
+    if(!pPool)
+        return nullptr;
+
+    if(!pHeap)
+        pHeap = MEM_SENTRY::heap::CurrentHeap();
+
+    // guard pages are the point of a guarded heap: its objects keep their own mappings.
+    if(pHeap->GetGuardMode() != MEM_SENTRY::guard::GuardMode::None)
+        return nullptr;
+
+    char* pSlot = MEM_SENTRY::pool::Acquire(pPool);
+    if(!pSlot)
+        return nullptr;
+
+    char* pMem = pSlot + MEM_SENTRY::pool::DataOffset(pPool);
+    size_t size = MEM_SENTRY::pool::SlotSize(pPool);
+
+    MEM_SENTRY::alloc_header::AllocHeader *pHeader = (MEM_SENTRY::alloc_header::AllocHeader *) pMem - 1;
+
+    set_alloc_header(size, MEM_SENTRY::pool::Alignment(pPool), pSlot, pHeader, pHeap);
+
+    pHeader->m_Flags = MEM_SENTRY::alloc_header::ALLOC_FLAG_POOLED;
+    pHeader->m_CanarySize = (uint8_t)MEM_SENTRY::pool::CanarySize(pPool);
+    pHeader->m_CanarySeed = MEM_SENTRY::canary::NextSeed();
+    MEM_SENTRY::canary::Write(pHeader);
+
+    if(MEM_SENTRY::poison::GetAllocFill())
+        MEM_SENTRY::poison::Fill(pMem, size, MEM_SENTRY::constants::ALLOC_FILL_BYTE);
+
+    MEM_SENTRY::context::OnAlloc(pHeader);
+    MEM_SENTRY::threads::OnAlloc(pHeader);
+    pHeap->AddAllocation(pHeader);
+
+    return pMem;
+#else
+    return nullptr;
+#endif
+}
+
+// ============================================================================
+// CALL SITE TAGGING
+// ============================================================================
+
+void* operator new(size_t size, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site){
+#if MEM_SENTRY_ENABLE
+    if(!pHeap)
+        pHeap = MEM_SENTRY::heap::CurrentHeap();
+
+    void* ptr = sentry_allocate_block(size, 0, pHeap, site.m_Id);
+
+    if(!ptr){
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+#else
+    return malloc(size);
+#endif
+}
+
+void* operator new[](size_t size, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site){
+    return ::operator new(size, pHeap, site);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site){
+    size_t alignment_size = calculate_aligned_memory_size(alignment);
+#if MEM_SENTRY_ENABLE
+    if(!pHeap)
+        pHeap = MEM_SENTRY::heap::CurrentHeap();
+
+    void* ptr = sentry_allocate_block(size, alignment_size, pHeap, site.m_Id);
+
+    if(!ptr){
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+#else
+    return std::aligned_alloc(alignment_size, size);
+#endif
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, MEM_SENTRY::heap::Heap* pHeap, MEM_SENTRY::sites::Site site){
+    return ::operator new(size, alignment, pHeap, site);
+}
+
+void operator delete(void* pMem, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+    ::operator delete(pMem);
+}
+
+void operator delete[](void* pMem, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+    ::operator delete[](pMem);
+}
+
+void operator delete(void* pMem, std::align_val_t alignment, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+    ::operator delete(pMem, alignment);
+}
+
+void operator delete[](void* pMem, std::align_val_t alignment, MEM_SENTRY::heap::Heap*, MEM_SENTRY::sites::Site) noexcept {
+    ::operator delete[](pMem, alignment);
+}
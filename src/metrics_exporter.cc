@@ -0,0 +1,359 @@
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "mem_sentry/metrics_exporter.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/registry.h"
+#include "mem_sentry/threads.h"
+
+namespace {
+    enum Family {
+        FAMILY_BYTES,
+        FAMILY_ALLOCATIONS,
+        FAMILY_HIERARCHY_BYTES,
+        FAMILY_HIERARCHY_ALLOCATIONS,
+        FAMILY_THREAD_ALLOCATIONS,
+        FAMILY_THREAD_FREES,
+        FAMILY_THREAD_REMOTE_FREES,
+        FAMILY_THREAD_ALLOCATED_BYTES
+    };
+
+    /// @brief room kept at the end of the buffer for the mandatory "# EOF" line.
+    constexpr size_t EOF_RESERVE = 8;
+
+    /// @brief longest a client may block a send; the server answers one client at a time.
+    constexpr int SEND_TIMEOUT_MS = 500;
+
+    /**
+     * @brief Escapes a label value (backslash, quote and newline) into `out`.
+     */
+    void escapeLabel(const char* value, char* out, size_t capacity) {
+        size_t used = 0;
+
+        for (; *value && used + 2 < capacity; ++value) {
+            char c = *value;
+
+            if (c == '\\' || c == '"') {
+                out[used++] = '\\';
+                out[used++] = c;
+            } else if (c == '\n') {
+                out[used++] = '\\';
+                out[used++] = 'n';
+            } else {
+                out[used++] = c;
+            }
+        }
+
+        out[used] = '\0';
+    }
+
+    bool writeAll(int fd, const char* data, size_t length) {
+        while (length) {
+            ssize_t written = ::write(fd, data, length);
+            if (written <= 0) return false;
+            data += written;
+            length -= (size_t)written;
+        }
+        return true;
+    }
+}
+
+MEM_SENTRY::exporter::MetricsExporter::MetricsExporter(size_t capacity)
+    : m_Capacity(capacity), m_Length(0), m_Stop(false), m_ListenFd(-1), m_ThreadMetrics(false) {
+    p_Buffer = (char*) interpose::UntrackedMalloc(capacity);
+
+    if (!p_Buffer) {
+        throw std::bad_alloc();
+    }
+
+    m_Path[0] = '\0';
+    m_TmpPath[0] = '\0';
+}
+
+MEM_SENTRY::exporter::MetricsExporter::~MetricsExporter() {
+    Stop();
+    std::free(p_Buffer);
+}
+
+bool MEM_SENTRY::exporter::MetricsExporter::append(size_t& offset, const char* fmt, ...) {
+    if (offset + EOF_RESERVE >= m_Capacity) {
+        return false;
+    }
+
+    size_t room = m_Capacity - EOF_RESERVE - offset;
+
+    va_list args;
+    va_start(args, fmt);
+    int written = std::vsnprintf(p_Buffer + offset, room, fmt, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)written >= room) {
+        return false;
+    }
+
+    offset += (size_t)written;
+    return true;
+}
+
+bool MEM_SENTRY::exporter::MetricsExporter::appendFamily(size_t& offset, const char* name, const char* help, int family) {
+    bool ok = append(offset, "# TYPE %s gauge\n# HELP %s %s\n", name, name, help);
+
+    registry::ForEach([&](heap::Heap* heap) {
+        if (!ok) return;
+
+        char label[2 * 100];
+        escapeLabel(heap->GetName(), label, sizeof(label));
+
+        unsigned long long value = 0;
+        switch (family) {
+            case FAMILY_BYTES:                  value = (unsigned long long)heap->GetTotal(); break;
+            case FAMILY_ALLOCATIONS:            value = (unsigned long long)heap->CountAllocations(); break;
+            case FAMILY_HIERARCHY_BYTES:        value = heap->GetTotalHH(); break;
+            case FAMILY_HIERARCHY_ALLOCATIONS:  value = heap->CountAllocationsHH(); break;
+        }
+
+        ok = append(offset, "%s{heap=\"%s\",id=\"%u\"} %llu\n", name, label, (unsigned)heap->GetId(), value);
+    });
+
+    return ok;
+}
+
+bool MEM_SENTRY::exporter::MetricsExporter::appendThreadFamily(size_t& offset, const char* name, const char* help, int family) {
+    bool ok = append(offset, "# TYPE %s counter\n# HELP %s %s\n", name, name, help);
+
+    uint32_t count = threads::Count();
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        threads::ThreadStats stats = threads::GetStats((uint16_t)i);
+
+        if (!stats.m_Allocs && !stats.m_Frees) continue;
+
+        unsigned long long value = 0;
+        switch (family) {
+            case FAMILY_THREAD_ALLOCATIONS:     value = stats.m_Allocs; break;
+            case FAMILY_THREAD_FREES:           value = stats.m_Frees; break;
+            case FAMILY_THREAD_REMOTE_FREES:    value = stats.m_RemoteFrees; break;
+            case FAMILY_THREAD_ALLOCATED_BYTES: value = stats.m_AllocatedBytes; break;
+        }
+
+        ok = append(offset, "%s_total{thread=\"%u\",tid=\"%d\"} %llu\n", name, i, (int)stats.m_Tid, value);
+    }
+
+    return ok;
+}
+
+size_t MEM_SENTRY::exporter::MetricsExporter::formatLocked() {
+    size_t offset = 0;
+
+    bool ok = appendFamily(offset, "memsentry_heap_bytes",
+                           "Bytes currently allocated on the heap.", FAMILY_BYTES)
+           && appendFamily(offset, "memsentry_heap_allocations",
+                           "Live allocations tracked by the heap.", FAMILY_ALLOCATIONS)
+           && appendFamily(offset, "memsentry_heap_hierarchy_bytes",
+                           "Bytes allocated across the heaps reachable from the heap.", FAMILY_HIERARCHY_BYTES)
+           && appendFamily(offset, "memsentry_heap_hierarchy_allocations",
+                           "Live allocations across the heaps reachable from the heap.", FAMILY_HIERARCHY_ALLOCATIONS);
+
+    if (ok && m_ThreadMetrics.load(std::memory_order_relaxed)) {
+        ok = appendThreadFamily(offset, "memsentry_thread_allocations",
+                                "Tracked blocks allocated by the thread.", FAMILY_THREAD_ALLOCATIONS)
+          && appendThreadFamily(offset, "memsentry_thread_frees",
+                                "Tracked blocks freed by the thread.", FAMILY_THREAD_FREES)
+          && appendThreadFamily(offset, "memsentry_thread_remote_frees",
+                                "Frees by the thread of blocks another thread allocated.", FAMILY_THREAD_REMOTE_FREES)
+          && appendThreadFamily(offset, "memsentry_thread_allocated_bytes",
+                                "User bytes allocated by the thread.", FAMILY_THREAD_ALLOCATED_BYTES);
+    }
+
+    if (!ok) {
+        std::printf("Error: metrics buffer too small (%zu bytes)\n", m_Capacity);
+        m_Length = 0;
+        return 0;
+    }
+
+    // the EOF line always fits: append() keeps EOF_RESERVE bytes free.
+    std::memcpy(p_Buffer + offset, "# EOF\n", 6);
+    offset += 6;
+    p_Buffer[offset] = '\0';
+
+    m_Length = offset;
+    return m_Length;
+}
+
+size_t MEM_SENTRY::exporter::MetricsExporter::Format() {
+    std::lock_guard<std::mutex> lock(m_FormatMutex);
+    return formatLocked();
+}
+
+void MEM_SENTRY::exporter::MetricsExporter::writeFile() {
+    // the lock is held until the buffer is written out, so Format() can't overwrite it.
+    std::lock_guard<std::mutex> lock(m_FormatMutex);
+    size_t length = formatLocked();
+
+    if (!length) return;
+
+    int fd = ::open(m_TmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::printf("Error: can't open metrics file %s\n", m_TmpPath);
+        return;
+    }
+
+    bool ok = writeAll(fd, p_Buffer, length);
+    ::close(fd);
+
+    if (!ok || ::rename(m_TmpPath, m_Path) != 0) {
+        std::printf("Error: can't write metrics file %s\n", m_Path);
+    }
+}
+
+void MEM_SENTRY::exporter::MetricsExporter::fileLoop(std::chrono::milliseconds interval) {
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        writeFile();
+
+        std::unique_lock<std::mutex> lock(m_WaitMutex);
+        m_WaitCv.wait_for(lock, interval, [this] { return m_Stop.load(std::memory_order_acquire); });
+    }
+}
+
+void MEM_SENTRY::exporter::MetricsExporter::serveClient(int clientFd) {
+    // the request itself is irrelevant: drain what is there and answer.
+    char request[1024];
+    pollfd pfd{clientFd, POLLIN, 0};
+    if (::poll(&pfd, 1, 100) > 0) {
+        (void)::read(clientFd, request, sizeof(request));
+    }
+
+    std::lock_guard<std::mutex> lock(m_FormatMutex);
+    size_t length = formatLocked();
+
+    char header[256];
+    int headerLength;
+
+    if (length) {
+        headerLength = std::snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n\r\n", length);
+    } else {
+        headerLength = std::snprintf(header, sizeof(header),
+            "HTTP/1.1 500 Internal Server Error\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n");
+    }
+
+    if (writeAll(clientFd, header, (size_t)headerLength) && length) {
+        writeAll(clientFd, p_Buffer, length);
+    }
+}
+
+void MEM_SENTRY::exporter::MetricsExporter::httpLoop() {
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        // poll with a timeout so Stop() is noticed without closing the socket under us.
+        pollfd pfd{m_ListenFd, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        int clientFd = ::accept4(m_ListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+
+        // a client that stops reading must not stall the next scrapes nor Stop().
+        timeval timeout{SEND_TIMEOUT_MS / 1000, (SEND_TIMEOUT_MS % 1000) * 1000};
+        ::setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        serveClient(clientFd);
+        ::close(clientFd);
+    }
+}
+
+bool MEM_SENTRY::exporter::MetricsExporter::StartFile(const char* path, std::chrono::milliseconds interval) {
+    if (m_Thread.joinable() || std::strlen(path) >= sizeof(m_Path)) {
+        return false;
+    }
+
+    std::snprintf(m_Path, sizeof(m_Path), "%s", path);
+    std::snprintf(m_TmpPath, sizeof(m_TmpPath), "%s.tmp", path);
+
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&MetricsExporter::fileLoop, this, interval);
+
+    return true;
+}
+
+bool MEM_SENTRY::exporter::MetricsExporter::StartHttp(uint16_t port) {
+    if (m_Thread.joinable()) {
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, 8) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_ListenFd = fd;
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&MetricsExporter::httpLoop, this);
+
+    return true;
+}
+
+uint16_t MEM_SENTRY::exporter::MetricsExporter::GetPort() const {
+    if (m_ListenFd < 0) {
+        return 0;
+    }
+
+    sockaddr_in addr{};
+    socklen_t length = sizeof(addr);
+
+    if (::getsockname(m_ListenFd, (sockaddr*)&addr, &length) != 0) {
+        return 0;
+    }
+
+    return ntohs(addr.sin_port);
+}
+
+void MEM_SENTRY::exporter::MetricsExporter::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        m_Stop.store(true, std::memory_order_release);
+    }
+    m_WaitCv.notify_all();
+
+    m_Thread.join();
+
+    if (m_ListenFd >= 0) {
+        ::close(m_ListenFd);
+        m_ListenFd = -1;
+    }
+}
@@ -0,0 +1,267 @@
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define MEM_SENTRY_POISON_X86 1
+#else
+    #define MEM_SENTRY_POISON_X86 0
+#endif
+
+#include "mem_sentry/poison.h"
+
+namespace {
+    /// @brief byte fills from this size on are left to memset (see poison_bench).
+    constexpr size_t MEMSET_THRESHOLD = 1024;
+
+    using FillFn = void (*)(uint8_t*, size_t, uint32_t);
+    using VerifyFn = size_t (*)(const uint8_t*, size_t, uint32_t);
+
+    /// @brief byte `i` of the pattern in memory order (patterns are applied by memcpy).
+    inline uint8_t patternByte(uint32_t pattern, size_t i) {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &pattern, sizeof(bytes));
+        return bytes[i & 3];
+    }
+
+    void fillTail(uint8_t* dst, size_t from, size_t size, uint32_t pattern) {
+        for (size_t i = from; i < size; ++i) {
+            dst[i] = patternByte(pattern, i);
+        }
+    }
+
+    size_t verifyTail(const uint8_t* src, size_t from, size_t size, uint32_t pattern) {
+        for (size_t i = from; i < size; ++i) {
+            if (src[i] != patternByte(pattern, i)) return i;
+        }
+        return size;
+    }
+
+    // --- Scalar: 8 bytes at a time ---
+
+    void fillScalar(uint8_t* dst, size_t size, uint32_t pattern) {
+        uint64_t word = (uint64_t(pattern) << 32) | pattern;
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8) {
+            std::memcpy(dst + i, &word, 8);
+        }
+
+        fillTail(dst, i, size, pattern);
+    }
+
+    size_t verifyScalar(const uint8_t* src, size_t size, uint32_t pattern) {
+        uint64_t word = (uint64_t(pattern) << 32) | pattern;
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8) {
+            uint64_t value;
+            std::memcpy(&value, src + i, 8);
+            if (value != word) break;
+        }
+
+        return verifyTail(src, i, size, pattern);
+    }
+
+#if MEM_SENTRY_POISON_X86
+    // --- SSE2: 16 bytes at a time ---
+
+    __attribute__((target("sse2")))
+    void fillSSE2(uint8_t* dst, size_t size, uint32_t pattern) {
+        __m128i value = _mm_set1_epi32((int)pattern);
+        size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            _mm_storeu_si128((__m128i*)(dst + i), value);
+        }
+
+        fillTail(dst, i, size, pattern);
+    }
+
+    __attribute__((target("sse2")))
+    size_t verifySSE2(const uint8_t* src, size_t size, uint32_t pattern) {
+        __m128i value = _mm_set1_epi32((int)pattern);
+        size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(src + i));
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, value));
+
+            if (mask != 0xFFFFu) {
+                return i + (size_t)__builtin_ctz(~mask);
+            }
+        }
+
+        return verifyTail(src, i, size, pattern);
+    }
+
+    // --- AVX2: 64 bytes per iteration ---
+
+    __attribute__((target("avx2")))
+    void fillAVX2(uint8_t* dst, size_t size, uint32_t pattern) {
+        __m256i value = _mm256_set1_epi32((int)pattern);
+        size_t i = 0;
+
+        for (; i + 64 <= size; i += 64) {
+            _mm256_storeu_si256((__m256i*)(dst + i), value);
+            _mm256_storeu_si256((__m256i*)(dst + i + 32), value);
+        }
+
+        for (; i + 32 <= size; i += 32) {
+            _mm256_storeu_si256((__m256i*)(dst + i), value);
+        }
+
+        fillTail(dst, i, size, pattern);
+    }
+
+    __attribute__((target("avx2")))
+    size_t verifyAVX2(const uint8_t* src, size_t size, uint32_t pattern) {
+        __m256i value = _mm256_set1_epi32((int)pattern);
+        size_t i = 0;
+
+        // two vectors per iteration, one branch on the combined result.
+        for (; i + 64 <= size; i += 64) {
+            __m256i lo = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(src + i)), value);
+            __m256i hi = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(src + i + 32)), value);
+
+            if ((unsigned)_mm256_movemask_epi8(_mm256_and_si256(lo, hi)) != 0xFFFFFFFFu) {
+                break;
+            }
+        }
+
+        for (; i + 32 <= size; i += 32) {
+            __m256i block = _mm256_loadu_si256((const __m256i*)(src + i));
+            unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, value));
+
+            if (mask != 0xFFFFFFFFu) {
+                return i + (size_t)__builtin_ctz(~mask);
+            }
+        }
+
+        return verifyTail(src, i, size, pattern);
+    }
+#endif
+
+    bool supported(MEM_SENTRY::poison::Kernel kernel) {
+        switch (kernel) {
+            case MEM_SENTRY::poison::Kernel::Scalar:
+                return true;
+#if MEM_SENTRY_POISON_X86
+            case MEM_SENTRY::poison::Kernel::SSE2:
+                return __builtin_cpu_supports("sse2");
+            case MEM_SENTRY::poison::Kernel::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    MEM_SENTRY::poison::Kernel detect() {
+#if MEM_SENTRY_POISON_X86
+        // may run before the compiler's own CPU probe (e.g. from a static constructor).
+        __builtin_cpu_init();
+#endif
+        if (supported(MEM_SENTRY::poison::Kernel::AVX2)) return MEM_SENTRY::poison::Kernel::AVX2;
+        if (supported(MEM_SENTRY::poison::Kernel::SSE2)) return MEM_SENTRY::poison::Kernel::SSE2;
+        return MEM_SENTRY::poison::Kernel::Scalar;
+    }
+
+    /**
+     * @brief Function pointers of the active kernel.
+     * Constant initialized to the scalar kernel; the CPU is probed on first use.
+     */
+    struct Dispatch {
+        std::atomic<FillFn> m_Fill{fillScalar};
+        std::atomic<VerifyFn> m_Verify{verifyScalar};
+        std::atomic<MEM_SENTRY::poison::Kernel> m_Kernel{MEM_SENTRY::poison::Kernel::Scalar};
+        std::atomic<bool> m_Resolved{false};
+    };
+
+    constinit Dispatch gDispatch;
+    std::atomic<bool> gAllocFill{false};
+
+    void install(MEM_SENTRY::poison::Kernel kernel) {
+        FillFn fill = fillScalar;
+        VerifyFn verify = verifyScalar;
+
+#if MEM_SENTRY_POISON_X86
+        if (kernel == MEM_SENTRY::poison::Kernel::SSE2) {
+            fill = fillSSE2;
+            verify = verifySSE2;
+        } else if (kernel == MEM_SENTRY::poison::Kernel::AVX2) {
+            fill = fillAVX2;
+            verify = verifyAVX2;
+        }
+#endif
+
+        gDispatch.m_Fill.store(fill, std::memory_order_relaxed);
+        gDispatch.m_Verify.store(verify, std::memory_order_relaxed);
+        gDispatch.m_Kernel.store(kernel, std::memory_order_relaxed);
+        gDispatch.m_Resolved.store(true, std::memory_order_release);
+    }
+
+    inline void resolve() {
+        if (!gDispatch.m_Resolved.load(std::memory_order_acquire)) {
+            install(detect());
+        }
+    }
+
+    inline uint32_t broadcast(uint8_t pattern) {
+        return 0x01010101u * pattern;
+    }
+}
+
+void MEM_SENTRY::poison::Fill(void* dst, size_t size, uint8_t pattern) noexcept {
+    // libc memset (rep stosb / non-temporal stores) wins on large single byte fills.
+    if (size >= MEMSET_THRESHOLD) {
+        std::memset(dst, pattern, size);
+        return;
+    }
+
+    Fill32(dst, size, broadcast(pattern));
+}
+
+size_t MEM_SENTRY::poison::Verify(const void* src, size_t size, uint8_t pattern) noexcept {
+    return Verify32(src, size, broadcast(pattern));
+}
+
+void MEM_SENTRY::poison::Fill32(void* dst, size_t size, uint32_t pattern) noexcept {
+    resolve();
+    gDispatch.m_Fill.load(std::memory_order_relaxed)((uint8_t*)dst, size, pattern);
+}
+
+size_t MEM_SENTRY::poison::Verify32(const void* src, size_t size, uint32_t pattern) noexcept {
+    resolve();
+    return gDispatch.m_Verify.load(std::memory_order_relaxed)((const uint8_t*)src, size, pattern);
+}
+
+MEM_SENTRY::poison::Kernel MEM_SENTRY::poison::GetKernel() noexcept {
+    resolve();
+    return gDispatch.m_Kernel.load(std::memory_order_relaxed);
+}
+
+bool MEM_SENTRY::poison::SetKernel(Kernel kernel) noexcept {
+    if (!supported(kernel)) {
+        return false;
+    }
+
+    install(kernel);
+    return true;
+}
+
+const char* MEM_SENTRY::poison::KernelName(Kernel kernel) noexcept {
+    switch (kernel) {
+        case Kernel::SSE2: return "sse2";
+        case Kernel::AVX2: return "avx2";
+        default:           return "scalar";
+    }
+}
+
+void MEM_SENTRY::poison::SetAllocFill(bool enabled) noexcept {
+    gAllocFill.store(enabled, std::memory_order_relaxed);
+}
+
+bool MEM_SENTRY::poison::GetAllocFill() noexcept {
+    return gAllocFill.load(std::memory_order_relaxed);
+}
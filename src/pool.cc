@@ -0,0 +1,315 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "mem_sentry/pool.h"
+#include "mem_sentry/canary.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/interpose.h"
+
+/**
+ * @class Pool
+ * @brief Fixed-size slots carved in chunks, free slots kept in a locked depot.
+ * Threads cache free slots in magazines, so most allocations and frees don't lock.
+ */
+class MEM_SENTRY::pool::Pool {
+public:
+    /// @brief Index of the pool's magazine in every thread.
+    uint32_t m_Index;
+
+    size_t m_Size;
+    size_t m_Alignment;
+    size_t m_CanarySize;
+    size_t m_DataOffset;
+
+    /// @brief Distance between two slots, a multiple of the slot alignment.
+    size_t m_Stride;
+
+    /// @brief Alignment of the chunks (and so of every slot start).
+    size_t m_ChunkAlignment;
+
+    size_t m_Capacity;
+    std::atomic<size_t> m_Carved{0};
+
+    std::mutex m_Lock;
+
+    /// @brief Depot: free slots not cached by any thread, linked through their prefix.
+    void* p_Free = nullptr;
+};
+
+namespace {
+    /**
+     * @struct SlotPrefix
+     * @brief First bytes of every slot: the owner, and the depot link while free.
+     */
+    struct SlotPrefix {
+        MEM_SENTRY::pool::Pool* p_Pool;
+        SlotPrefix* p_Next;
+    };
+
+    static_assert(sizeof(SlotPrefix) % 16 == 0, "slot prefix must keep the canary 16-byte aligned");
+
+    std::atomic<uint32_t> gPoolCount{0};
+
+    /**
+     * @struct Magazine
+     * @brief Free slots of one pool cached by one thread (a LIFO, so the hottest slot is reused).
+     */
+    struct Magazine {
+        char* m_Slots[MEM_SENTRY::constants::POOL_MAGAZINE_SIZE];
+        uint32_t m_Count;
+    };
+
+    /// @brief Set once the thread's magazines are destroyed (trivial, so it outlives them):
+    /// deletes run later by static destructors go to the depot.
+    thread_local bool tMagazinesDestroyed = false;
+
+    size_t roundUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    /**
+     * @brief Carves a new chunk of slots into the depot. Called with the pool locked.
+     * @return bool false if the pool is at capacity or the backend is out of memory.
+     */
+    bool grow(MEM_SENTRY::pool::Pool* pool) {
+        size_t carved = pool->m_Carved.load(std::memory_order_relaxed);
+        size_t count = pool->m_Capacity - carved;
+
+        if (count == 0) {
+            return false;
+        }
+
+        if (count > MEM_SENTRY::constants::POOL_CHUNK_SLOTS) {
+            count = MEM_SENTRY::constants::POOL_CHUNK_SLOTS;
+        }
+
+        char* chunk;
+        {
+            MEM_SENTRY::interpose::BypassScope bypass;
+            chunk = (char*) std::aligned_alloc(pool->m_ChunkAlignment, pool->m_Stride * count);
+        }
+
+        if (!chunk) {
+            return false;
+        }
+
+        // chunks are never returned: slots of live objects must stay valid until exit.
+        for (size_t i = count; i-- > 0;) {
+            SlotPrefix* slot = (SlotPrefix*)(chunk + i * pool->m_Stride);
+            slot->p_Pool = pool;
+            slot->p_Next = (SlotPrefix*)pool->p_Free;
+            pool->p_Free = slot;
+        }
+
+        pool->m_Carved.store(carved + count, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Moves up to `count` free slots from the depot to a magazine.
+     */
+    void refill(MEM_SENTRY::pool::Pool* pool, Magazine& magazine, size_t count) {
+        std::lock_guard<std::mutex> lock(pool->m_Lock);
+
+        while (count--) {
+            if (!pool->p_Free && !grow(pool)) {
+                break;
+            }
+
+            SlotPrefix* slot = (SlotPrefix*)pool->p_Free;
+            pool->p_Free = slot->p_Next;
+            magazine.m_Slots[magazine.m_Count++] = (char*)slot;
+        }
+    }
+
+    /**
+     * @brief Moves the `count` oldest slots of a magazine back to the depot.
+     */
+    void drain(MEM_SENTRY::pool::Pool* pool, Magazine& magazine, size_t count) {
+        std::lock_guard<std::mutex> lock(pool->m_Lock);
+
+        for (size_t i = 0; i < count; ++i) {
+            SlotPrefix* slot = (SlotPrefix*)magazine.m_Slots[i];
+            slot->p_Next = (SlotPrefix*)pool->p_Free;
+            pool->p_Free = slot;
+        }
+
+        magazine.m_Count -= (uint32_t)count;
+        for (size_t i = 0; i < magazine.m_Count; ++i) {
+            magazine.m_Slots[i] = magazine.m_Slots[i + count];
+        }
+    }
+
+    /**
+     * @brief Empties every magazine of a thread into the depots.
+     */
+    void drainAll(Magazine* magazines) {
+        uint32_t pools = gPoolCount.load(std::memory_order_acquire);
+
+        for (uint32_t i = 0; i < pools; ++i) {
+            if (magazines[i].m_Count) {
+                drain(((SlotPrefix*)magazines[i].m_Slots[0])->p_Pool, magazines[i], magazines[i].m_Count);
+            }
+        }
+    }
+
+    /**
+     * @struct ThreadMagazines
+     * @brief One magazine per pool, owned by one thread.
+     * The table is malloc'ed on first use: the pools serve operator new.
+     */
+    struct ThreadMagazines {
+        Magazine* p_Magazines = nullptr;
+
+        ~ThreadMagazines() {
+            tMagazinesDestroyed = true;
+
+            if (p_Magazines) {
+                drainAll(p_Magazines);
+                MEM_SENTRY::interpose::BypassScope bypass;
+                std::free(p_Magazines);
+            }
+        }
+    };
+
+    /**
+     * @brief The calling thread's magazine table, nullptr when it's gone or can't be allocated.
+     */
+    Magazine* threadMagazines() {
+        if (tMagazinesDestroyed) {
+            return nullptr;
+        }
+
+        thread_local ThreadMagazines instance;
+
+        if (!instance.p_Magazines) {
+            MEM_SENTRY::interpose::BypassScope bypass;
+            instance.p_Magazines = (Magazine*) std::calloc(MEM_SENTRY::constants::POOL_MAX_POOLS, sizeof(Magazine));
+        }
+
+        return instance.p_Magazines;
+    }
+}
+
+MEM_SENTRY::pool::Pool* MEM_SENTRY::pool::Create(size_t size, size_t alignment, size_t capacity) {
+    uint32_t index = gPoolCount.load(std::memory_order_relaxed);
+
+    do {
+        if (index >= constants::POOL_MAX_POOLS) {
+            std::printf("Error: cannot create more than %zu object pools\n", constants::POOL_MAX_POOLS);
+            return nullptr;
+        }
+    } while (!gPoolCount.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel));
+
+    void* storage;
+    {
+        interpose::BypassScope bypass;
+        storage = std::malloc(sizeof(Pool));
+    }
+
+    if (!storage) {
+        return nullptr;
+    }
+
+    Pool* pool = new (storage) Pool();
+
+    if (size == 0) {
+        size = 1;
+    }
+
+    // slot starts share the data alignment (at least 16 so the canary and header stay aligned).
+    size_t slotAlignment = alignment > 16 ? alignment : 16;
+
+    pool->m_Index = index;
+    pool->m_Size = size;
+    pool->m_Alignment = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? alignment : 0;
+    pool->m_CanarySize = canary::GetCanarySize();
+    pool->m_DataOffset = roundUp(sizeof(SlotPrefix) + pool->m_CanarySize + sizeof(alloc_header::AllocHeader), slotAlignment);
+    pool->m_Stride = roundUp(pool->m_DataOffset + size + pool->m_CanarySize, slotAlignment);
+    pool->m_ChunkAlignment = slotAlignment;
+    pool->m_Capacity = capacity;
+
+    return pool;
+}
+
+char* MEM_SENTRY::pool::Acquire(Pool* pool) noexcept {
+    Magazine* magazines = threadMagazines();
+
+    if (!magazines) {
+        // late in the thread's life: straight from the depot.
+        Magazine single;
+        single.m_Count = 0;
+        refill(pool, single, 1);
+        return single.m_Count ? single.m_Slots[0] : nullptr;
+    }
+
+    Magazine& magazine = magazines[pool->m_Index];
+
+    if (magazine.m_Count == 0) {
+        refill(pool, magazine, constants::POOL_MAGAZINE_SIZE / 2);
+
+        if (magazine.m_Count == 0) {
+            return nullptr;
+        }
+    }
+
+    return magazine.m_Slots[--magazine.m_Count];
+}
+
+void MEM_SENTRY::pool::Release(alloc_header::AllocHeader* header) noexcept {
+    char* slot = (char*)header->p_OriginalAddress;
+    Pool* pool = ((SlotPrefix*)slot)->p_Pool;
+
+    Magazine* magazines = threadMagazines();
+
+    if (!magazines) {
+        Magazine single;
+        single.m_Slots[0] = slot;
+        single.m_Count = 1;
+        drain(pool, single, 1);
+        return;
+    }
+
+    Magazine& magazine = magazines[pool->m_Index];
+
+    if (magazine.m_Count == constants::POOL_MAGAZINE_SIZE) {
+        drain(pool, magazine, constants::POOL_MAGAZINE_SIZE / 2);
+    }
+
+    magazine.m_Slots[magazine.m_Count++] = slot;
+}
+
+size_t MEM_SENTRY::pool::DataOffset(const Pool* pool) noexcept {
+    return pool->m_DataOffset;
+}
+
+size_t MEM_SENTRY::pool::SlotSize(const Pool* pool) noexcept {
+    return pool->m_Size;
+}
+
+size_t MEM_SENTRY::pool::Alignment(const Pool* pool) noexcept {
+    return pool->m_Alignment;
+}
+
+size_t MEM_SENTRY::pool::CanarySize(const Pool* pool) noexcept {
+    return pool->m_CanarySize;
+}
+
+size_t MEM_SENTRY::pool::GetCapacity(const Pool* pool) noexcept {
+    return pool->m_Capacity;
+}
+
+size_t MEM_SENTRY::pool::CarvedSlots(const Pool* pool) noexcept {
+    return pool->m_Carved.load(std::memory_order_relaxed);
+}
+
+void MEM_SENTRY::pool::Flush() noexcept {
+    Magazine* magazines = threadMagazines();
+
+    if (magazines) {
+        drainAll(magazines);
+    }
+}
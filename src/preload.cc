@@ -0,0 +1,373 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include "mem_sentry/mem_sentry.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/alloc_header.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/registry.h"
+
+/*
+    LD_PRELOAD-able interposer of the libc allocation family (libmemsentry_preload.so).
+
+    Every block handed out here carries an AllocHeader right before the user data:
+    - tracked blocks are regular MemSentry allocations of interpose::GetHeap().
+    - raw blocks (MEMSYSTEM_RAW_SIGNATURE) come straight from libc. They are served
+      inside a BypassScope (MemSentry's own memory, including the backing memory of
+      tracked blocks) and for requests the header can't describe (sizes above 4GB,
+      alignments above MAX_TRACKED_ALIGNMENT).
+    so free() tells them apart from the signature, checked against the rest of the
+    header (kindOf()): the bytes in front of a foreign block can hold anything.
+
+    Limitation: blocks allocated before the interposer was in place are recognized by
+    reading the 64 bytes in front of them. For a chunk libc served with its own mmap
+    (large blocks), those bytes sit before the mapping and the read may fault. Load
+    the interposer with LD_PRELOAD so no such block exists.
+*/
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void  __libc_free(void* ptr);
+}
+
+void* sentry_allocate(size_t size, MEM_SENTRY::heap::Heap *pHeap);
+void* sentry_allocate_aligned(size_t size, size_t alignment, MEM_SENTRY::heap::Heap *pHeap);
+void  sentry_deallocate(void *pMem);
+
+namespace {
+    using MEM_SENTRY::alloc_header::AllocHeader;
+
+    /// @brief largest alignment a tracked block can record (m_Alignment is one byte).
+    constexpr size_t MAX_TRACKED_ALIGNMENT = 128;
+
+    /// @brief alignment of libc's malloc, and of the user data of unaligned blocks.
+    constexpr size_t DEFAULT_ALIGNMENT = 16;
+
+    constexpr uint32_t TRACKED = (uint32_t)MEM_SENTRY::constants::MEMSYSTEM_SIGNATURE;
+    constexpr uint32_t FREED = (uint32_t)MEM_SENTRY::constants::MEMSYSTEM_FREED_SIGNATURE;
+    constexpr uint32_t RAW = (uint32_t)MEM_SENTRY::constants::MEMSYSTEM_RAW_SIGNATURE;
+
+    AllocHeader* headerOf(void* ptr) {
+        return (AllocHeader*)ptr - 1;
+    }
+
+    bool isPowerOf2(size_t value) {
+        return value && (value & (value - 1)) == 0;
+    }
+
+    /**
+     * @brief Tells which path owns `ptr`, trusting a signature only when the rest of
+     * the header is consistent with it.
+     * @return uint32_t TRACKED, RAW or FREED; 0 for a block the interposer didn't allocate.
+     */
+    uint32_t kindOf(void* ptr) {
+        AllocHeader* header = headerOf(ptr);
+        char* base = (char*)header->p_OriginalAddress;
+
+        switch (header->m_Signature) {
+            case TRACKED:
+                // the backing memory starts below the header, and the heap id is live.
+                return base <= (char*)header && header->m_HeapId < MEM_SENTRY::constants::MAX_HEAPS
+                    && MEM_SENTRY::registry::Find(header->m_HeapId) ? TRACKED : 0;
+
+            case FREED:
+                return base <= (char*)header && header->m_HeapId < MEM_SENTRY::constants::MAX_HEAPS ? FREED : 0;
+
+            case RAW: {
+                // rawAllocate() prefixes are a header, or a power of 2 the data is aligned to.
+                if (base > (char*)header) {
+                    return 0;
+                }
+
+                size_t prefix = (size_t)((char*)ptr - base);
+                return prefix == sizeof(AllocHeader) || (isPowerOf2(prefix) && (uintptr_t)ptr % prefix == 0) ? RAW : 0;
+            }
+
+            default:
+                return 0;
+        }
+    }
+
+    /**
+     * @brief libc's own malloc_usable_size (ours is the one the symbol binds to).
+     */
+    size_t libcUsableSize(void* base) {
+        using UsableSizeFn = size_t (*)(void*);
+        static UsableSizeFn usableSize = nullptr;
+
+        if (!usableSize) {
+            MEM_SENTRY::interpose::BypassScope bypass;
+            usableSize = (UsableSizeFn) dlsym(RTLD_NEXT, "malloc_usable_size");
+        }
+
+        return usableSize(base);
+    }
+
+    /**
+     * @brief Allocates an untracked block with a raw header in front of it.
+     * @param alignment Alignment of the user data, a power of 2.
+     */
+    void* rawAllocate(size_t size, size_t alignment) {
+        size_t prefix = sizeof(AllocHeader);
+
+        if (alignment > DEFAULT_ALIGNMENT) {
+            prefix = (prefix + alignment - 1) & ~(alignment - 1);
+        }
+
+        if (size > SIZE_MAX - prefix) {
+            return nullptr;
+        }
+
+        char* base = (char*)(alignment > DEFAULT_ALIGNMENT
+            ? __libc_memalign(alignment, prefix + size)
+            : __libc_malloc(prefix + size));
+
+        if (!base) {
+            return nullptr;
+        }
+
+        AllocHeader* header = headerOf(base + prefix);
+        header->m_Signature = RAW;
+        header->p_OriginalAddress = base;
+
+        return base + prefix;
+    }
+
+    size_t rawUsableSize(void* ptr) {
+        char* base = (char*)headerOf(ptr)->p_OriginalAddress;
+        return libcUsableSize(base) - (size_t)((char*)ptr - base);
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+        if (MEM_SENTRY::interpose::IsBypassed() || size > UINT32_MAX || alignment > MAX_TRACKED_ALIGNMENT) {
+            return rawAllocate(size, alignment);
+        }
+
+        // the reentrancy guard: malloc calls made while tracking the block are raw.
+        MEM_SENTRY::interpose::BypassScope bypass;
+        MEM_SENTRY::heap::Heap* heap = MEM_SENTRY::interpose::GetHeap();
+
+        return alignment > DEFAULT_ALIGNMENT
+            ? sentry_allocate_aligned(size, alignment, heap)
+            : sentry_allocate(size, heap);
+    }
+
+    void release(void* ptr) {
+        AllocHeader* header = headerOf(ptr);
+
+        switch (kindOf(ptr)) {
+            case TRACKED: {
+                MEM_SENTRY::interpose::BypassScope bypass;
+                sentry_deallocate(ptr);
+                break;
+            }
+
+            case RAW:
+                __libc_free(header->p_OriginalAddress);
+                break;
+
+            case FREED: {
+                MEM_SENTRY::interpose::BypassScope bypass;
+                std::printf("Error: double free of allocation #%u (%u bytes)\n", header->m_AllocId, header->m_Size);
+                break;
+            }
+
+            default:
+                // allocated before the interposer was in place.
+                __libc_free(ptr);
+                break;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t size) {
+        AllocHeader* header = headerOf(ptr);
+        uint32_t kind = kindOf(ptr);
+
+        if (kind == TRACKED && size <= UINT32_MAX) {
+            MEM_SENTRY::interpose::BypassScope bypass;
+            return sentry_realloc(ptr, size);
+        }
+
+        if (kind == RAW
+            && (char*)header->p_OriginalAddress + sizeof(AllocHeader) == (char*)ptr) {
+            // unaligned raw block: libc can resize it, header included.
+            char* base = (char*)__libc_realloc(header->p_OriginalAddress, sizeof(AllocHeader) + size);
+            if (!base) {
+                return nullptr;
+            }
+
+            headerOf(base + sizeof(AllocHeader))->p_OriginalAddress = base;
+            return base + sizeof(AllocHeader);
+        }
+
+        if (kind != TRACKED && kind != RAW) {
+            return __libc_realloc(ptr, size);
+        }
+
+        // a tracked block growing past 4GB, or an over-aligned raw block: move it.
+        size_t oldSize = kind == TRACKED ? header->m_Size : rawUsableSize(ptr);
+
+        void* moved = allocate(size, DEFAULT_ALIGNMENT);
+        if (!moved) {
+            return nullptr;
+        }
+
+        std::memcpy(moved, ptr, oldSize < size ? oldSize : size);
+        release(ptr);
+
+        return moved;
+    }
+
+    /// @brief where the exit report goes, -1 when MEMSENTRY_REPORT isn't set.
+    int gReportFd = -1;
+
+    /**
+     * @brief Keeps a private copy of stderr for the exit report: many programs close
+     * their standard streams before the library destructors run.
+     */
+    __attribute__((constructor)) void openReport() {
+        if (std::getenv("MEMSENTRY_REPORT")) {
+            gReportFd = ::fcntl(STDERR_FILENO, F_DUPFD_CLOEXEC, 3);
+        }
+    }
+
+    /**
+     * @brief Prints the live totals of every heap at exit when MEMSENTRY_REPORT is set.
+     */
+    __attribute__((destructor)) void reportAtExit() {
+        if (gReportFd < 0) {
+            return;
+        }
+
+        MEM_SENTRY::interpose::BypassScope bypass;
+
+        MEM_SENTRY::registry::ForEach([](MEM_SENTRY::heap::Heap* heap) {
+            char line[256];
+            int length = std::snprintf(line, sizeof(line),
+                "MemSentry: %s: %d live allocations, %d bytes (%llu allocated, %llu freed)\n",
+                heap->GetName(), heap->CountAllocations(), heap->GetTotal(),
+                (unsigned long long)heap->GetAllocCount(), (unsigned long long)heap->GetFreeCount());
+
+            if (length > 0) {
+                (void)::write(gReportFd, line, (size_t)length < sizeof(line) ? (size_t)length : sizeof(line) - 1);
+            }
+        });
+
+        ::close(gReportFd);
+        gReportFd = -1;
+    }
+}
+
+// ============================================================================
+// INTERPOSED LIBC ALLOCATION FAMILY
+// ============================================================================
+
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    void* ptr = allocate(size, DEFAULT_ALIGNMENT);
+    if (!ptr) errno = ENOMEM;
+    return ptr;
+}
+
+void free(void* ptr) noexcept {
+    if (ptr) release(ptr);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    void* ptr = allocate(total, DEFAULT_ALIGNMENT);
+    if (!ptr) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    std::memset(ptr, 0, total);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    if (!ptr) return malloc(size);
+
+    if (size == 0) {
+        release(ptr);
+        return nullptr;
+    }
+
+    void* moved = reallocate(ptr, size);
+    if (!moved) errno = ENOMEM;
+    return moved;
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) noexcept {
+    if (!isPowerOf2(alignment) || alignment % sizeof(void*) != 0) {
+        return EINVAL;
+    }
+
+    void* ptr = allocate(size, alignment);
+    if (!ptr) return ENOMEM;
+
+    *memptr = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (!isPowerOf2(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    void* ptr = allocate(size, alignment);
+    if (!ptr) errno = ENOMEM;
+    return ptr;
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    // like glibc: any alignment is rounded up to the next power of 2.
+    size_t rounded = DEFAULT_ALIGNMENT;
+    while (rounded < alignment) rounded <<= 1;
+
+    void* ptr = allocate(size, rounded);
+    if (!ptr) errno = ENOMEM;
+    return ptr;
+}
+
+void* valloc(size_t size) noexcept {
+    return memalign((size_t)sysconf(_SC_PAGESIZE), size);
+}
+
+void* pvalloc(size_t size) noexcept {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+size_t malloc_usable_size(void* ptr) noexcept {
+    if (!ptr) return 0;
+
+    switch (kindOf(ptr)) {
+        case TRACKED:
+            return headerOf(ptr)->m_Size;
+        case RAW:
+            return rawUsableSize(ptr);
+        default:
+            return libcUsableSize(ptr);
+    }
+}
+
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "mem_sentry/quarantine.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/poison.h"
+
+namespace {
+    std::atomic<size_t> gCapacity{MEM_SENTRY::constants::QUARANTINE_THREAD_BYTES};
+    std::atomic<uint64_t> gCorruptions{0};
+
+    /// @brief Set once the thread's quarantine is destroyed (trivial, so it outlives it):
+    /// deletes run later by static destructors free directly.
+    thread_local bool tQuarantineDestroyed = false;
+
+    /**
+     * @brief FIFO of quarantined headers owned by one thread.
+     * The ring is malloc'ed on first use: the quarantine serves operator delete.
+     */
+    struct ThreadQuarantine {
+        MEM_SENTRY::alloc_header::AllocHeader** p_Ring = nullptr;
+        size_t m_Head = 0;
+        size_t m_Length = 0;
+        size_t m_Bytes = 0;
+
+        ~ThreadQuarantine() {
+            // set first: under an interposed malloc, freeing the ring is itself a tracked delete.
+            tQuarantineDestroyed = true;
+
+            if (p_Ring) {
+                evict(m_Length);
+                std::free(p_Ring);
+            }
+        }
+
+        /**
+         * @brief Verifies and frees the `count` oldest blocks.
+         */
+        void evict(size_t count) {
+            MEM_SENTRY::alloc_header::AllocHeader* batch[MEM_SENTRY::constants::QUARANTINE_BATCH];
+
+            while (count) {
+                size_t taken = 0;
+
+                // unlink a batch first, then verify and free it in one go.
+                for (; taken < count && taken < MEM_SENTRY::constants::QUARANTINE_BATCH; ++taken) {
+                    batch[taken] = p_Ring[m_Head];
+                    m_Head = (m_Head + 1) % MEM_SENTRY::constants::QUARANTINE_MAX_BLOCKS;
+                    m_Bytes -= batch[taken]->m_Size;
+                }
+                m_Length -= taken;
+                count -= taken;
+
+                for (size_t i = 0; i < taken; ++i) {
+                    verify(batch[i]);
+                }
+
+                for (size_t i = 0; i < taken; ++i) {
+                    std::free(batch[i]->p_OriginalAddress);
+                }
+            }
+        }
+
+        static void verify(const MEM_SENTRY::alloc_header::AllocHeader* header) {
+            const char* pData = (const char*)(header + 1);
+            size_t offset = MEM_SENTRY::poison::Verify(pData, header->m_Size, MEM_SENTRY::constants::QUARANTINE_POISON_BYTE);
+
+            if (offset == header->m_Size && header->m_Signature == MEM_SENTRY::constants::MEMSYSTEM_FREED_SIGNATURE) {
+                return;
+            }
+
+            gCorruptions.fetch_add(1, std::memory_order_relaxed);
+
+            if (offset != header->m_Size) {
+                std::printf("Error: write after free detected in allocation #%u (%u bytes) at offset %zu\n",
+                    header->m_AllocId, header->m_Size, offset);
+            } else {
+                std::printf("Error: header of freed allocation #%u was overwritten\n", header->m_AllocId);
+            }
+        }
+    };
+
+    ThreadQuarantine& threadQuarantine() {
+        thread_local ThreadQuarantine instance;
+        return instance;
+    }
+}
+
+void MEM_SENTRY::quarantine::Push(alloc_header::AllocHeader* header) {
+    size_t capacity = gCapacity.load(std::memory_order_relaxed);
+
+    if (capacity == 0 || header->m_Size > capacity || tQuarantineDestroyed) {
+        std::free(header->p_OriginalAddress);
+        return;
+    }
+
+    ThreadQuarantine& fifo = threadQuarantine();
+
+    if (!fifo.p_Ring) {
+        fifo.p_Ring = (alloc_header::AllocHeader**) std::malloc(
+            constants::QUARANTINE_MAX_BLOCKS * sizeof(alloc_header::AllocHeader*));
+
+        if (!fifo.p_Ring) {
+            std::free(header->p_OriginalAddress);
+            return;
+        }
+    }
+
+    poison::Fill(header + 1, header->m_Size, constants::QUARANTINE_POISON_BYTE);
+
+    // make room, evicting at least a whole batch so verification and frees are amortized.
+    size_t needed = 0;
+    size_t bytes = fifo.m_Bytes;
+    while (needed < fifo.m_Length && (fifo.m_Length - needed == constants::QUARANTINE_MAX_BLOCKS
+           || bytes + header->m_Size > capacity)) {
+        bytes -= fifo.p_Ring[(fifo.m_Head + needed) % constants::QUARANTINE_MAX_BLOCKS]->m_Size;
+        ++needed;
+    }
+
+    if (needed) {
+        size_t batch = needed < constants::QUARANTINE_BATCH ? constants::QUARANTINE_BATCH : needed;
+        fifo.evict(batch < fifo.m_Length ? batch : fifo.m_Length);
+    }
+
+    fifo.p_Ring[(fifo.m_Head + fifo.m_Length) % constants::QUARANTINE_MAX_BLOCKS] = header;
+    fifo.m_Length++;
+    fifo.m_Bytes += header->m_Size;
+}
+
+void MEM_SENTRY::quarantine::Flush() {
+    if (tQuarantineDestroyed) {
+        return;
+    }
+
+    ThreadQuarantine& fifo = threadQuarantine();
+    fifo.evict(fifo.m_Length);
+}
+
+void MEM_SENTRY::quarantine::SetThreadCapacity(size_t bytes) noexcept {
+    gCapacity.store(bytes, std::memory_order_relaxed);
+}
+
+size_t MEM_SENTRY::quarantine::GetThreadCapacity() noexcept {
+    return gCapacity.load(std::memory_order_relaxed);
+}
+
+size_t MEM_SENTRY::quarantine::ThreadBytes() noexcept {
+    return tQuarantineDestroyed ? 0 : threadQuarantine().m_Bytes;
+}
+
+uint64_t MEM_SENTRY::quarantine::CorruptionCount() noexcept {
+    return gCorruptions.load(std::memory_order_relaxed);
+}
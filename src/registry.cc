@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "mem_sentry/registry.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/interpose.h"
+
+static_assert(MEM_SENTRY::constants::MAX_HEAPS <= UINT16_MAX + 1, "Heap ids must fit in 16 bits");
+
+namespace {
+    constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    /// @brief buckets of the name intern table (power of 2).
+    constexpr size_t NAME_BUCKETS = 1024;
+
+    MEM_SENTRY::registry::HeapSlot g_Slots[MEM_SENTRY::constants::MAX_HEAPS];
+
+    std::mutex g_RegistryMutex;
+
+    /// @brief head of the recycled ids stack.
+    uint32_t g_FreeHead = NO_SLOT;
+
+    /// @brief ids never handed out yet start here.
+    uint32_t g_NextUnused = 0;
+
+    uint32_t g_UsedSlots = 0;
+
+    /**
+     * @brief Interned name node, allocated with interpose::UntrackedMalloc() and never freed.
+     */
+    struct NameNode {
+        NameNode* p_Next;
+        uint32_t m_Hash;
+        char m_Name[1];
+    };
+
+    NameNode* g_Names[NAME_BUCKETS];
+
+    /// @brief FNV-1a over at most 99 characters.
+    uint32_t hashName(const char* name, size_t& length) {
+        uint32_t hash = 2166136261u;
+        length = 0;
+
+        while (name[length] && length < 99) {
+            hash = (hash ^ (unsigned char)name[length]) * 16777619u;
+            ++length;
+        }
+
+        return hash;
+    }
+
+    void recycle(uint16_t id) {
+        std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+        MEM_SENTRY::registry::HeapSlot& slot = g_Slots[id];
+        slot.p_Heap.store(nullptr, std::memory_order_relaxed);
+        slot.m_Listed = false;
+        slot.m_NextFree = g_FreeHead;
+        g_FreeHead = id;
+        --g_UsedSlots;
+    }
+}
+
+MEM_SENTRY::registry::HeapSlot* MEM_SENTRY::registry::Slots() noexcept {
+    return g_Slots;
+}
+
+uint16_t MEM_SENTRY::registry::Acquire(heap::Heap* heap) {
+    std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+    uint32_t id;
+
+    if (g_FreeHead != NO_SLOT) {
+        id = g_FreeHead;
+        g_FreeHead = g_Slots[id].m_NextFree;
+    } else if (g_NextUnused < constants::MAX_HEAPS) {
+        id = g_NextUnused++;
+    } else {
+        throw std::length_error("MemSentry: heap registry is full");
+    }
+
+    HeapSlot& slot = g_Slots[id];
+    slot.m_Refs.store(0, std::memory_order_relaxed);
+    slot.m_NextFree = NO_SLOT;
+    slot.m_Generation.fetch_add(1, std::memory_order_relaxed);
+    slot.m_Listed = true;
+    slot.p_Heap.store(heap, std::memory_order_release);
+    ++g_UsedSlots;
+
+    return (uint16_t)id;
+}
+
+void MEM_SENTRY::registry::Unlist(uint16_t id) {
+    {
+        std::lock_guard<std::mutex> lock(g_RegistryMutex);
+        g_Slots[id].m_Listed = false;
+    }
+
+    // no new visitor can pin the slot now, wait for the current ones to leave.
+    while (g_Slots[id].m_Visitors.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void MEM_SENTRY::registry::Orphan(uint16_t id, heap::Heap* orphan, uint32_t liveAllocations) {
+    if (liveAllocations == 0) {
+        recycle(id);
+        return;
+    }
+
+    g_Slots[id].m_Refs.store(liveAllocations, std::memory_order_relaxed);
+    g_Slots[id].p_Heap.store(orphan, std::memory_order_release);
+}
+
+void MEM_SENTRY::registry::Release(uint16_t id) {
+    if (g_Slots[id].m_Refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        recycle(id);
+    }
+}
+
+uint32_t MEM_SENTRY::registry::CountSlots() noexcept {
+    std::lock_guard<std::mutex> lock(g_RegistryMutex);
+    return g_UsedSlots;
+}
+
+void MEM_SENTRY::registry::ForEachHeap(void (*visit)(heap::Heap*, void*), void* context) {
+    uint32_t id = 0;
+
+    for (;;) {
+        heap::Heap* heap = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+            while (id < g_NextUnused && !g_Slots[id].m_Listed) {
+                ++id;
+            }
+
+            if (id == g_NextUnused) {
+                return;
+            }
+
+            // pinned under the lock, so Unlist() can't miss it.
+            g_Slots[id].m_Visitors.fetch_add(1, std::memory_order_relaxed);
+            heap = g_Slots[id].p_Heap.load(std::memory_order_relaxed);
+        }
+
+        visit(heap, context);
+
+        g_Slots[id].m_Visitors.fetch_sub(1, std::memory_order_release);
+        ++id;
+    }
+}
+
+const char* MEM_SENTRY::registry::InternName(const char* name) {
+    size_t length = 0;
+    uint32_t hash = hashName(name, length);
+
+    std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+    NameNode*& bucket = g_Names[hash & (NAME_BUCKETS - 1)];
+
+    for (NameNode* node = bucket; node; node = node->p_Next) {
+        if (node->m_Hash == hash && std::strncmp(node->m_Name, name, length) == 0 && node->m_Name[length] == '\0') {
+            return node->m_Name;
+        }
+    }
+
+    NameNode* node = (NameNode*) interpose::UntrackedMalloc(sizeof(NameNode) + length);
+
+    if (!node) {
+        throw std::bad_alloc();
+    }
+
+    std::memcpy(node->m_Name, name, length);
+    node->m_Name[length] = '\0';
+    node->m_Hash = hash;
+    node->p_Next = bucket;
+    bucket = node;
+
+    return node->m_Name;
+}
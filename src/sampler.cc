@@ -0,0 +1,139 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "mem_sentry/sampler.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/registry.h"
+
+namespace {
+    uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+MEM_SENTRY::sampler::StatsSampler::StatsSampler(size_t capacity)
+    : m_Capacity(capacity ? capacity : 1), m_Written(0), m_Stop(false) {
+    p_Ring = (HeapSample*) interpose::UntrackedMalloc(m_Capacity * sizeof(HeapSample));
+    p_Prev = (PrevCounters*) interpose::UntrackedCalloc(constants::MAX_HEAPS, sizeof(PrevCounters));
+
+    if (!p_Ring || !p_Prev) {
+        std::free(p_Ring);
+        std::free(p_Prev);
+        throw std::bad_alloc();
+    }
+}
+
+MEM_SENTRY::sampler::StatsSampler::~StatsSampler() {
+    Stop();
+    std::free(p_Ring);
+    std::free(p_Prev);
+}
+
+void MEM_SENTRY::sampler::StatsSampler::SampleNow() {
+    uint64_t now = nowNs();
+
+    std::lock_guard<std::mutex> lock(m_RingMutex);
+
+    registry::ForEach([&](heap::Heap* heap) {
+        uint16_t id = heap->GetId();
+        uint64_t allocs = heap->GetAllocCount();
+        uint64_t frees = heap->GetFreeCount();
+
+        HeapSample& sample = p_Ring[m_Written % m_Capacity];
+        sample.m_Timestamp = now;
+        sample.m_name = heap->GetName();
+        sample.m_HeapId = id;
+        sample.m_Bytes = heap->GetTotal();
+        sample.m_Count = heap->CountAllocations();
+        sample.m_AllocRate = 0;
+        sample.m_FreeRate = 0;
+
+        // an id recycled by another heap (even one with the same name) starts over.
+        uint32_t generation = registry::Generation(id);
+        PrevCounters& prev = p_Prev[id];
+        if (prev.m_Timestamp && prev.m_Timestamp < now && prev.m_Generation == generation
+            && prev.m_AllocCount <= allocs && prev.m_FreeCount <= frees) {
+            double seconds = double(now - prev.m_Timestamp) / 1e9;
+            sample.m_AllocRate = double(allocs - prev.m_AllocCount) / seconds;
+            sample.m_FreeRate = double(frees - prev.m_FreeCount) / seconds;
+        }
+
+        prev = {now, generation, allocs, frees};
+        ++m_Written;
+    });
+}
+
+std::vector<MEM_SENTRY::sampler::HeapSample>
+MEM_SENTRY::sampler::StatsSampler::collect(std::chrono::milliseconds window, bool allHeaps, uint16_t heapId) const {
+    uint64_t now = nowNs();
+    uint64_t span = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(window).count();
+    uint64_t since = now > span ? now - span : 0;
+
+    std::vector<HeapSample> result;
+
+    std::lock_guard<std::mutex> lock(m_RingMutex);
+
+    // walk from the oldest retained sample, so the result is in time order.
+    uint64_t first = m_Written > m_Capacity ? m_Written - m_Capacity : 0;
+    for (uint64_t i = first; i < m_Written; ++i) {
+        const HeapSample& sample = p_Ring[i % m_Capacity];
+
+        if (sample.m_Timestamp >= since && (allHeaps || sample.m_HeapId == heapId)) {
+            result.push_back(sample);
+        }
+    }
+
+    return result;
+}
+
+std::vector<MEM_SENTRY::sampler::HeapSample>
+MEM_SENTRY::sampler::StatsSampler::Query(uint16_t heapId, std::chrono::milliseconds window) const {
+    return collect(window, false, heapId);
+}
+
+std::vector<MEM_SENTRY::sampler::HeapSample>
+MEM_SENTRY::sampler::StatsSampler::Query(std::chrono::milliseconds window) const {
+    return collect(window, true, 0);
+}
+
+size_t MEM_SENTRY::sampler::StatsSampler::Size() const {
+    std::lock_guard<std::mutex> lock(m_RingMutex);
+    return m_Written < m_Capacity ? (size_t)m_Written : m_Capacity;
+}
+
+void MEM_SENTRY::sampler::StatsSampler::loop(std::chrono::milliseconds interval) {
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        SampleNow();
+
+        std::unique_lock<std::mutex> lock(m_WaitMutex);
+        m_WaitCv.wait_for(lock, interval, [this] { return m_Stop.load(std::memory_order_acquire); });
+    }
+}
+
+bool MEM_SENTRY::sampler::StatsSampler::Start(std::chrono::milliseconds interval) {
+    if (m_Thread.joinable()) {
+        return false;
+    }
+
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&StatsSampler::loop, this, interval);
+
+    return true;
+}
+
+void MEM_SENTRY::sampler::StatsSampler::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        m_Stop.store(true, std::memory_order_release);
+    }
+    m_WaitCv.notify_all();
+
+    m_Thread.join();
+}
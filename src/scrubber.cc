@@ -0,0 +1,122 @@
+#include <cstdio>
+
+#include "mem_sentry/scrubber.h"
+#include "mem_sentry/canary.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/registry.h"
+#include "mem_sentry/threads.h"
+
+namespace {
+    /// @brief held by the running scrubber: heaps have a single scrub cursor.
+    std::atomic<bool> gScrubberRunning{false};
+
+    /**
+     * @brief Corrupted block found under the heap lock, printed once the lock is released.
+     */
+    struct ScrubReport {
+        uint32_t m_AllocId;
+        uint32_t m_Size;
+        const void* p_Data;
+        MEM_SENTRY::canary::Status m_Status;
+    };
+
+    /**
+     * @brief State shared with the ScrubStep() visitor of one heap.
+     */
+    struct ScrubContext {
+        size_t m_Checked;
+        size_t m_Corrupted;
+        size_t m_Reports;
+        ScrubReport m_Pending[MEM_SENTRY::constants::SCRUB_REPORTS_PER_TICK];
+    };
+
+    void validate(MEM_SENTRY::alloc_header::AllocHeader* alloc, void* context) {
+        ScrubContext* scrub = (ScrubContext*)context;
+        ++scrub->m_Checked;
+
+        MEM_SENTRY::canary::Status status = MEM_SENTRY::canary::Check(alloc);
+        if (status == MEM_SENTRY::canary::Status::Ok) {
+            return;
+        }
+
+        ++scrub->m_Corrupted;
+
+        // no printf here: it would take the stdio lock under the heap lock.
+        if (alloc->m_ScrubReported || scrub->m_Reports == MEM_SENTRY::constants::SCRUB_REPORTS_PER_TICK) {
+            return;
+        }
+        alloc->m_ScrubReported = 1;
+
+        scrub->m_Pending[scrub->m_Reports++] = {alloc->m_AllocId, alloc->m_Size, (const void*)(alloc + 1), status};
+    }
+}
+
+MEM_SENTRY::scrubber::HeapScrubber::HeapScrubber(size_t nodesPerTick)
+    : m_NodesPerTick(nodesPerTick ? nodesPerTick : 1), m_Corruptions(0), m_Checked(0), m_Stop(false) {
+}
+
+MEM_SENTRY::scrubber::HeapScrubber::~HeapScrubber() {
+    Stop();
+}
+
+size_t MEM_SENTRY::scrubber::HeapScrubber::ScrubNow() {
+    size_t corrupted = 0;
+    size_t checked = 0;
+
+    registry::ForEach([&](heap::Heap* heap) {
+        ScrubContext context{};
+        heap->ScrubStep(m_NodesPerTick, validate, &context);
+
+        for (size_t i = 0; i < context.m_Reports; ++i) {
+            const ScrubReport& report = context.m_Pending[i];
+            std::printf("Error: heap %s: allocation #%u (%u bytes at %p) corrupted: %s\n",
+                heap->GetName(), report.m_AllocId, report.m_Size, report.p_Data,
+                MEM_SENTRY::canary::StatusName(report.m_Status));
+        }
+
+        corrupted += context.m_Corrupted;
+        checked += context.m_Checked;
+    });
+
+    m_Checked.fetch_add(checked, std::memory_order_relaxed);
+    m_Corruptions.fetch_add(corrupted, std::memory_order_relaxed);
+
+    return corrupted;
+}
+
+void MEM_SENTRY::scrubber::HeapScrubber::loop(std::chrono::milliseconds interval) {
+    threads::LowerPriority();
+
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        ScrubNow();
+
+        std::unique_lock<std::mutex> lock(m_WaitMutex);
+        m_WaitCv.wait_for(lock, interval, [this] { return m_Stop.load(std::memory_order_acquire); });
+    }
+}
+
+bool MEM_SENTRY::scrubber::HeapScrubber::Start(std::chrono::milliseconds interval) {
+    if (m_Thread.joinable() || gScrubberRunning.exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&HeapScrubber::loop, this, interval);
+
+    return true;
+}
+
+void MEM_SENTRY::scrubber::HeapScrubber::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        m_Stop.store(true, std::memory_order_release);
+    }
+    m_WaitCv.notify_all();
+
+    m_Thread.join();
+    gScrubberRunning.store(false, std::memory_order_release);
+}
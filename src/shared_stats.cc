@@ -0,0 +1,200 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mem_sentry/shared_stats.h"
+#include "mem_sentry/heap.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/registry.h"
+
+namespace {
+    uint64_t monotonicNs() {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    void beginWrite(MEM_SENTRY::shared_stats::SharedHeapEntry& entry) {
+        entry.m_Sequence.store(entry.m_Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite(MEM_SENTRY::shared_stats::SharedHeapEntry& entry) {
+        entry.m_Sequence.store(entry.m_Sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+MEM_SENTRY::shared_stats::SharedStatsPublisher::SharedStatsPublisher()
+    : p_Region(nullptr), m_Stop(false) {
+    p_Seen = (uint8_t*) interpose::UntrackedCalloc(constants::MAX_HEAPS, 1);
+
+    if (!p_Seen) {
+        throw std::bad_alloc();
+    }
+
+    m_Name[0] = '\0';
+}
+
+MEM_SENTRY::shared_stats::SharedStatsPublisher::~SharedStatsPublisher() {
+    Close();
+    std::free(p_Seen);
+}
+
+bool MEM_SENTRY::shared_stats::SharedStatsPublisher::Open(const char* name) {
+    if (p_Region) {
+        return false;
+    }
+
+    if (name) {
+        std::snprintf(m_Name, sizeof(m_Name), "%s", name);
+    } else {
+        std::snprintf(m_Name, sizeof(m_Name), "/memsentry.%d", (int)::getpid());
+    }
+
+    size_t size = RegionSize(constants::MAX_HEAPS);
+
+    // start from an empty object: a stale region from a previous run may have another layout.
+    ::shm_unlink(m_Name);
+    int fd = ::shm_open(m_Name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::printf("Error: can't create shared stats region %s\n", m_Name);
+        m_Name[0] = '\0';
+        return false;
+    }
+
+    void* region = MAP_FAILED;
+    if (::ftruncate(fd, (off_t)size) == 0) {
+        region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+
+    if (region == MAP_FAILED) {
+        std::printf("Error: can't map shared stats region %s\n", m_Name);
+        ::shm_unlink(m_Name);
+        m_Name[0] = '\0';
+        return false;
+    }
+
+    // ftruncate zero-fills, so every entry starts with an even sequence and m_Live == 0.
+    p_Region = new (region) SharedStatsHeader();
+    p_Region->m_MaxHeaps = (uint32_t)constants::MAX_HEAPS;
+    p_Region->m_EntrySize = (uint32_t)sizeof(SharedHeapEntry);
+    p_Region->m_Pid = (uint32_t)::getpid();
+    p_Region->m_Version = SHARED_STATS_VERSION;
+
+    // readers check the magic last.
+    std::atomic_thread_fence(std::memory_order_release);
+    p_Region->m_Magic = SHARED_STATS_MAGIC;
+
+    return true;
+}
+
+void MEM_SENTRY::shared_stats::SharedStatsPublisher::Close() {
+    Stop();
+
+    if (!p_Region) {
+        return;
+    }
+
+    ::munmap(p_Region, RegionSize(constants::MAX_HEAPS));
+    ::shm_unlink(m_Name);
+
+    p_Region = nullptr;
+    m_Name[0] = '\0';
+}
+
+void MEM_SENTRY::shared_stats::SharedStatsPublisher::PublishNow() {
+    std::lock_guard<std::mutex> lock(m_PublishMutex);
+
+    if (!p_Region) {
+        return;
+    }
+
+    SharedHeapEntry* entries = Entries(p_Region);
+    uint32_t slotCount = p_Region->m_SlotCount.load(std::memory_order_relaxed);
+    uint32_t highest = slotCount;
+
+    registry::ForEach([&](heap::Heap* heap) {
+        uint16_t id = heap->GetId();
+        SharedHeapEntry& entry = entries[id];
+
+        p_Seen[id] = 1;
+        if (id >= highest) highest = id + 1u;
+
+        beginWrite(entry);
+
+        // names are interned, so an unchanged id keeps its bytes; only copy on change.
+        if (!entry.m_Live.load(std::memory_order_relaxed) || std::strncmp(entry.m_Name, heap->GetName(), SHARED_NAME_SIZE) != 0) {
+            std::snprintf(entry.m_Name, SHARED_NAME_SIZE, "%s", heap->GetName());
+        }
+
+        entry.m_Live.store(1, std::memory_order_relaxed);
+        entry.m_Bytes.store(heap->GetTotal(), std::memory_order_relaxed);
+        entry.m_Count.store(heap->CountAllocations(), std::memory_order_relaxed);
+        entry.m_AllocCount.store(heap->GetAllocCount(), std::memory_order_relaxed);
+        entry.m_FreeCount.store(heap->GetFreeCount(), std::memory_order_relaxed);
+
+        endWrite(entry);
+    });
+
+    // heaps destroyed since the previous pass.
+    for (uint32_t id = 0; id < highest; ++id) {
+        if (p_Seen[id]) {
+            p_Seen[id] = 0;
+            continue;
+        }
+
+        SharedHeapEntry& entry = entries[id];
+        if (entry.m_Live.load(std::memory_order_relaxed)) {
+            beginWrite(entry);
+            entry.m_Live.store(0, std::memory_order_relaxed);
+            endWrite(entry);
+        }
+    }
+
+    if (highest != slotCount) {
+        p_Region->m_SlotCount.store(highest, std::memory_order_release);
+    }
+
+    p_Region->m_UpdateNs.store(monotonicNs(), std::memory_order_relaxed);
+    p_Region->m_Ticks.fetch_add(1, std::memory_order_release);
+}
+
+void MEM_SENTRY::shared_stats::SharedStatsPublisher::loop(std::chrono::milliseconds interval) {
+    while (!m_Stop.load(std::memory_order_acquire)) {
+        PublishNow();
+
+        std::unique_lock<std::mutex> lock(m_WaitMutex);
+        m_WaitCv.wait_for(lock, interval, [this] { return m_Stop.load(std::memory_order_acquire); });
+    }
+}
+
+bool MEM_SENTRY::shared_stats::SharedStatsPublisher::Start(std::chrono::milliseconds interval) {
+    if (!p_Region || m_Thread.joinable()) {
+        return false;
+    }
+
+    m_Stop.store(false, std::memory_order_release);
+    m_Thread = std::thread(&SharedStatsPublisher::loop, this, interval);
+
+    return true;
+}
+
+void MEM_SENTRY::shared_stats::SharedStatsPublisher::Stop() {
+    if (!m_Thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_WaitMutex);
+        m_Stop.store(true, std::memory_order_release);
+    }
+    m_WaitCv.notify_all();
+
+    m_Thread.join();
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstring>
+
+#include "mem_sentry/sites.h"
+
+namespace {
+    enum SlotState : uint32_t {
+        SLOT_EMPTY = 0,
+        SLOT_WRITING = 1,
+        SLOT_READY = 2
+    };
+
+    /**
+     * @struct SiteSlot
+     * @brief Entry of the open addressing table. Claimed once, never removed.
+     */
+    struct SiteSlot {
+        std::atomic<uint32_t> m_State{SLOT_EMPTY};
+        MEM_SENTRY::sites::SiteInfo m_Info{};
+    };
+
+    static_assert((MEM_SENTRY::constants::SITE_TABLE_SIZE & (MEM_SENTRY::constants::SITE_TABLE_SIZE - 1)) == 0,
+        "SITE_TABLE_SIZE must be a power of 2");
+
+    constinit SiteSlot gSites[MEM_SENTRY::constants::SITE_TABLE_SIZE];
+
+    std::atomic<bool> gFullReported{false};
+
+    uint32_t hashOf(uint32_t line, uint32_t column) {
+        uint32_t hash = line * 0x9E3779B1u ^ column * 0x85EBCA77u;
+        return hash ^ (hash >> 15);
+    }
+
+    bool sameString(const char* a, const char* b) {
+        return a == b || std::strcmp(a, b) == 0;
+    }
+
+    /**
+     * @brief True if a ready slot holds the location; pointers are compared first,
+     * the strings only when the location comes from another translation unit.
+     */
+    bool matches(const MEM_SENTRY::sites::SiteInfo& info, const std::source_location& location) {
+        return info.m_Line == location.line() && info.m_Column == location.column()
+            && sameString(info.m_File, location.file_name())
+            && sameString(info.m_Function, location.function_name());
+    }
+}
+
+uint32_t MEM_SENTRY::sites::Intern(const std::source_location& location) noexcept {
+    constexpr size_t MASK = constants::SITE_TABLE_SIZE - 1;
+
+    size_t index = hashOf(location.line(), location.column()) & MASK;
+
+    for (size_t probe = 0; probe < constants::SITE_TABLE_SIZE; ++probe, index = (index + 1) & MASK) {
+        SiteSlot& slot = gSites[index];
+        uint32_t state = slot.m_State.load(std::memory_order_acquire);
+
+        if (state == SLOT_EMPTY) {
+            if (slot.m_State.compare_exchange_strong(state, SLOT_WRITING, std::memory_order_acquire)) {
+                slot.m_Info = {location.file_name(), location.function_name(), location.line(), location.column()};
+                slot.m_State.store(SLOT_READY, std::memory_order_release);
+                return (uint32_t)index + 1;
+            }
+        }
+
+        // another thread is filling this slot: it may be our location.
+        while (state == SLOT_WRITING) {
+            state = slot.m_State.load(std::memory_order_acquire);
+        }
+
+        if (matches(slot.m_Info, location)) {
+            return (uint32_t)index + 1;
+        }
+    }
+
+    if (!gFullReported.exchange(true, std::memory_order_relaxed)) {
+        std::printf("Error: allocation site table is full (%zu sites)\n", constants::SITE_TABLE_SIZE);
+    }
+
+    return 0;
+}
+
+const MEM_SENTRY::sites::SiteInfo* MEM_SENTRY::sites::Lookup(uint32_t id) noexcept {
+    if (id == 0 || id > constants::SITE_TABLE_SIZE) {
+        return nullptr;
+    }
+
+    const SiteSlot& slot = gSites[id - 1];
+    return slot.m_State.load(std::memory_order_acquire) == SLOT_READY ? &slot.m_Info : nullptr;
+}
+
+MEM_SENTRY::sites::SiteSummary::SiteSummary(const char* heapName)
+    : m_name(heapName), m_TotalCount(0), m_TotalBytes(0) {
+}
+
+void MEM_SENTRY::sites::SiteSummary::Assign(const uint32_t* counts, const uint64_t* bytes) {
+    m_Entries.clear();
+    m_TotalCount = 0;
+    m_TotalBytes = 0;
+
+    for (uint32_t id = 0; id <= constants::SITE_TABLE_SIZE; ++id) {
+        if (!counts[id]) continue;
+
+        m_Entries.push_back({id, counts[id], bytes[id]});
+        m_TotalCount += counts[id];
+        m_TotalBytes += bytes[id];
+    }
+
+    std::sort(m_Entries.begin(), m_Entries.end(), [](const SiteEntry& a, const SiteEntry& b) {
+        return a.m_Bytes != b.m_Bytes ? a.m_Bytes > b.m_Bytes : a.m_SiteId < b.m_SiteId;
+    });
+}
+
+void MEM_SENTRY::sites::SiteSummary::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Allocation Sites: %s ===\n", m_name);
+    std::fprintf(out, "%12s %16s  %s\n", "Count", "Bytes", "Site");
+
+    for (const SiteEntry& entry : m_Entries) {
+        const SiteInfo* info = Lookup(entry.m_SiteId);
+
+        if (info) {
+            std::fprintf(out, "%12" PRIu32 " %16" PRIu64 "  %s:%" PRIu32 " (%s)\n",
+                entry.m_Count, entry.m_Bytes, info->m_File, info->m_Line, info->m_Function);
+        } else {
+            std::fprintf(out, "%12" PRIu32 " %16" PRIu64 "  (untagged)\n", entry.m_Count, entry.m_Bytes);
+        }
+    }
+
+    std::fprintf(out, "%12" PRIu64 " %16" PRIu64 "  Total\n", m_TotalCount, m_TotalBytes);
+}
@@ -0,0 +1,91 @@
+#include <cinttypes>
+
+#include "mem_sentry/snapshot.h"
+#include "mem_sentry/constants.h"
+#include "mem_sentry/registry.h"
+
+MEM_SENTRY::snapshot::HeapSnapshot::HeapSnapshot(const char* heapName)
+    : m_name(registry::InternName(heapName)), m_TotalCount(0), m_TotalBytes(0) {
+}
+
+void MEM_SENTRY::snapshot::HeapSnapshot::Assign(const uint32_t* counts, const uint64_t* bytes) {
+    size_t used = 0;
+    for (size_t i = 0; i < constants::SNAPSHOT_SIZE_CLASSES; ++i) {
+        if (counts[i]) ++used;
+    }
+
+    m_Entries.clear();
+    m_Entries.reserve(used);
+    m_TotalCount = 0;
+    m_TotalBytes = 0;
+
+    // classes are visited in ascending order, so the result is already sorted.
+    for (uint32_t i = 0; i < constants::SNAPSHOT_SIZE_CLASSES; ++i) {
+        if (!counts[i]) continue;
+
+        m_Entries.push_back({i, counts[i], bytes[i]});
+        m_TotalCount += counts[i];
+        m_TotalBytes += bytes[i];
+    }
+}
+
+void MEM_SENTRY::snapshot::HeapSnapshot::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Heap Snapshot: %s ===\n", m_name);
+    std::fprintf(out, "%-14s %12s %16s\n", "Size Class", "Count", "Bytes");
+
+    for (const SnapshotEntry& entry : m_Entries) {
+        std::fprintf(out, "<= %-11" PRIu64 " %12" PRIu32 " %16" PRIu64 "\n",
+            uint64_t(1) << entry.m_SizeClass, entry.m_Count, entry.m_Bytes);
+    }
+
+    std::fprintf(out, "%-14s %12" PRIu64 " %16" PRIu64 "\n", "Total", m_TotalCount, m_TotalBytes);
+}
+
+MEM_SENTRY::snapshot::HeapSnapshotDiff::HeapSnapshotDiff(const HeapSnapshot& before, const HeapSnapshot& after)
+    : m_name(after.GetHeapName()), m_CountDelta(0), m_BytesDelta(0) {
+
+    const std::vector<SnapshotEntry>& lhs = before.GetEntries();
+    const std::vector<SnapshotEntry>& rhs = after.GetEntries();
+
+    m_Entries.reserve(lhs.size() + rhs.size());
+
+    // merge join: both entry lists are sorted by size class.
+    size_t i = 0, j = 0;
+    while (i < lhs.size() || j < rhs.size()) {
+        DiffEntry entry{};
+
+        if (j == rhs.size() || (i < lhs.size() && lhs[i].m_SizeClass < rhs[j].m_SizeClass)) {
+            entry = {lhs[i].m_SizeClass, -int64_t(lhs[i].m_Count), -int64_t(lhs[i].m_Bytes)};
+            ++i;
+        } else if (i == lhs.size() || rhs[j].m_SizeClass < lhs[i].m_SizeClass) {
+            entry = {rhs[j].m_SizeClass, int64_t(rhs[j].m_Count), int64_t(rhs[j].m_Bytes)};
+            ++j;
+        } else {
+            entry = {
+                lhs[i].m_SizeClass,
+                int64_t(rhs[j].m_Count) - int64_t(lhs[i].m_Count),
+                int64_t(rhs[j].m_Bytes) - int64_t(lhs[i].m_Bytes)
+            };
+            ++i;
+            ++j;
+        }
+
+        if (entry.m_CountDelta || entry.m_BytesDelta) {
+            m_CountDelta += entry.m_CountDelta;
+            m_BytesDelta += entry.m_BytesDelta;
+            m_Entries.push_back(entry);
+        }
+    }
+}
+
+void MEM_SENTRY::snapshot::HeapSnapshotDiff::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Heap Snapshot Diff: %s ===\n", m_name);
+    std::fprintf(out, "%-14s %12s %16s\n", "Size Class", "Count +/-", "Bytes +/-");
+
+    for (const DiffEntry& entry : m_Entries) {
+        std::fprintf(out, "<= %-11" PRIu64 " %+12" PRId64 " %+16" PRId64 "\n",
+            uint64_t(1) << entry.m_SizeClass, entry.m_CountDelta, entry.m_BytesDelta);
+    }
+
+    std::fprintf(out, "%-14s %+12" PRId64 " %+16" PRId64 "\n", "Total", m_CountDelta, m_BytesDelta);
+}
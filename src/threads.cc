@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mem_sentry/threads.h"
+#include "mem_sentry/constants.h"
+
+constinit thread_local uint16_t MEM_SENTRY::threads::tThreadIndex = MEM_SENTRY::threads::UNASSIGNED;
+
+namespace {
+    /**
+     * @struct ThreadSlot
+     * @brief Counters of one thread, on their own cache line: remote frees update them from other threads.
+     */
+    struct alignas(MEM_SENTRY::constants::CACHE_LINE_SIZE) ThreadSlot {
+        std::atomic<int32_t> m_Tid{0};
+
+        std::atomic<uint64_t> m_Allocs{0};
+        std::atomic<uint64_t> m_Frees{0};
+        std::atomic<uint64_t> m_AllocatedBytes{0};
+        std::atomic<uint64_t> m_FreedBytes{0};
+        std::atomic<uint64_t> m_RemoteFrees{0};
+        std::atomic<uint64_t> m_FreedRemotely{0};
+    };
+
+    /// @brief Entry 0 collects the threads started past the table size.
+    constinit ThreadSlot gThreads[MEM_SENTRY::constants::THREAD_MAX_THREADS];
+
+    /// @brief Next free entry.
+    constinit std::atomic<uint32_t> gThreadCount{1};
+}
+
+uint16_t MEM_SENTRY::threads::Assign() noexcept {
+    uint32_t index = gThreadCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (index >= constants::THREAD_MAX_THREADS) {
+        // keep the counter bounded, the thread uses the shared entry from now on.
+        gThreadCount.store(constants::THREAD_MAX_THREADS, std::memory_order_relaxed);
+        index = 0;
+    } else {
+        gThreads[index].m_Tid.store((int32_t)::syscall(SYS_gettid), std::memory_order_relaxed);
+    }
+
+    tThreadIndex = (uint16_t)index;
+    return (uint16_t)index;
+}
+
+void MEM_SENTRY::threads::OnAlloc(const alloc_header::AllocHeader* header) noexcept {
+    ThreadSlot& slot = gThreads[header->m_ThreadIndex];
+
+    slot.m_Allocs.fetch_add(1, std::memory_order_relaxed);
+    slot.m_AllocatedBytes.fetch_add(header->m_Size, std::memory_order_relaxed);
+}
+
+void MEM_SENTRY::threads::OnFree(const alloc_header::AllocHeader* header) noexcept {
+    uint16_t current = Current();
+    ThreadSlot& slot = gThreads[current];
+
+    slot.m_Frees.fetch_add(1, std::memory_order_relaxed);
+    slot.m_FreedBytes.fetch_add(header->m_Size, std::memory_order_relaxed);
+
+    if (header->m_ThreadIndex != current) {
+        slot.m_RemoteFrees.fetch_add(1, std::memory_order_relaxed);
+        gThreads[header->m_ThreadIndex].m_FreedRemotely.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MEM_SENTRY::threads::OnResize(const alloc_header::AllocHeader* header, uint32_t oldSize) noexcept {
+    ThreadSlot& slot = gThreads[Current()];
+
+    if (header->m_Size > oldSize) {
+        slot.m_AllocatedBytes.fetch_add(header->m_Size - oldSize, std::memory_order_relaxed);
+    } else if (header->m_Size < oldSize) {
+        slot.m_FreedBytes.fetch_add(oldSize - header->m_Size, std::memory_order_relaxed);
+    }
+}
+
+void MEM_SENTRY::threads::LowerPriority() noexcept {
+#ifdef SCHED_BATCH
+    sched_param param{};
+    sched_setscheduler(0, SCHED_BATCH, &param);
+#endif
+
+    // on Linux the nice value belongs to the thread, not to the whole process.
+    setpriority(PRIO_PROCESS, (id_t)::syscall(SYS_gettid), constants::THREAD_BACKGROUND_NICE);
+}
+
+uint32_t MEM_SENTRY::threads::Count() noexcept {
+    uint32_t count = gThreadCount.load(std::memory_order_relaxed);
+    return count < constants::THREAD_MAX_THREADS ? count : (uint32_t)constants::THREAD_MAX_THREADS;
+}
+
+MEM_SENTRY::threads::ThreadStats MEM_SENTRY::threads::GetStats(uint16_t index) noexcept {
+    if (index >= constants::THREAD_MAX_THREADS) {
+        return ThreadStats{index, 0, 0, 0, 0, 0, 0, 0};
+    }
+
+    const ThreadSlot& slot = gThreads[index];
+
+    return ThreadStats{
+        index,
+        slot.m_Tid.load(std::memory_order_relaxed),
+        slot.m_Allocs.load(std::memory_order_relaxed),
+        slot.m_Frees.load(std::memory_order_relaxed),
+        slot.m_AllocatedBytes.load(std::memory_order_relaxed),
+        slot.m_FreedBytes.load(std::memory_order_relaxed),
+        slot.m_RemoteFrees.load(std::memory_order_relaxed),
+        slot.m_FreedRemotely.load(std::memory_order_relaxed)
+    };
+}
+
+MEM_SENTRY::threads::ThreadSnapshot::ThreadSnapshot() : m_TotalAllocs(0), m_TotalFrees(0), m_TotalRemoteFrees(0) {
+}
+
+MEM_SENTRY::threads::ThreadSnapshot MEM_SENTRY::threads::ThreadSnapshot::Take() {
+    ThreadSnapshot snapshot;
+
+    uint32_t count = Count();
+    snapshot.m_Entries.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        ThreadStats entry = GetStats((uint16_t)i);
+
+        if (!entry.m_Allocs && !entry.m_Frees) {
+            continue;
+        }
+
+        snapshot.m_Entries.push_back(entry);
+        snapshot.m_TotalAllocs += entry.m_Allocs;
+        snapshot.m_TotalFrees += entry.m_Frees;
+        snapshot.m_TotalRemoteFrees += entry.m_RemoteFrees;
+    }
+
+    std::sort(snapshot.m_Entries.begin(), snapshot.m_Entries.end(), [](const ThreadStats& a, const ThreadStats& b) {
+        return a.m_AllocatedBytes != b.m_AllocatedBytes ? a.m_AllocatedBytes > b.m_AllocatedBytes : a.m_Index < b.m_Index;
+    });
+
+    return snapshot;
+}
+
+const MEM_SENTRY::threads::ThreadStats* MEM_SENTRY::threads::ThreadSnapshot::Find(uint16_t index) const noexcept {
+    for (const ThreadStats& entry : m_Entries) {
+        if (entry.m_Index == index) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void MEM_SENTRY::threads::ThreadSnapshot::Dump(std::FILE* out) const {
+    std::fprintf(out, "=== Threads ===\n");
+    std::fprintf(out, "%6s %8s %12s %12s %16s %16s %12s %14s\n",
+        "Index", "Tid", "Allocs", "Frees", "Allocated", "Freed", "Remote Frees", "Freed Remotely");
+
+    for (const ThreadStats& entry : m_Entries) {
+        std::fprintf(out, "%6u %8" PRId32 " %12" PRIu64 " %12" PRIu64 " %16" PRIu64 " %16" PRIu64 " %12" PRIu64 " %14" PRIu64 "\n",
+            (unsigned)entry.m_Index, entry.m_Tid, entry.m_Allocs, entry.m_Frees,
+            entry.m_AllocatedBytes, entry.m_FreedBytes, entry.m_RemoteFrees, entry.m_FreedRemotely);
+    }
+
+    std::fprintf(out, "%6s %8s %12" PRIu64 " %12" PRIu64 " %16s %16s %12" PRIu64 "  (%.1f%% remote)\n",
+        "Total", "", m_TotalAllocs, m_TotalFrees, "", "", m_TotalRemoteFrees, GetRemoteFreeRatio() * 100.0);
+}
@@ -1,5 +1,8 @@
 #include <iostream>
 #include <vector>
+#include <list>
+#include <memory_resource>
+#include <type_traits>
 #include <cassert>
 #include <string>
 #include <algorithm>
@@ -10,6 +13,15 @@
 #include <new>      
 #include <mutex>
 #include <limits>
+#include <stdexcept>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <csignal>
 
 // ----------------------------------------------------------------------------
 // CONFIGURATION
@@ -17,9 +29,24 @@
 #include "mem_sentry/mem_sentry.h"
 #include "mem_sentry/heap.h"
 #include "mem_sentry/sentry.h"
+#include "mem_sentry/census.h"
+#include "mem_sentry/sites.h"
+#include "mem_sentry/context.h"
+#include "mem_sentry/threads.h"
+#include "mem_sentry/leaks.h"
 #include "mem_sentry/alloc_header.h"
 
 #include "mem_sentry/reporter.h"
+#include "mem_sentry/epoch.h"
+#include "mem_sentry/metrics_exporter.h"
+#include "mem_sentry/sampler.h"
+#include "mem_sentry/shared_stats.h"
+#include "mem_sentry/quarantine.h"
+#include "mem_sentry/poison.h"
+#include "mem_sentry/canary.h"
+#include "mem_sentry/scrubber.h"
+#include "mem_sentry/interpose.h"
+#include "mem_sentry/heap_allocator.h"
 
 using MEM_SENTRY::heap::Heap;
 using MEM_SENTRY::heap::HeapFactory;
@@ -66,11 +93,83 @@ public:
     AudioObject() : sampleRate(44100) {}
 };
 
+// Tracked object owning a container: its elements follow the object's heap.
+class InventoryObject : public MEM_SENTRY::sentry::ISentry<InventoryObject> {
+public:
+    std::vector<int, Allocator<int>> items;
+};
+
+// Non-polymorphic tracked types: no vptr, still trivial.
+struct LiteParticle : public MEM_SENTRY::sentry::ISentryLite<LiteParticle> {
+    float x, y, z, w;
+};
+
+struct alignas(64) LiteBlock : public MEM_SENTRY::sentry::ISentryLite<LiteBlock> {
+    float lanes[16];
+};
+
+struct LiteThrowing : public MEM_SENTRY::sentry::ISentryLite<LiteThrowing> {
+    explicit LiteThrowing(bool fail) { if (fail) throw std::runtime_error("ctor"); }
+    int value = 0;
+};
+
+struct alignas(64) LiteThrowingAligned : public MEM_SENTRY::sentry::ISentryLite<LiteThrowingAligned> {
+    explicit LiteThrowingAligned(bool fail) { if (fail) throw std::runtime_error("ctor"); }
+    float lanes[16];
+};
+
+// Heap bound at compile time through a tag.
+struct TaggedHeapTag { static constexpr const char* Name = "TaggedHeap"; };
+
+struct TaggedVoice : public MEM_SENTRY::sentry::ISentryLite<TaggedVoice, TaggedHeapTag> {
+    int channel;
+};
+
+class TaggedEffect : public MEM_SENTRY::sentry::ISentry<TaggedEffect, TaggedHeapTag> {
+public:
+    double gain = 1.0;
+};
+
+// Churny node types served by object pools.
+class PooledNode : public MEM_SENTRY::sentry::ISentry<PooledNode> {
+public:
+    int value = 0;
+    char payload[20];
+};
+
+// Types counted by the census test.
+class CensusEffect : public MEM_SENTRY::sentry::ISentry<CensusEffect> {
+public:
+    char data[40];
+};
+
+class CensusAudio : public MEM_SENTRY::sentry::ISentry<CensusAudio> {
+public:
+    char samples[100];
+};
+
+struct CensusSample : public MEM_SENTRY::sentry::ISentryLite<CensusSample> {
+    float value;
+};
+
+struct alignas(64) PooledVector : public MEM_SENTRY::sentry::ISentryLite<PooledVector> {
+    float lanes[16];
+};
+
 // Aligned structure: 128-byte alignment
 struct alignas(128) AlignedDeepData {
     float data[32]; 
 };
 
+// Plain 100-byte payload (lands in the (64, 128] size class)
+struct Payload100 {
+    char bytes[100];
+};
+
+struct Payload16 {
+    char bytes[16];
+};
+
 // ----------------------------------------------------------------------------
 // TEST SUITE
 // ----------------------------------------------------------------------------
@@ -118,6 +217,32 @@ public:
         TestHeapHierarchy();
         TestHeapHierarchyThreadSafety();
 
+        TestHeapSnapshotDiff();
+        TestHeapHierarchyIncremental();
+        TestHeapGraphConcurrentTopology();
+        TestHeapTeardownWithLiveAllocations();
+        TestHeapRegistryIds();
+        TestMetricsExporter();
+        TestStatsSampler();
+        TestSharedStatsRegion();
+        TestGuardPageMode();
+        TestUseAfterFreeQuarantine();
+        TestPoisonKernels();
+        TestCanariesAndScrubber();
+        TestReallocResize();
+        TestMallocInterposition();
+        TestHeapAllocator();
+        TestHeapScope();
+        TestSentryLite();
+        TestTaggedHeapBinding();
+        TestObjectPool();
+        TestTypeCensus();
+        TestAllocationSites();
+        TestAllocationContexts();
+        TestThreadAttribution();
+        TestLifetimeProfile();
+        TestLeakDetector();
+
         std::cout << "\n=============================================\n";
         std::cout << "    \033[32mALL TESTS PASSED SUCCESSFULLY\033[0m\n";
         std::cout << "=============================================\n";
@@ -805,6 +930,1502 @@ private:
         ASSERT_TRUE(maxObservedCount > 0);
         #endif
     }
+
+    static void TestHeapSnapshotDiff() {
+        LOG_TEST("TestHeapSnapshotDiff");
+        Heap heap("SnapshotHeap");
+
+        int* keep = new (&heap) int(1);
+
+        MEM_SENTRY::snapshot::HeapSnapshot before = heap.Snapshot();
+
+        std::vector<Payload100*> batch;
+        batch.reserve(600);
+        for(int i = 0; i < 600; i++) {
+            batch.push_back(new (&heap) Payload100());
+        }
+
+        MEM_SENTRY::snapshot::HeapSnapshot after = heap.Snapshot();
+        MEM_SENTRY::snapshot::HeapSnapshotDiff diff = MEM_SENTRY::snapshot::Diff(before, after);
+
+        #if MEM_SENTRY_ENABLE
+        ASSERT_EQ(before.GetTotalCount(), 1);
+        ASSERT_EQ(before.GetTotalBytes(), sizeof(int));
+
+        // 600 blocks spread over 3 chunks, all in the (64, 128] class.
+        ASSERT_EQ(after.GetTotalCount(), 601);
+        ASSERT_EQ(after.GetEntries().size(), 2);
+        ASSERT_EQ(after.GetEntries()[1].m_SizeClass, 7);
+
+        ASSERT_EQ(diff.GetEntries().size(), 1);
+        ASSERT_EQ(diff.GetCountDelta(), 600);
+        ASSERT_EQ(diff.GetBytesDelta(), 600 * 100);
+
+        // the cursor must be gone and must never be counted.
+        ASSERT_EQ(GetCount(&heap), 601);
+        #endif
+
+        diff.Dump();
+
+        for(Payload100* p : batch) delete p;
+        delete keep;
+
+        ASSERT_EQ(GetCount(&heap), 0);
+    }
+
+    static void TestHeapHierarchyIncremental() {
+        LOG_TEST("TestHeapHierarchyIncremental (Closure Updates)");
+        Heap a("ChainA");
+        Heap b("ChainB");
+        Heap c("ChainC");
+
+        int* pA = new (&a) int(1);
+        int* pB = new (&b) int(2);
+        int* pC = new (&c) int(3);
+
+        // A -> B first, then B -> C: A's closure must pick up C through B.
+        a.AddHeap(&b);
+        b.AddHeap(&c);
+
+        #if MEM_SENTRY_ENABLE
+        ASSERT_EQ(a.CountAllocationsHH(), 3);
+        ASSERT_EQ(b.CountAllocationsHH(), 2);
+        ASSERT_EQ(c.CountAllocationsHH(), 1);
+
+        // cycle back to A must not loop and must not change A's closure.
+        c.AddHeap(&a);
+        ASSERT_EQ(a.CountAllocationsHH(), 3);
+        ASSERT_EQ(c.GetTotalHH(), 3 * sizeof(int));
+
+        // queries must not allocate on the DefaultHeap anymore.
+        Heap* defaultHeap = HeapFactory::GetDefaultHeap();
+        size_t before = GetCount(defaultHeap);
+        long long beforeTotal = GetTotal(defaultHeap);
+        for(int i = 0; i < 100; i++) {
+            a.GetTotalHH();
+            a.CountAllocationsHH();
+        }
+        ASSERT_EQ(GetCount(defaultHeap), before);
+        ASSERT_EQ(GetTotal(defaultHeap), beforeTotal);
+        #endif
+
+        delete pA;
+        delete pB;
+        delete pC;
+    }
+
+    static void TestHeapGraphConcurrentTopology() {
+        LOG_TEST("TestHeapGraphConcurrentTopology (RCU Readers)");
+        const int LEAVES = 32;
+
+        Heap root("RcuRoot");
+        std::vector<Heap*> leaves;
+        std::vector<int*> ptrs;
+        for(int i = 0; i < LEAVES; i++) {
+            leaves.push_back(new Heap("RcuLeaf"));
+            ptrs.push_back(new (leaves.back()) int(i));
+        }
+
+        std::atomic<bool> running(true);
+        std::atomic<bool> monotonic(true);
+
+        // readers walk the published lists while the topology keeps growing.
+        std::thread reader([&]() {
+            size_t last = 0;
+            while(running) {
+                size_t count = root.CountAllocationsHH();
+                if(count < last) monotonic = false;
+                last = count;
+
+                Heap* neighbors[LEAVES];
+                root.GetAdjacentHeaps(neighbors, LEAVES);
+            }
+        });
+
+        for(int i = 0; i < LEAVES; i++) {
+            root.AddHeap(leaves[i]);
+            std::this_thread::yield();
+        }
+
+        running = false;
+        reader.join();
+
+        #if MEM_SENTRY_ENABLE
+        ASSERT_TRUE(monotonic);
+        ASSERT_EQ(root.CountAllocationsHH(), LEAVES);
+
+        Heap* neighbors[LEAVES];
+        ASSERT_EQ(root.GetAdjacentHeaps(neighbors, LEAVES), LEAVES);
+        ASSERT_TRUE(neighbors[LEAVES - 1] == leaves[LEAVES - 1]);
+        #endif
+
+        // no reader is inside a guard anymore: every retired list must be freed.
+        ASSERT_EQ(MEM_SENTRY::epoch::Reclaim(), 0);
+
+        for(int i = 0; i < LEAVES; i++) {
+            delete ptrs[i];
+        }
+        for(Heap* leaf : leaves) {
+            delete leaf;
+        }
+    }
+
+    static void TestHeapTeardownWithLiveAllocations() {
+        LOG_TEST("TestHeapTeardownWithLiveAllocations (Orphan Heap)");
+        Heap* orphan = HeapFactory::GetOrphanHeap();
+        size_t orphanStart = GetCount(orphan);
+        uint32_t slotsStart = MEM_SENTRY::registry::CountSlots();
+
+        Heap survivor("Survivor");
+        Heap* request = new Heap("PerRequest");
+        HeapFactory::ConnectHeaps(&survivor, request);
+
+        int* a = new (request) int(1);
+        int* b = new (request) int(2);
+        int* c = new (request) int(3);
+
+        #if MEM_SENTRY_ENABLE
+        ASSERT_EQ(survivor.CountAllocationsHH(), 3);
+        #endif
+
+        delete request;
+
+        #if MEM_SENTRY_ENABLE
+        // blocks moved to the orphan heap, edges to the dead heap are gone.
+        ASSERT_EQ(GetCount(orphan), orphanStart + 3);
+        ASSERT_EQ(survivor.CountAllocationsHH(), 0);
+        ASSERT_EQ(survivor.GetAdjacentHeaps(nullptr, 0), 0);
+        ASSERT_TRUE(MEM_SENTRY::registry::HeapOf((AllocHeader*)((char*)a - sizeof(AllocHeader))) == orphan);
+
+        // adopted blocks keep the dead heap's ids, the snapshot must still see them.
+        ASSERT_EQ(orphan->Snapshot().GetTotalCount(), orphanStart + 3);
+        ASSERT_EQ(orphan->SummarizeSites().GetTotalCount(), orphanStart + 3);
+        #endif
+
+        delete b;
+        delete a;
+        delete c;
+
+        ASSERT_EQ(GetCount(orphan), orphanStart);
+        // last orphan released the dead heap's slot.
+        ASSERT_EQ(MEM_SENTRY::registry::CountSlots(), slotsStart + 1);
+
+        // high rate create/destroy must recycle slots.
+        for(int i = 0; i < 10000; i++) {
+            Heap* h = new Heap("Churn");
+            int* p = new (h) int(i);
+            if(i % 2) delete p;
+            delete h;
+            if(!(i % 2)) delete p;
+        }
+        ASSERT_EQ(MEM_SENTRY::registry::CountSlots(), slotsStart + 1);
+        ASSERT_EQ(GetCount(orphan), orphanStart);
+    }
+
+    static void TestHeapRegistryIds() {
+        LOG_TEST("TestHeapRegistryIds");
+        Heap first("RegistryHeap");
+        Heap second("RegistryHeap");
+
+        // O(1) lookup by id, names interned by pointer.
+        ASSERT_TRUE(first.GetId() != second.GetId());
+        ASSERT_TRUE(MEM_SENTRY::registry::Find(first.GetId()) == &first);
+        ASSERT_TRUE(first.GetName() == second.GetName());
+        ASSERT_TRUE(MEM_SENTRY::registry::InternName("RegistryHeap") == first.GetName());
+
+        int* p = new (&second) int(5);
+        #if MEM_SENTRY_ENABLE
+        AllocHeader* header = (AllocHeader*)((char*)p - sizeof(AllocHeader));
+        ASSERT_EQ(header->m_HeapId, second.GetId());
+        #endif
+        delete p;
+
+        // enumeration sees both, and stops seeing a heap once it is destroyed.
+        int seen = 0;
+        MEM_SENTRY::registry::ForEach([&](Heap* heap) {
+            if(heap == &first || heap == &second) ++seen;
+        });
+        ASSERT_EQ(seen, 2);
+
+        Heap* temp = new Heap("RegistryTemp");
+        uint16_t tempId = temp->GetId();
+        delete temp;
+        ASSERT_TRUE(MEM_SENTRY::registry::Find(tempId) == nullptr);
+
+        bool found = false;
+        MEM_SENTRY::registry::ForEach([&](Heap* heap) {
+            if(heap == temp) found = true;
+        });
+        ASSERT_TRUE(!found);
+
+        // callbacks run outside the registry lock: they may intern names and create heaps.
+        int created = 0;
+        MEM_SENTRY::registry::ForEach([&](Heap* heap) {
+            if(heap != &first) return;
+            Heap nested(MEM_SENTRY::registry::InternName("RegistryNested"));
+            ++created;
+        });
+        ASSERT_EQ(created, 1);
+
+        // snapshots keep their own copy of the name.
+        char transient[32];
+        std::snprintf(transient, sizeof(transient), "RegistryTransient");
+        MEM_SENTRY::snapshot::HeapSnapshot named(transient);
+        transient[0] = 'X';
+        ASSERT_TRUE(std::strcmp(named.GetHeapName(), "RegistryTransient") == 0);
+    }
+    static void TestMetricsExporter() {
+        LOG_TEST("TestMetricsExporter");
+        Heap heap("Metrics\"Heap");
+        int* p = new (&heap) int(1);
+
+        MEM_SENTRY::exporter::MetricsExporter exporter;
+        size_t length = exporter.Format();
+        ASSERT_TRUE(length > 0);
+
+        std::string text(exporter.Data(), exporter.Length());
+        std::string label = "heap=\"Metrics\\\"Heap\",id=\"" + std::to_string(heap.GetId()) + "\"}";
+        ASSERT_TRUE(text.find("# TYPE memsentry_heap_bytes gauge") != std::string::npos);
+        ASSERT_TRUE(text.find("memsentry_heap_bytes{" + label + " " + std::to_string(GetTotal(&heap))) != std::string::npos);
+        ASSERT_TRUE(text.find("memsentry_heap_allocations{" + label + " " + std::to_string(GetCount(&heap))) != std::string::npos);
+        ASSERT_TRUE(text.find("memsentry_heap_hierarchy_bytes{" + label) != std::string::npos);
+        ASSERT_TRUE(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+
+        // a buffer that is too small fails instead of truncating.
+        MEM_SENTRY::exporter::MetricsExporter tiny(32);
+        ASSERT_EQ(tiny.Format(), (size_t)0);
+
+        // file mode: the first write happens right away.
+        char path[] = "/tmp/memsentry_metrics_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_TRUE(fd >= 0);
+        close(fd);
+
+        ASSERT_TRUE(exporter.StartFile(path, std::chrono::milliseconds(10)));
+        ASSERT_TRUE(!exporter.StartHttp(0));
+
+        std::string content;
+        for(int tries = 0; tries < 200 && content.find("# EOF") == std::string::npos; ++tries) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            if(FILE* f = std::fopen(path, "r")) {
+                char buffer[4096];
+                size_t n = std::fread(buffer, 1, sizeof(buffer), f);
+                content.assign(buffer, n);
+                std::fclose(f);
+            }
+        }
+        exporter.Stop();
+        std::remove(path);
+        ASSERT_TRUE(content.find("memsentry_heap_allocations{" + label) != std::string::npos);
+
+        // http mode on an ephemeral port.
+        ASSERT_TRUE(exporter.StartHttp(0));
+        ASSERT_TRUE(exporter.GetPort() != 0);
+        exporter.Stop();
+        ASSERT_EQ(exporter.GetPort(), 0);
+
+        delete p;
+    }
+    static void TestStatsSampler() {
+        LOG_TEST("TestStatsSampler");
+        Heap heap("SamplerHeap");
+        MEM_SENTRY::sampler::StatsSampler sampler(64);
+
+        sampler.SampleNow();
+        std::vector<int*> ptrs;
+        for(int i = 0; i < 10; ++i) ptrs.push_back(new (&heap) int(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        sampler.SampleNow();
+
+        std::vector<MEM_SENTRY::sampler::HeapSample> samples =
+            sampler.Query(heap.GetId(), std::chrono::seconds(60));
+        ASSERT_EQ(samples.size(), (size_t)2);
+        ASSERT_TRUE(samples[0].m_name == heap.GetName());
+        ASSERT_TRUE(samples[0].m_Timestamp <= samples[1].m_Timestamp);
+        ASSERT_EQ(samples[0].m_AllocRate, 0.0);
+        ASSERT_EQ(samples[1].m_Bytes, (int64_t)GetTotal(&heap));
+        ASSERT_EQ(samples[1].m_Count, (int64_t)GetCount(&heap));
+        #if MEM_SENTRY_ENABLE
+        ASSERT_EQ(heap.GetAllocCount(), (uint64_t)10);
+        ASSERT_TRUE(samples[1].m_AllocRate > 0.0);
+        #endif
+
+        for(int* p : ptrs) delete p;
+        #if MEM_SENTRY_ENABLE
+        ASSERT_EQ(heap.GetFreeCount(), (uint64_t)10);
+        #endif
+
+        // the ring has a fixed size: old samples are overwritten.
+        for(int i = 0; i < 100; ++i) sampler.SampleNow();
+        ASSERT_EQ(sampler.Size(), sampler.Capacity());
+        ASSERT_TRUE(sampler.Query(std::chrono::seconds(60)).size() <= sampler.Capacity());
+
+        // a heap reusing the id (and the name) of a destroyed one starts without a rate.
+        Heap* first = new Heap("SamplerRecycled");
+        uint16_t recycledId = first->GetId();
+        uint32_t generation = MEM_SENTRY::registry::Generation(recycledId);
+        sampler.SampleNow();
+        delete first;
+
+        Heap* second = new Heap("SamplerRecycled");
+        int* extra = new (second) int(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        sampler.SampleNow();
+
+        if(second->GetId() == recycledId) {
+            ASSERT_EQ(MEM_SENTRY::registry::Generation(recycledId), generation + 1);
+            std::vector<MEM_SENTRY::sampler::HeapSample> recycled =
+                sampler.Query(recycledId, std::chrono::seconds(60));
+            ASSERT_EQ(recycled.back().m_AllocRate, 0.0);
+        }
+
+        delete extra;
+        delete second;
+
+        // background mode.
+        MEM_SENTRY::sampler::StatsSampler background(1024);
+        ASSERT_TRUE(background.Start(std::chrono::milliseconds(1)));
+        ASSERT_TRUE(!background.Start(std::chrono::milliseconds(1)));
+        for(int tries = 0; tries < 200 && background.Query(heap.GetId(), std::chrono::seconds(60)).size() < 2; ++tries) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        background.Stop();
+        ASSERT_TRUE(background.Query(heap.GetId(), std::chrono::seconds(60)).size() >= 2);
+    }
+    static void TestSharedStatsRegion() {
+        LOG_TEST("TestSharedStatsRegion");
+        using namespace MEM_SENTRY::shared_stats;
+
+        Heap* heap = new Heap("SharedStatsHeap");
+        uint16_t id = heap->GetId();
+        int* p = new (heap) int(3);
+
+        SharedStatsPublisher publisher;
+        ASSERT_TRUE(publisher.Open("/memsentry.test"));
+        publisher.PublishNow();
+
+        // attach like an external reader would: a second, read-only mapping.
+        int fd = shm_open(publisher.GetName(), O_RDONLY, 0);
+        ASSERT_TRUE(fd >= 0);
+        size_t size = RegionSize(MEM_SENTRY::constants::MAX_HEAPS);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        ASSERT_TRUE(mapped != MAP_FAILED);
+
+        const SharedStatsHeader* header = (const SharedStatsHeader*)mapped;
+        ASSERT_EQ(header->m_Magic, SHARED_STATS_MAGIC);
+        ASSERT_TRUE(header->m_SlotCount.load() > id);
+
+        SharedHeapStats stats;
+        ASSERT_TRUE(ReadHeapEntry(Entries(header)[id], stats));
+        ASSERT_TRUE(stats.m_Live);
+        ASSERT_EQ(std::string(stats.m_Name), std::string("SharedStatsHeap"));
+        ASSERT_EQ(stats.m_Bytes, (int64_t)GetTotal(heap));
+        ASSERT_EQ(stats.m_Count, (int64_t)GetCount(heap));
+
+        delete p;
+        delete heap;
+
+        // the background thread clears the entry of the destroyed heap.
+        ASSERT_TRUE(publisher.Start(std::chrono::milliseconds(1)));
+        uint64_t ticks = header->m_Ticks.load();
+        for(int tries = 0; tries < 200 && header->m_Ticks.load() < ticks + 2; ++tries) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ASSERT_TRUE(ReadHeapEntry(Entries(header)[id], stats));
+        ASSERT_TRUE(!stats.m_Live);
+
+        munmap(mapped, size);
+        publisher.Close();
+        ASSERT_TRUE(shm_open("/memsentry.test", O_RDONLY, 0) < 0);
+    }
+    // runs `fn` in a child process and reports whether it died of SIGSEGV.
+    template<typename Fn>
+    static bool FaultsInChild(Fn fn) {
+        std::cout.flush();
+        pid_t pid = fork();
+        if(pid == 0) {
+            fn();
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV;
+    }
+
+    static void TestGuardPageMode() {
+        LOG_TEST("TestGuardPageMode");
+        #if MEM_SENTRY_ENABLE
+        const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+        Heap heap("GuardHeap");
+
+        // right: the data ends exactly on the guard page.
+        heap.SetGuardMode(MEM_SENTRY::guard::GuardMode::Right);
+        Payload16* right = new (&heap) Payload16();
+        ASSERT_EQ(((uintptr_t)right + sizeof(Payload16)) % page, (uintptr_t)0);
+        ASSERT_EQ(GetCount(&heap), (size_t)1);
+        right->bytes[15] = 1;
+        ASSERT_TRUE(FaultsInChild([&] { ((volatile char*)right)[16] = 1; }));
+
+        // odd sizes keep a few checked slack bytes before the guard.
+        Payload100* odd = new (&heap) Payload100();
+        odd->bytes[99] = 1;
+        ASSERT_TRUE(FaultsInChild([&] { ((volatile char*)odd)[page] = 1; }));
+        delete odd;
+
+        // explicit alignment is honoured.
+        AlignedDeepData* aligned = new (&heap) AlignedDeepData();
+        ASSERT_EQ((uintptr_t)aligned % alignof(AlignedDeepData), (uintptr_t)0);
+        delete aligned;
+
+        // alignments the header can't record get a regular block.
+        void* wide = operator new(64, std::align_val_t(4096), &heap);
+        ASSERT_EQ((uintptr_t)wide % 4096, (uintptr_t)0);
+        ASSERT_EQ(((AllocHeader*)wide - 1)->m_Flags & MEM_SENTRY::alloc_header::ALLOC_FLAG_GUARD_MASK, 0);
+        operator delete(wide, std::align_val_t(4096));
+
+        // freed blocks stay inaccessible while quarantined.
+        delete right;
+        ASSERT_EQ(GetCount(&heap), (size_t)0);
+        ASSERT_TRUE(MEM_SENTRY::guard::CachedBytes() > 0);
+        ASSERT_TRUE(FaultsInChild([&] { ((volatile char*)right)[0] = 1; }));
+
+        // left: an underflow past the header faults.
+        heap.SetGuardMode(MEM_SENTRY::guard::GuardMode::Left);
+        Payload16* left = new (&heap) Payload16();
+        ASSERT_EQ(((uintptr_t)left - sizeof(AllocHeader)) % page, (uintptr_t)0);
+        left->bytes[0] = 1;
+        ASSERT_TRUE(FaultsInChild([&] { ((volatile char*)left)[-(long)sizeof(AllocHeader) - 1] = 1; }));
+        delete left;
+
+        // back to regular allocations.
+        heap.SetGuardMode(MEM_SENTRY::guard::GuardMode::None);
+        int* plain = new (&heap) int(1);
+        AllocHeader* header = (AllocHeader*)((char*)plain - sizeof(AllocHeader));
+        ASSERT_EQ((int)header->m_Flags, 0);
+        delete plain;
+
+        MEM_SENTRY::guard::Trim();
+        ASSERT_EQ(MEM_SENTRY::guard::CachedBytes(), (size_t)0);
+        #endif
+    }
+    static void TestUseAfterFreeQuarantine() {
+        LOG_TEST("TestUseAfterFreeQuarantine");
+        #if MEM_SENTRY_ENABLE
+        namespace quarantine = MEM_SENTRY::quarantine;
+        Heap heap("QuarantineHeap");
+
+        quarantine::Flush();
+        size_t capacity = quarantine::GetThreadCapacity();
+        uint64_t corruptions = quarantine::CorruptionCount();
+
+        // deleted blocks are poisoned and held back, their header stays "freed".
+        Payload100* p = new (&heap) Payload100();
+        delete p;
+        ASSERT_EQ(GetCount(&heap), (size_t)0);
+        ASSERT_EQ(quarantine::ThreadBytes(), (size_t)100);
+        AllocHeader* header = (AllocHeader*)((char*)p - sizeof(AllocHeader));
+        ASSERT_EQ(header->m_Signature, MEM_SENTRY::constants::MEMSYSTEM_FREED_SIGNATURE);
+        ASSERT_EQ((int)(unsigned char)p->bytes[50], (int)MEM_SENTRY::constants::QUARANTINE_POISON_BYTE);
+
+        // a write after free is reported when the block leaves the quarantine.
+        p->bytes[42] = 7;
+        quarantine::Flush();
+        ASSERT_EQ(quarantine::ThreadBytes(), (size_t)0);
+        ASSERT_EQ(quarantine::CorruptionCount(), corruptions + 1);
+
+        // bounded by bytes: the oldest blocks are evicted in batches.
+        quarantine::SetThreadCapacity(1000);
+        for(int i = 0; i < 100; ++i) delete new (&heap) Payload100();
+        ASSERT_TRUE(quarantine::ThreadBytes() <= 1000);
+        ASSERT_TRUE(quarantine::ThreadBytes() > 0);
+        ASSERT_EQ(quarantine::CorruptionCount(), corruptions + 1);
+
+        // disabled: freed right away.
+        quarantine::Flush();
+        quarantine::SetThreadCapacity(0);
+        delete new (&heap) Payload100();
+        ASSERT_EQ(quarantine::ThreadBytes(), (size_t)0);
+
+        quarantine::SetThreadCapacity(capacity);
+        #endif
+    }
+    static void TestPoisonKernels() {
+        LOG_TEST("TestPoisonKernels");
+        namespace poison = MEM_SENTRY::poison;
+        using poison::Kernel;
+
+        Kernel detected = poison::GetKernel();
+        std::vector<unsigned char> buffer(300);
+        const uint32_t canary = MEM_SENTRY::constants::MEMSYSTEM_ENDMARKER;
+
+        for(Kernel kernel : {Kernel::Scalar, Kernel::SSE2, Kernel::AVX2}) {
+            if(!poison::SetKernel(kernel)) continue;
+            ASSERT_TRUE(poison::GetKernel() == kernel);
+
+            // every length and misalignment around the vector widths.
+            for(size_t offset = 0; offset < 5; ++offset) {
+                for(size_t size = 0; size + offset <= 200; size += 7) {
+                    unsigned char* p = buffer.data() + offset;
+                    poison::Fill(p, size, 0xDD);
+                    ASSERT_EQ(poison::Verify(p, size, 0xDD), size);
+
+                    if(size) {
+                        p[size / 2] ^= 1;
+                        ASSERT_EQ(poison::Verify(p, size, 0xDD), size / 2);
+                    }
+
+                    poison::Fill32(p, size, canary);
+                    ASSERT_EQ(poison::Verify32(p, size, canary), size);
+                    if(size >= 4) {
+                        uint32_t word;
+                        std::memcpy(&word, p, 4);
+                        ASSERT_EQ(word, canary);
+                        p[size - 1] ^= 0x80;
+                        ASSERT_EQ(poison::Verify32(p, size, canary), size - 1);
+                    }
+                }
+            }
+        }
+        poison::SetKernel(detected);
+
+        // allocation fill mode.
+        #if MEM_SENTRY_ENABLE
+        Heap heap("PoisonHeap");
+        poison::SetAllocFill(true);
+        Payload100* p = new (&heap) Payload100;
+        poison::SetAllocFill(false);
+        ASSERT_EQ(poison::Verify(p->bytes, sizeof(p->bytes), MEM_SENTRY::constants::ALLOC_FILL_BYTE), sizeof(p->bytes));
+        delete p;
+        #endif
+    }
+    static void TestCanariesAndScrubber() {
+        LOG_TEST("TestCanariesAndScrubber");
+        #if MEM_SENTRY_ENABLE
+        namespace canary = MEM_SENTRY::canary;
+        Heap heap("ScrubHeap");
+
+        // per-allocation random canaries on both sides.
+        Payload100* a = new (&heap) Payload100();
+        Payload100* b = new (&heap) Payload100();
+        AllocHeader* headerA = (AllocHeader*)((char*)a - sizeof(AllocHeader));
+        AllocHeader* headerB = (AllocHeader*)((char*)b - sizeof(AllocHeader));
+        ASSERT_EQ((size_t)headerA->m_CanarySize, canary::GetCanarySize());
+        ASSERT_TRUE(headerA->m_CanarySeed != headerB->m_CanarySeed);
+        ASSERT_TRUE(canary::Check(headerA) == canary::Status::Ok);
+
+        // the scrubber finds an overflow while the block is still live, and reports it once.
+        MEM_SENTRY::scrubber::HeapScrubber scrubber(1000000);
+        scrubber.ScrubNow();
+        uint64_t corruptions = scrubber.CorruptionCount();
+
+        char saved = ((char*)a)[103];
+        ((char*)a)[103] ^= 0x5A;
+        ASSERT_TRUE(canary::Check(headerA) == canary::Status::BackCanary);
+        ASSERT_TRUE(scrubber.ScrubNow() >= 1);
+        ASSERT_TRUE(scrubber.CorruptionCount() > corruptions);
+        ASSERT_TRUE(headerA->m_ScrubReported != 0);
+        ASSERT_EQ(headerA->m_Flags, (uint8_t)0);
+        ((char*)a)[103] = saved;
+
+        // underflow into the front canary.
+        unsigned char* front = (unsigned char*)headerB - 1;
+        unsigned char savedFront = *front;
+        *front ^= 0xFF;
+        ASSERT_TRUE(canary::Check(headerB) == canary::Status::FrontCanary);
+        *front = savedFront;
+        ASSERT_TRUE(canary::Check(headerB) == canary::Status::Ok);
+
+        delete a;
+        delete b;
+
+        // configurable size, rounded to 16.
+        size_t defaultSize = canary::GetCanarySize();
+        canary::SetCanarySize(20);
+        ASSERT_EQ(canary::GetCanarySize(), (size_t)32);
+        AlignedDeepData* aligned = new (&heap) AlignedDeepData();
+        AllocHeader* alignedHeader = (AllocHeader*)((char*)aligned - sizeof(AllocHeader));
+        ASSERT_EQ((int)alignedHeader->m_CanarySize, 32);
+        ASSERT_EQ((uintptr_t)aligned % alignof(AlignedDeepData), (uintptr_t)0);
+        ASSERT_TRUE(canary::Check(alignedHeader) == canary::Status::Ok);
+        delete aligned;
+        canary::SetCanarySize(0);
+        int* bare = new (&heap) int(1);
+        ASSERT_EQ((int)((AllocHeader*)((char*)bare - sizeof(AllocHeader)))->m_CanarySize, 0);
+        delete bare;
+        canary::SetCanarySize(defaultSize);
+
+        // incremental walk: bounded steps, resuming where the previous one stopped.
+        std::vector<int*> ptrs;
+        for(int i = 0; i < 25; ++i) ptrs.push_back(new (&heap) int(i));
+        size_t visits = 0;
+        auto count = [](AllocHeader*, void* context) { ++*(size_t*)context; };
+        int steps = 1;
+        while(!heap.ScrubStep(10, count, &visits)) ++steps;
+        ASSERT_EQ(steps, 3);
+        ASSERT_EQ(visits, (size_t)25);
+
+        // a heap destroyed with its cursor parked leaves it behind.
+        Heap* temp = new Heap("ScrubTemp");
+        std::vector<int*> orphans;
+        for(int i = 0; i < 5; ++i) orphans.push_back(new (temp) int(i));
+        ASSERT_TRUE(!temp->ScrubStep(2, count, &visits));
+        delete temp;
+        for(int* p : orphans) delete p;
+        for(int* p : ptrs) delete p;
+
+        // background mode, one scrubber at a time.
+        MEM_SENTRY::scrubber::HeapScrubber background;
+        ASSERT_TRUE(background.Start(std::chrono::milliseconds(1)));
+        ASSERT_TRUE(!scrubber.Start(std::chrono::milliseconds(1)));
+        for(int tries = 0; tries < 200 && background.CheckedCount() == 0; ++tries) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        background.Stop();
+        ASSERT_TRUE(background.CheckedCount() > 0);
+        #endif
+    }
+    static void TestReallocResize() {
+        LOG_TEST("TestReallocResize");
+        #if MEM_SENTRY_ENABLE
+        namespace canary = MEM_SENTRY::canary;
+        Heap heap("ResizeHeap");
+
+        // null allocates on the requested heap.
+        char* block = (char*)sentry_realloc(nullptr, 10, &heap);
+        ASSERT_TRUE(block != nullptr);
+        ASSERT_EQ(heap.CountAllocations(), 1);
+        AllocHeader* header = (AllocHeader*)block - 1;
+        uint32_t allocId = header->m_AllocId;
+        for(int i = 0; i < 10; ++i) block[i] = (char)i;
+
+        // growing within the malloc slack keeps the block where it is.
+        ASSERT_TRUE(sentry_resize_in_place(block, 12));
+        ASSERT_EQ(header->m_Size, 12u);
+        ASSERT_EQ(heap.GetTotal(), 12);
+        ASSERT_TRUE(canary::Check(header) == canary::Status::Ok);
+        ASSERT_TRUE(sentry_realloc(block, 11) == block);
+
+        // a large growth moves the data, but keeps the id, the heap and the count.
+        ASSERT_TRUE(!sentry_resize_in_place(block, 1 << 20));
+        char* moved = (char*)sentry_realloc(block, 1 << 20);
+        ASSERT_TRUE(moved != nullptr && moved != block);
+        AllocHeader* movedHeader = (AllocHeader*)moved - 1;
+        ASSERT_EQ(movedHeader->m_AllocId, allocId);
+        ASSERT_EQ(heap.CountAllocations(), 1);
+        ASSERT_EQ(heap.GetTotal(), 1 << 20);
+        for(int i = 0; i < 10; ++i) ASSERT_EQ(moved[i], (char)i);
+        ASSERT_TRUE(canary::Check(movedHeader) == canary::Status::Ok);
+
+        // the moved block took the old one's place in the list.
+        int* before = new (&heap) int(1);
+        char* again = (char*)sentry_realloc(moved, 2 << 20);
+        AllocHeader* last = nullptr;
+        auto remember = [](AllocHeader* alloc, void* context) { *(AllocHeader**)context = alloc; };
+        while(!heap.ScrubStep(1, remember, &last)) {}
+        ASSERT_EQ(last, (AllocHeader*)before - 1);
+        ASSERT_EQ(heap.CountAllocations(), 2);
+
+        // shrinking always fits.
+        ASSERT_TRUE(sentry_resize_in_place(again, 3));
+        ASSERT_EQ(heap.GetTotal(), 3 + (int)sizeof(int));
+        ASSERT_TRUE(canary::Check((AllocHeader*)again - 1) == canary::Status::Ok);
+
+        // aligned blocks keep their alignment when they move.
+        AlignedDeepData* aligned = new (&heap) AlignedDeepData();
+        void* alignedMoved = sentry_realloc(aligned, 4096);
+        ASSERT_EQ((uintptr_t)alignedMoved % alignof(AlignedDeepData), (uintptr_t)0);
+        ASSERT_EQ(((AllocHeader*)alignedMoved - 1)->m_Alignment, (uint8_t)alignof(AlignedDeepData));
+
+        // size 0 frees.
+        ASSERT_TRUE(sentry_realloc(alignedMoved, 0) == nullptr);
+        ASSERT_TRUE(sentry_realloc(again, 0) == nullptr);
+        delete before;
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        ASSERT_EQ(heap.GetTotal(), 0);
+        #endif
+    }
+    static void TestMallocInterposition() {
+        LOG_TEST("TestMallocInterposition");
+        #if MEM_SENTRY_ENABLE
+        namespace interpose = MEM_SENTRY::interpose;
+
+        // bypass scopes nest.
+        ASSERT_TRUE(!interpose::IsBypassed());
+        {
+            interpose::BypassScope outer;
+            {
+                interpose::BypassScope inner;
+                ASSERT_TRUE(interpose::IsBypassed());
+            }
+            ASSERT_TRUE(interpose::IsBypassed());
+        }
+        ASSERT_TRUE(!interpose::IsBypassed());
+
+        // C allocations get their own heap unless redirected.
+        Heap* mallocHeap = interpose::GetHeap();
+        ASSERT_TRUE(std::strcmp(mallocHeap->GetName(), "MallocHeap") == 0);
+        ASSERT_TRUE(mallocHeap != MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+        Heap heap("CHeap");
+        interpose::SetHeap(&heap);
+        ASSERT_EQ(interpose::GetHeap(), &heap);
+        interpose::SetHeap(nullptr);
+        ASSERT_EQ(interpose::GetHeap(), mallocHeap);
+
+        #ifdef MEM_SENTRY_PRELOAD_LIB
+        // real programs under the interposer: they run normally and report their malloc heap.
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(fds[1], STDERR_FILENO);
+            close(fds[0]);
+            setenv("LD_PRELOAD", MEM_SENTRY_PRELOAD_LIB, 1);
+            setenv("MEMSENTRY_REPORT", "1", 1);
+            execl("/bin/sh", "sh", "-c", "x=$(echo abc); test \"$x\" = abc && printf 'b\\na\\n' | sort > /dev/null",
+                  (char*)nullptr);
+            _exit(127);
+        }
+        close(fds[1]);
+
+        char output[4096];
+        size_t length = 0;
+        ssize_t got;
+        while ((got = read(fds[0], output + length, sizeof(output) - 1 - length)) > 0) length += (size_t)got;
+        output[length] = '\0';
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        ASSERT_TRUE(std::strstr(output, "MemSentry: MallocHeap:") != nullptr);
+        #endif
+        #endif
+    }
+    static void TestHeapAllocator() {
+        LOG_TEST("TestHeapAllocator");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::allocator::HeapAllocator;
+        Heap heap("ContainerHeap");
+
+        // container storage lands on the allocator's heap, and is released with it.
+        {
+            std::vector<int, HeapAllocator<int>> values{HeapAllocator<int>(&heap)};
+            for(int i = 0; i < 100; ++i) values.push_back(i);
+            ASSERT_EQ(heap.CountAllocations(), 1);
+            ASSERT_TRUE(heap.GetTotal() >= 100 * (int)sizeof(int));
+
+            // copies keep the heap.
+            std::vector<int, HeapAllocator<int>> copy = values;
+            ASSERT_EQ(copy.get_allocator().GetHeap(), &heap);
+            ASSERT_EQ(heap.CountAllocations(), 2);
+
+            // rebinding (node containers) keeps it as well.
+            std::list<int, HeapAllocator<int>> nodes{HeapAllocator<int>(&heap)};
+            nodes.push_back(1);
+            nodes.push_back(2);
+            ASSERT_EQ(heap.CountAllocations(), 4);
+
+            // over-aligned elements take the aligned path.
+            HeapAllocator<AlignedDeepData> alignedAllocator(&heap);
+            AlignedDeepData* aligned = alignedAllocator.allocate(3);
+            ASSERT_EQ((uintptr_t)aligned % alignof(AlignedDeepData), (uintptr_t)0);
+            alignedAllocator.deallocate(aligned, 3);
+        }
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        ASSERT_EQ(heap.GetTotal(), 0);
+
+        // a block outliving its allocator's heap is released through the orphan heap.
+        Heap* orphan = MEM_SENTRY::heap::HeapFactory::GetOrphanHeap();
+        size_t orphanStart = GetCount(orphan);
+        Heap* shortLived = new Heap("ShortLivedContainerHeap");
+        HeapAllocator<int> shortAllocator(shortLived);
+        int* survivor = shortAllocator.allocate(8);
+        delete shortLived;
+        ASSERT_EQ(GetCount(orphan), orphanStart + 1);
+        shortAllocator.deallocate(survivor, 8);
+        ASSERT_EQ(GetCount(orphan), orphanStart);
+
+        // equality follows the heap.
+        Heap other("OtherContainerHeap");
+        ASSERT_TRUE(HeapAllocator<int>(&heap) == HeapAllocator<long>(&heap));
+        ASSERT_TRUE(!(HeapAllocator<int>(&heap) == HeapAllocator<int>(&other)));
+        ASSERT_EQ(HeapAllocator<int>().GetHeap(), MEM_SENTRY::heap::HeapFactory::GetDefaultHeap());
+
+        // pmr adapter.
+        {
+            MEM_SENTRY::allocator::HeapResource resource(&heap);
+            std::pmr::vector<int> values(&resource);
+            values.assign(50, 7);
+            ASSERT_EQ(heap.CountAllocations(), 1);
+            MEM_SENTRY::allocator::HeapResource same(&heap);
+            MEM_SENTRY::allocator::HeapResource different(&other);
+            ASSERT_TRUE(resource.is_equal(same));
+            ASSERT_TRUE(!resource.is_equal(different));
+        }
+        ASSERT_EQ(heap.CountAllocations(), 0);
+
+        // containers of a tracked object inherit the class's heap.
+        InventoryObject::setHeap(&heap);
+        InventoryObject* inventory = new InventoryObject();
+        inventory->items.assign(10, 1);
+        ASSERT_EQ(inventory->items.get_allocator().GetHeap(), &heap);
+        ASSERT_EQ(heap.CountAllocations(), 2);
+        delete inventory;
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        InventoryObject::setHeap(nullptr);
+        #endif
+    }
+    static void TestHeapScope() {
+        LOG_TEST("TestHeapScope");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::heap::HeapScope;
+        Heap* defaultHeap = MEM_SENTRY::heap::HeapFactory::GetDefaultHeap();
+        Heap subsystem("SubsystemHeap");
+        Heap nested("NestedScopeHeap");
+
+        int* outside = new int(0);
+        int* inside;
+        int* inner;
+        std::string* text;
+        {
+            HeapScope scope(&subsystem);
+            ASSERT_EQ(MEM_SENTRY::heap::CurrentHeap(), &subsystem);
+
+            // untyped allocations of the thread follow the scope, whatever allocates them.
+            inside = new int(1);
+            text = new std::string(100, 'x');
+            ASSERT_EQ(subsystem.CountAllocations(), 3);
+
+            {
+                HeapScope innerScope(&nested);
+                inner = new int(2);
+                ASSERT_EQ(nested.CountAllocations(), 1);
+            }
+            ASSERT_EQ(MEM_SENTRY::heap::CurrentHeap(), &subsystem);
+
+            // explicit heaps and ISentry classes are not redirected.
+            int* explicitHeap = new (&nested) int(3);
+            ASSERT_EQ(nested.CountAllocations(), 2);
+            delete explicitHeap;
+            InventoryObject* inventory = new InventoryObject();
+            ASSERT_EQ(subsystem.CountAllocations(), 3);
+            delete inventory;
+
+            // other threads keep their own routing.
+            std::thread other([&] {
+                ASSERT_EQ(MEM_SENTRY::heap::CurrentHeap(), defaultHeap);
+            });
+            other.join();
+
+            // blocks return to their own heap.
+            delete outside;
+        }
+        ASSERT_EQ(MEM_SENTRY::heap::CurrentHeap(), defaultHeap);
+
+        delete inside;
+        delete text;
+        delete inner;
+        ASSERT_EQ(subsystem.CountAllocations(), 0);
+        ASSERT_EQ(nested.CountAllocations(), 0);
+        #endif
+    }
+    static void TestSentryLite() {
+        LOG_TEST("TestSentryLite");
+        // zero per-object overhead, and the type stays trivial.
+        static_assert(sizeof(LiteParticle) == 4 * sizeof(float));
+        static_assert(!std::is_polymorphic_v<LiteParticle>);
+        static_assert(std::is_trivially_copyable_v<LiteParticle>);
+        static_assert(std::is_trivially_destructible_v<LiteParticle>);
+        static_assert(sizeof(LiteBlock) == 64);
+        static_assert(sizeof(PhysicsObject) == 3 * sizeof(double) + sizeof(void*));
+
+        #if MEM_SENTRY_ENABLE
+        Heap heap("LiteHeap");
+        Heap other("LiteOtherHeap");
+        LiteParticle::setHeap(&heap);
+        LiteBlock::setHeap(&heap);
+
+        LiteParticle* particle = new LiteParticle{};
+        AllocHeader* header = (AllocHeader*)particle - 1;
+        ASSERT_EQ(header->m_Size, (uint32_t)sizeof(LiteParticle));
+        ASSERT_EQ(heap.CountAllocations(), 1);
+
+        // trivial element arrays get no array cookie.
+        LiteParticle* particles = new LiteParticle[10];
+        ASSERT_EQ(((AllocHeader*)particles - 1)->m_Size, (uint32_t)(10 * sizeof(LiteParticle)));
+
+        LiteBlock* block = new LiteBlock();
+        ASSERT_EQ((uintptr_t)block % 64, (uintptr_t)0);
+
+        // blocks placed on another heap are still freed to it.
+        LiteParticle* elsewhere = new (&other) LiteParticle{};
+        ASSERT_EQ(other.CountAllocations(), 1);
+
+        delete particle;
+        delete[] particles;
+        delete block;
+        delete elsewhere;
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        ASSERT_EQ(heap.GetTotal(), 0);
+        ASSERT_EQ(other.CountAllocations(), 0);
+
+        // a constructor throwing inside a nothrow new releases (and uncounts) its block.
+        LiteThrowing::setHeap(&heap);
+        LiteThrowingAligned::setHeap(&heap);
+        int thrown = 0;
+        try { (void)new (std::nothrow) LiteThrowing(true); } catch(const std::runtime_error&) { ++thrown; }
+        try { (void)new (std::nothrow) LiteThrowing[2]{LiteThrowing(false), LiteThrowing(true)}; } catch(const std::runtime_error&) { ++thrown; }
+        try { (void)new (std::nothrow) LiteThrowingAligned(true); } catch(const std::runtime_error&) { ++thrown; }
+        try { (void)new (&heap) LiteThrowing(true); } catch(const std::runtime_error&) { ++thrown; }
+        ASSERT_EQ(thrown, 4);
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        MEM_SENTRY::census::TypeCensus census = MEM_SENTRY::census::TypeCensus::Take();
+        const MEM_SENTRY::census::TypeEntry* throwing = census.Find("LiteThrowing");
+        ASSERT_TRUE(!throwing || throwing->m_Live == 0);
+        LiteThrowing::setHeap(nullptr);
+        LiteThrowingAligned::setHeap(nullptr);
+
+        // the polymorphic ISentry shares the routing (and the sized deletes).
+        PhysicsObject::setHeap(&heap);
+        PhysicsObject* physics = new PhysicsObject();
+        ASSERT_EQ(heap.CountAllocations(), 1);
+        delete physics;
+        ASSERT_EQ(heap.CountAllocations(), 0);
+
+        PhysicsObject::setHeap(nullptr);
+        LiteParticle::setHeap(nullptr);
+        LiteBlock::setHeap(nullptr);
+        #endif
+    }
+    static void TestTaggedHeapBinding() {
+        LOG_TEST("TestTaggedHeapBinding");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::sentry::BoundHeap;
+        Heap* bound = BoundHeap<TaggedHeapTag>::Get();
+        ASSERT_TRUE(std::strcmp(bound->GetName(), "TaggedHeap") == 0);
+        ASSERT_EQ(MEM_SENTRY::registry::Find(bound->GetId()), bound);
+
+        // every class sharing the tag allocates on the same heap, with no setHeap().
+        int before = bound->CountAllocations();
+        TaggedVoice* voice = new TaggedVoice{};
+        TaggedEffect* effect = new TaggedEffect();
+        TaggedVoice* voices = new TaggedVoice[4];
+        ASSERT_EQ(bound->CountAllocations(), before + 3);
+
+        // explicit heaps still win.
+        Heap other("UntaggedHeap");
+        TaggedVoice* elsewhere = new (&other) TaggedVoice{};
+        ASSERT_EQ(other.CountAllocations(), 1);
+
+        // container members follow the bound heap too.
+        TaggedEffect::Allocator<int> allocator;
+        ASSERT_EQ(allocator.GetHeap(), bound);
+
+        delete voice;
+        delete effect;
+        delete[] voices;
+        delete elsewhere;
+        ASSERT_EQ(bound->CountAllocations(), before);
+        ASSERT_EQ(other.CountAllocations(), 0);
+        #endif
+    }
+    static void TestObjectPool() {
+        LOG_TEST("TestObjectPool");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::alloc_header::AllocHeader;
+        using MEM_SENTRY::alloc_header::ALLOC_FLAG_POOLED;
+
+        auto pooled = [](void* ptr) {
+            return (((AllocHeader*)ptr - 1)->m_Flags & ALLOC_FLAG_POOLED) != 0;
+        };
+
+        Heap heap("PoolHeap");
+        PooledNode::setHeap(&heap);
+        PooledNode::usePool(4);
+        ASSERT_TRUE(PooledNode::pPool != nullptr);
+
+        // pooled objects are regular allocations of the class heap.
+        PooledNode* nodes[5];
+        for (int i = 0; i < 5; ++i) {
+            nodes[i] = new PooledNode();
+            nodes[i]->value = i;
+        }
+        ASSERT_EQ(heap.CountAllocations(), 5);
+        ASSERT_EQ(MEM_SENTRY::pool::CarvedSlots(PooledNode::pPool), (size_t)4);
+
+        // past the capacity, allocations fall back to the regular path.
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(pooled(nodes[i]));
+        }
+        ASSERT_TRUE(!pooled(nodes[4]));
+
+        // a freed slot is the next one handed out on this thread.
+        PooledNode* freed = nodes[2];
+        delete freed;
+        nodes[2] = new PooledNode();
+        ASSERT_EQ(nodes[2], freed);
+        ASSERT_TRUE(pooled(nodes[2]));
+        ASSERT_EQ(heap.CountAllocations(), 5);
+
+        // pooled blocks can be resized only by moving them off the pool.
+        ASSERT_TRUE(!sentry_resize_in_place(nodes[0], sizeof(PooledNode) + 8));
+
+        // slots freed on another thread go back to the pool.
+        std::thread worker([&]() {
+            for (int i = 0; i < 4; ++i) {
+                delete nodes[i];
+            }
+            MEM_SENTRY::pool::Flush();
+        });
+        worker.join();
+        delete nodes[4];
+        ASSERT_EQ(heap.CountAllocations(), 0);
+
+        for (int i = 0; i < 4; ++i) {
+            nodes[i] = new PooledNode();
+            ASSERT_TRUE(pooled(nodes[i]));
+        }
+        ASSERT_EQ(MEM_SENTRY::pool::CarvedSlots(PooledNode::pPool), (size_t)4);
+        for (int i = 0; i < 4; ++i) {
+            delete nodes[i];
+        }
+
+        // over-aligned slots keep the alignment of the type.
+        PooledVector::usePool(8);
+        PooledVector* vector = new PooledVector();
+        ASSERT_TRUE(pooled(vector));
+        ASSERT_EQ((uintptr_t)vector % 64, (uintptr_t)0);
+        delete vector;
+
+        // an alignment past the pool's takes the regular path.
+        void* wide = PooledVector::operator new(sizeof(PooledVector), std::align_val_t(256));
+        ASSERT_TRUE(!pooled(wide));
+        ASSERT_EQ((uintptr_t)wide % 256, (uintptr_t)0);
+        PooledVector::operator delete(wide, sizeof(PooledVector), std::align_val_t(256));
+
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        PooledNode::setHeap(nullptr);
+        #endif
+    }
+    static void TestTypeCensus() {
+        LOG_TEST("TestTypeCensus");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::census::TypeCensus;
+        using MEM_SENTRY::census::TypeEntry;
+
+        Heap heapA("CensusHeapA");
+        Heap heapB("CensusHeapB");
+
+        // instances of one type are counted together, whatever heap they're on.
+        CensusEffect::setHeap(&heapA);
+        CensusEffect* effects[5];
+        for (int i = 0; i < 3; ++i) effects[i] = new CensusEffect();
+        for (int i = 3; i < 5; ++i) effects[i] = new (&heapB) CensusEffect();
+
+        CensusAudio* audio = new CensusAudio();
+        CensusAudio* tracks = new CensusAudio[4];
+
+        TypeCensus census = TypeCensus::Take();
+        const TypeEntry* effectEntry = census.Find("CensusEffect");
+        const TypeEntry* audioEntry = census.Find("CensusAudio");
+        ASSERT_TRUE(effectEntry != nullptr);
+        ASSERT_TRUE(audioEntry != nullptr);
+
+        ASSERT_EQ(effectEntry->m_Live, (uint64_t)5);
+        ASSERT_EQ(effectEntry->m_Bytes, (uint64_t)(5 * sizeof(CensusEffect)));
+
+        // arrays count each element (the cookie in front of them is not an instance).
+        ASSERT_EQ(audioEntry->m_Live, (uint64_t)5);
+        ASSERT_TRUE(audioEntry->m_Bytes >= 5 * sizeof(CensusAudio));
+
+        // trivially destructible elements have no cookie.
+        CensusSample* samples = new CensusSample[8];
+        ASSERT_EQ(TypeCensus::Take().Find("CensusSample")->m_Live, (uint64_t)8);
+        delete[] samples;
+        ASSERT_EQ(TypeCensus::Take().Find("CensusSample")->m_Live, (uint64_t)0);
+
+        // sorted by bytes, largest first.
+        ASSERT_TRUE(audioEntry < effectEntry);
+
+        for (CensusEffect* effect : effects) delete effect;
+        delete audio;
+        delete[] tracks;
+
+        census = TypeCensus::Take();
+        effectEntry = census.Find("CensusEffect");
+        ASSERT_TRUE(effectEntry != nullptr);
+        ASSERT_EQ(effectEntry->m_Live, (uint64_t)0);
+        ASSERT_EQ(effectEntry->m_Bytes, (uint64_t)0);
+        ASSERT_EQ(effectEntry->m_PeakBytes, (uint64_t)(5 * sizeof(CensusEffect)));
+        ASSERT_EQ(census.Find("CensusAudio")->m_Live, (uint64_t)0);
+        ASSERT_EQ(census.Find("CensusAudio")->m_Bytes, (uint64_t)0);
+
+        CensusEffect::setHeap(nullptr);
+        #endif
+    }
+    static void TestAllocationSites() {
+        LOG_TEST("TestAllocationSites");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::alloc_header::AllocHeader;
+        using MEM_SENTRY::sites::SiteInfo;
+        using MEM_SENTRY::sites::SiteSummary;
+
+        auto siteOf = [](void* ptr) { return ((AllocHeader*)ptr - 1)->m_SiteId; };
+
+        Heap heap("SiteHeap");
+
+        const uint32_t valueLine = __LINE__ + 1;
+        int* value = MS_NEW(&heap) int(5);
+        ASSERT_EQ(*value, 5);
+
+        char* buffers[3];
+        for (char*& buffer : buffers) {
+            buffer = MS_NEW(&heap) char[100];
+        }
+
+        int* untagged = new (&heap) int(6);
+
+        // one id per call site, resolved back to the source location.
+        ASSERT_TRUE(siteOf(value) != 0);
+        ASSERT_EQ(siteOf(untagged), (uint32_t)0);
+        ASSERT_EQ(siteOf(buffers[0]), siteOf(buffers[1]));
+        ASSERT_EQ(siteOf(buffers[0]), siteOf(buffers[2]));
+        ASSERT_TRUE(siteOf(buffers[0]) != siteOf(value));
+
+        const SiteInfo* info = MEM_SENTRY::sites::Lookup(siteOf(value));
+        ASSERT_TRUE(info != nullptr);
+        ASSERT_EQ(info->m_Line, valueLine);
+        ASSERT_TRUE(std::strstr(info->m_File, "test_runner") != nullptr);
+        ASSERT_TRUE(std::strstr(info->m_Function, "TestAllocationSites") != nullptr);
+
+        // the summary groups the live blocks by site, largest first.
+        SiteSummary summary = heap.SummarizeSites();
+        ASSERT_EQ(summary.GetTotalCount(), (uint64_t)5);
+        ASSERT_EQ(summary.GetEntries().size(), (size_t)3);
+        ASSERT_EQ(summary.GetEntries()[0].m_SiteId, siteOf(buffers[0]));
+        ASSERT_EQ(summary.GetEntries()[0].m_Count, (uint32_t)3);
+        ASSERT_EQ(summary.GetEntries()[0].m_Bytes, (uint64_t)300);
+
+        // bookmarks restrict the summary like ReportMemory().
+        uint32_t firstId = ((AllocHeader*)buffers[1] - 1)->m_AllocId;
+        ASSERT_EQ(heap.SummarizeSites(firstId, firstId).GetTotalCount(), (uint64_t)1);
+
+        // a moved block keeps its site.
+        uint32_t bufferSite = siteOf(buffers[2]);
+        buffers[2] = (char*)sentry_realloc(buffers[2], 64 * 1024);
+        ASSERT_EQ(siteOf(buffers[2]), bufferSite);
+
+        // tracked classes: a null heap is the class heap.
+        CensusEffect::setHeap(&heap);
+        CensusEffect* effect = MS_NEW(nullptr) CensusEffect();
+        ASSERT_TRUE(siteOf(effect) != 0);
+        ASSERT_EQ(heap.CountAllocations(), 6);
+        delete effect;
+        CensusEffect::setHeap(nullptr);
+
+        // a throwing constructor releases its block through the placement delete.
+        struct Throwing {
+            Throwing() { throw std::runtime_error("constructor failed"); }
+        };
+        bool thrown = false;
+        try {
+            (void)(MS_NEW(&heap) Throwing());
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        ASSERT_TRUE(thrown);
+        ASSERT_EQ(heap.CountAllocations(), 5);
+
+        delete value;
+        delete untagged;
+        for (char* buffer : buffers) delete[] buffer;
+        ASSERT_EQ(heap.CountAllocations(), 0);
+        #endif
+    }
+    static void TestAllocationContexts() {
+        LOG_TEST("TestAllocationContexts");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::alloc_header::AllocHeader;
+        using MEM_SENTRY::context::ContextScope;
+        using MEM_SENTRY::context::ContextStats;
+
+        auto contextOf = [](void* ptr) { return ((AllocHeader*)ptr - 1)->m_ContextId; };
+
+        uint16_t search = MEM_SENTRY::context::Register("search");
+        uint16_t upload = MEM_SENTRY::context::Register("upload");
+        ASSERT_TRUE(search != 0 && upload != 0 && search != upload);
+        ASSERT_EQ(MEM_SENTRY::context::Register("search"), search);
+
+        Heap heap("ContextHeap");
+        char* request;
+        int* result;
+        char* nested;
+        char* tail;
+
+        // the context spans heaps, and scopes nest.
+        {
+            ContextScope scope(search);
+            request = new char[100];
+            result = new (&heap) int(1);
+            {
+                ContextScope inner(upload);
+                nested = new char[50];
+            }
+            tail = new char[10];
+        }
+        char* outside = new char[8];
+
+        ASSERT_EQ(contextOf(request), search);
+        ASSERT_EQ(contextOf(result), search);
+        ASSERT_EQ(contextOf(nested), upload);
+        ASSERT_EQ(contextOf(tail), search);
+        ASSERT_EQ(contextOf(outside), (uint16_t)0);
+        ASSERT_EQ(MEM_SENTRY::context::Current(), (uint16_t)0);
+
+        // ids past the table open no context.
+        {
+            ContextScope bogus((uint16_t)(MEM_SENTRY::constants::CONTEXT_MAX_CONTEXTS + 1));
+            ASSERT_EQ(MEM_SENTRY::context::Current(), (uint16_t)0);
+            char* stray = new char[16];
+            ASSERT_EQ(contextOf(stray), (uint16_t)0);
+            delete[] stray;
+        }
+
+        ContextStats stats = MEM_SENTRY::context::GetStats(search);
+        ASSERT_TRUE(std::strcmp(stats.m_Name, "search") == 0);
+        ASSERT_EQ(stats.m_Scopes, (uint64_t)1);
+        ASSERT_EQ(stats.m_Allocs, (uint64_t)3);
+        ASSERT_EQ(stats.m_Allocated, (uint64_t)114);
+        ASSERT_EQ(stats.m_Retained, (uint64_t)114);
+        ASSERT_EQ(MEM_SENTRY::context::GetStats(upload).m_Retained, (uint64_t)50);
+
+        // frees lower the retained bytes of the block's context, from any thread.
+        std::thread worker([&]() { delete[] request; });
+        worker.join();
+
+        stats = MEM_SENTRY::context::GetStats(search);
+        ASSERT_EQ(stats.m_Retained, (uint64_t)14);
+        ASSERT_EQ(stats.m_Peak, (uint64_t)114);
+        ASSERT_EQ(stats.m_Allocated, (uint64_t)114);
+
+        // resized blocks stay in their context.
+        tail = (char*)sentry_realloc(tail, 1000);
+        ASSERT_EQ(contextOf(tail), search);
+        stats = MEM_SENTRY::context::GetStats(search);
+        ASSERT_EQ(stats.m_Retained, (uint64_t)1004);
+        ASSERT_EQ(stats.m_Peak, (uint64_t)1004);
+
+        delete result;
+        delete[] nested;
+        delete[] tail;
+        delete[] outside;
+        ASSERT_EQ(MEM_SENTRY::context::GetStats(search).m_Retained, (uint64_t)0);
+        ASSERT_EQ(MEM_SENTRY::context::GetStats(upload).m_Retained, (uint64_t)0);
+        #endif
+    }
+    static void TestThreadAttribution() {
+        LOG_TEST("TestThreadAttribution");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::alloc_header::AllocHeader;
+        using MEM_SENTRY::threads::ThreadStats;
+
+        Heap heap("ThreadHeap");
+        constexpr int BLOCKS = 8;
+        int* blocks[BLOCKS];
+        uint16_t workerIndex = 0;
+
+        uint16_t mainIndex = MEM_SENTRY::threads::Current();
+        ASSERT_TRUE(mainIndex != MEM_SENTRY::threads::UNASSIGNED);
+        ThreadStats before = MEM_SENTRY::threads::GetStats(mainIndex);
+
+        // the worker allocates, keeps one free local and hands the rest to the main thread.
+        std::thread worker([&]() {
+            for(int i = 0; i < BLOCKS; ++i) blocks[i] = new (&heap) int(i);
+            delete new (&heap) int(-1);
+            workerIndex = MEM_SENTRY::threads::Current();
+        });
+        worker.join();
+
+        ASSERT_TRUE(workerIndex != mainIndex);
+        ASSERT_EQ(((AllocHeader*)blocks[0] - 1)->m_ThreadIndex, workerIndex);
+
+        for(int i = 0; i < BLOCKS; ++i) delete blocks[i];
+
+        ThreadStats workerStats = MEM_SENTRY::threads::GetStats(workerIndex);
+        ASSERT_TRUE(workerStats.m_Tid != 0);
+        ASSERT_EQ(workerStats.m_Allocs, (uint64_t)BLOCKS + 1);
+        ASSERT_EQ(workerStats.m_AllocatedBytes, (uint64_t)((BLOCKS + 1) * sizeof(int)));
+        // std::thread also frees its (main thread allocated) state on the worker: count local frees.
+        ASSERT_EQ(workerStats.m_Frees - workerStats.m_RemoteFrees, (uint64_t)1);
+        ASSERT_EQ(workerStats.m_FreedRemotely, (uint64_t)BLOCKS);
+
+        ThreadStats after = MEM_SENTRY::threads::GetStats(mainIndex);
+        ASSERT_EQ(after.m_Frees - before.m_Frees, (uint64_t)BLOCKS);
+        ASSERT_EQ(after.m_RemoteFrees - before.m_RemoteFrees, (uint64_t)BLOCKS);
+        ASSERT_EQ(after.m_FreedBytes - before.m_FreedBytes, (uint64_t)(BLOCKS * sizeof(int)));
+
+        MEM_SENTRY::threads::ThreadSnapshot snapshot = MEM_SENTRY::threads::ThreadSnapshot::Take();
+        const ThreadStats* entry = snapshot.Find(workerIndex);
+        ASSERT_TRUE(entry != nullptr);
+        ASSERT_EQ(entry->m_FreedRemotely, (uint64_t)BLOCKS);
+        ASSERT_TRUE(snapshot.GetTotalRemoteFrees() >= (uint64_t)BLOCKS);
+        ASSERT_TRUE(snapshot.GetRemoteFreeRatio() > 0.0);
+
+        // the exporter adds the thread families on request only.
+        MEM_SENTRY::exporter::MetricsExporter exporter(1024 * 1024);
+        exporter.Format();
+        ASSERT_TRUE(std::string(exporter.Data(), exporter.Length()).find("memsentry_thread_") == std::string::npos);
+
+        exporter.SetThreadMetrics(true);
+        ASSERT_TRUE(exporter.Format() > 0);
+        std::string text(exporter.Data(), exporter.Length());
+        ASSERT_TRUE(text.find("# TYPE memsentry_thread_remote_frees counter") != std::string::npos);
+        ASSERT_TRUE(text.find("memsentry_thread_allocations_total{thread=\"" + std::to_string(workerIndex)
+            + "\",tid=\"" + std::to_string(workerStats.m_Tid) + "\"} " + std::to_string(BLOCKS + 1)) != std::string::npos);
+        #endif
+    }
+    static void TestLifetimeProfile() {
+        LOG_TEST("TestLifetimeProfile");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::alloc_header::AllocHeader;
+        using MEM_SENTRY::lifetime::LifetimeReport;
+        using MEM_SENTRY::constants::LIFETIME_BUCKETS;
+
+        ASSERT_EQ(MEM_SENTRY::lifetime::BucketOf(999), (uint32_t)0);
+        ASSERT_EQ(MEM_SENTRY::lifetime::BucketOf(1000), (uint32_t)1);
+        ASSERT_EQ(MEM_SENTRY::lifetime::BucketOf(20000000), (uint32_t)9);
+        ASSERT_EQ(MEM_SENTRY::lifetime::BucketOf(UINT64_MAX), (uint32_t)(LIFETIME_BUCKETS - 1));
+
+        Heap heap("LifetimeHeap");
+        int* before = new (&heap) int(0);
+        ASSERT_EQ(((AllocHeader*)before - 1)->m_Timestamp, (uint64_t)0);
+        ASSERT_EQ(heap.GetLifetimeReport().GetTotalCount(), (uint64_t)0);
+
+        ASSERT_TRUE(heap.SetLifetimeProfile(true));
+        ASSERT_TRUE(heap.ProfilesLifetimes());
+
+        // short lived: freed right away.
+        for(int i = 0; i < 10; ++i) delete new (&heap) int(i);
+
+        // long lived: kept for 20ms, and moved by realloc meanwhile.
+        void* buffer = operator new(2048, &heap);
+        ASSERT_TRUE(((AllocHeader*)buffer - 1)->m_Timestamp != 0);
+        buffer = sentry_realloc(buffer, 4096);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        operator delete(buffer);
+
+        // not timestamped: not counted.
+        delete before;
+
+        LifetimeReport report = heap.GetLifetimeReport();
+        ASSERT_EQ(report.GetTotalCount(), (uint64_t)11);
+        ASSERT_EQ(report.GetTotalBytes(), (uint64_t)(10 * sizeof(int) + 4096));
+
+        uint32_t longBucket = MEM_SENTRY::lifetime::BucketOf(20000000);
+        uint64_t longBytes = 0;
+        uint64_t intCount = 0;
+        for(const auto& entry : report.GetEntries()){
+            if(entry.m_Bucket >= longBucket) longBytes += entry.m_Bytes;
+            if(entry.m_SizeClass == MEM_SENTRY::snapshot::SizeClassOf(sizeof(int))) intCount += entry.m_Count;
+        }
+        ASSERT_EQ(longBytes, (uint64_t)4096);
+        ASSERT_EQ(intCount, (uint64_t)10);
+
+        // byte-weighted median: the single 4 KiB block outweighs the ints.
+        ASSERT_TRUE(report.MedianBucket() >= longBucket);
+        ASSERT_TRUE(report.MedianBucket(MEM_SENTRY::snapshot::SizeClassOf(sizeof(int))) < longBucket);
+
+        // stopping the profile keeps the histogram.
+        heap.SetLifetimeProfile(false);
+        int* after = new (&heap) int(1);
+        ASSERT_EQ(((AllocHeader*)after - 1)->m_Timestamp, (uint64_t)0);
+        delete after;
+        ASSERT_EQ(heap.GetLifetimeReport().GetTotalCount(), (uint64_t)11);
+        #endif
+    }
+    static void TestLeakDetector() {
+        LOG_TEST("TestLeakDetector");
+        #if MEM_SENTRY_ENABLE
+        using MEM_SENTRY::leaks::LeakDetector;
+        using MEM_SENTRY::leaks::LeakEntry;
+        using MEM_SENTRY::leaks::LeakReport;
+
+        auto entriesOf = [](const LeakReport& report, const char* heapName) {
+            std::vector<LeakEntry> entries;
+            for(const LeakEntry& entry : report.GetEntries()){
+                if(std::strcmp(entry.m_HeapName, heapName) == 0) entries.push_back(entry);
+            }
+            return entries;
+        };
+
+        Heap heap("LeakHeap");
+        Heap timedHeap("LeakTimedHeap");
+        timedHeap.SetLifetimeProfile(true);
+
+        char* tagged = MS_NEW(&heap) char[64];
+        int* untagged = new (&heap) int(1);
+        int* timed = new (&timedHeap) int(2);
+        uint32_t taggedSite = ((MEM_SENTRY::alloc_header::AllocHeader*)tagged - 1)->m_SiteId;
+
+        LeakDetector detector(std::chrono::milliseconds(30));
+
+        // the first pass only marks the heaps: nothing is old enough yet.
+        LeakReport first = detector.ScanNow();
+        ASSERT_TRUE(entriesOf(first, "LeakHeap").empty());
+        ASSERT_TRUE(entriesOf(first, "LeakTimedHeap").empty());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        int* young = new (&heap) int(3);
+
+        LeakReport second = detector.ScanNow();
+        std::vector<LeakEntry> suspects = entriesOf(second, "LeakHeap");
+        ASSERT_EQ(suspects.size(), (size_t)2);
+
+        // largest first: the tagged array, then the untagged int (not the young one).
+        ASSERT_EQ(suspects[0].m_SiteId, taggedSite);
+        ASSERT_EQ(suspects[0].m_Count, (uint64_t)1);
+        ASSERT_EQ(suspects[0].m_Bytes, (uint64_t)64);
+        ASSERT_TRUE(suspects[0].m_OldestAge >= 30000000ull);
+        ASSERT_EQ(suspects[1].m_SiteId, (uint32_t)0);
+        ASSERT_EQ(suspects[1].m_Count, (uint64_t)1);
+        ASSERT_EQ(suspects[1].m_OldestAllocId, ((MEM_SENTRY::alloc_header::AllocHeader*)untagged - 1)->m_AllocId);
+        ASSERT_EQ(entriesOf(second, "LeakTimedHeap").size(), (size_t)1);
+
+        // timestamped blocks need no history, whatever the chunk size.
+        LeakDetector fresh(std::chrono::milliseconds(30), 1);
+        LeakReport timedOnly = fresh.ScanNow();
+        ASSERT_TRUE(entriesOf(timedOnly, "LeakHeap").empty());
+        std::vector<LeakEntry> timedSuspects = entriesOf(timedOnly, "LeakTimedHeap");
+        ASSERT_EQ(timedSuspects.size(), (size_t)1);
+        ASSERT_TRUE(timedSuspects[0].m_OldestAge >= 30000000ull);
+
+        // background passes keep the latest report.
+        ASSERT_TRUE(detector.Start(std::chrono::milliseconds(5)));
+        ASSERT_TRUE(!detector.Start(std::chrono::milliseconds(5)));
+        uint64_t passes = detector.PassCount();
+        for(int tries = 0; tries < 200 && detector.PassCount() < passes + 2; ++tries) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        // heaps come and go while passes run: a pass only pins the heap it walks.
+        for(int i = 0; i < 50; ++i) {
+            Heap* transient = new Heap("LeakTransientHeap");
+            int* block = new (transient) int(4);
+            delete block;
+            delete transient;
+        }
+        detector.Stop();
+        ASSERT_TRUE(detector.PassCount() >= passes + 2);
+        ASSERT_EQ(entriesOf(detector.GetReport(), "LeakHeap").size(), (size_t)2);
+
+        delete[] tagged;
+        delete untagged;
+        delete timed;
+        delete young;
+        ASSERT_TRUE(entriesOf(detector.ScanNow(), "LeakHeap").empty());
+        #endif
+    }
 };
 
 int main() {
@@ -0,0 +1,165 @@
+// memsentry-top: live per-heap view of a process publishing MemSentry shared stats.
+//
+// usage: memsentry-top [-i interval_ms] [-n iterations] <shm-name | pid>
+//
+// The region is mapped read-only: the target process is never signalled or
+// called into, and reading it never blocks its publisher.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mem_sentry/shared_stats.h"
+
+using namespace MEM_SENTRY::shared_stats;
+
+namespace {
+    struct PrevCounters {
+        bool m_Valid;
+        uint64_t m_AllocCount;
+        uint64_t m_FreeCount;
+
+        /// @brief rates of the last publisher pass, shown until the next one.
+        double m_AllocRate;
+        double m_FreeRate;
+    };
+
+    void usage() {
+        std::fprintf(stderr, "usage: memsentry-top [-i interval_ms] [-n iterations] <shm-name | pid>\n");
+    }
+
+    const SharedStatsHeader* attach(const char* name, size_t& mappedSize) {
+        int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            std::fprintf(stderr, "Error: can't open shared stats region %s\n", name);
+            return nullptr;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SharedStatsHeader)) {
+            std::fprintf(stderr, "Error: %s is not a MemSentry stats region\n", name);
+            ::close(fd);
+            return nullptr;
+        }
+
+        mappedSize = (size_t)st.st_size;
+        void* region = ::mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (region == MAP_FAILED) {
+            std::fprintf(stderr, "Error: can't map %s\n", name);
+            return nullptr;
+        }
+
+        const SharedStatsHeader* header = (const SharedStatsHeader*)region;
+        if (header->m_Magic != SHARED_STATS_MAGIC || header->m_Version != SHARED_STATS_VERSION
+            || header->m_EntrySize != sizeof(SharedHeapEntry)
+            || RegionSize(header->m_MaxHeaps) > mappedSize) {
+            std::fprintf(stderr, "Error: %s has an unsupported layout\n", name);
+            ::munmap(region, mappedSize);
+            return nullptr;
+        }
+
+        return header;
+    }
+}
+
+int main(int argc, char** argv) {
+    long intervalMs = 500;
+    long iterations = -1;
+
+    int opt;
+    while ((opt = ::getopt(argc, argv, "i:n:h")) != -1) {
+        switch (opt) {
+            case 'i': intervalMs = std::strtol(optarg, nullptr, 10); break;
+            case 'n': iterations = std::strtol(optarg, nullptr, 10); break;
+            default: usage(); return 2;
+        }
+    }
+
+    if (optind != argc - 1 || intervalMs <= 0) {
+        usage();
+        return 2;
+    }
+
+    // a bare pid selects the default region name used by SharedStatsPublisher::Open().
+    char name[64];
+    const char* target = argv[optind];
+    if (target[0] != '/' && std::strspn(target, "0123456789") == std::strlen(target)) {
+        std::snprintf(name, sizeof(name), "/memsentry.%s", target);
+    } else {
+        std::snprintf(name, sizeof(name), "%s", target);
+    }
+
+    size_t mappedSize = 0;
+    const SharedStatsHeader* header = attach(name, mappedSize);
+    if (!header) {
+        return 1;
+    }
+
+    const SharedHeapEntry* entries = Entries(header);
+    std::vector<PrevCounters> prev(header->m_MaxHeaps, PrevCounters{false, 0, 0, 0.0, 0.0});
+    uint64_t prevUpdate = 0;
+    bool interactive = ::isatty(STDOUT_FILENO);
+
+    for (long tick = 0; iterations < 0 || tick < iterations; ++tick) {
+        if (tick) {
+            timespec delay{intervalMs / 1000, (intervalMs % 1000) * 1000000};
+            ::nanosleep(&delay, nullptr);
+        }
+
+        uint64_t update = header->m_UpdateNs.load(std::memory_order_acquire);
+        uint32_t slots = header->m_SlotCount.load(std::memory_order_acquire);
+        if (slots > header->m_MaxHeaps) slots = header->m_MaxHeaps;
+
+        double seconds = (prevUpdate && update > prevUpdate) ? double(update - prevUpdate) / 1e9 : 0.0;
+
+        if (interactive) {
+            std::printf("\033[H\033[2J");
+        }
+        std::printf("MemSentry pid %" PRIu32 "  ticks %" PRIu64 "\n",
+            header->m_Pid, header->m_Ticks.load(std::memory_order_relaxed));
+        std::printf("%5s %-24s %14s %10s %12s %12s\n", "ID", "HEAP", "BYTES", "COUNT", "ALLOC/s", "FREE/s");
+
+        for (uint32_t id = 0; id < slots; ++id) {
+            SharedHeapStats stats;
+            if (!ReadHeapEntry(entries[id], stats) || !stats.m_Live) {
+                prev[id].m_Valid = false;
+                continue;
+            }
+
+            // rates only move when the publisher has produced a new pass: refreshing faster
+            // than it publishes keeps showing the last ones instead of zeros.
+            if (update != prevUpdate) {
+                double allocRate = 0.0, freeRate = 0.0;
+                if (seconds > 0.0 && prev[id].m_Valid
+                    && stats.m_AllocCount >= prev[id].m_AllocCount && stats.m_FreeCount >= prev[id].m_FreeCount) {
+                    allocRate = double(stats.m_AllocCount - prev[id].m_AllocCount) / seconds;
+                    freeRate = double(stats.m_FreeCount - prev[id].m_FreeCount) / seconds;
+                }
+
+                prev[id] = {true, stats.m_AllocCount, stats.m_FreeCount, allocRate, freeRate};
+            } else if (!prev[id].m_Valid) {
+                // first seen between two passes: no rate until the next one.
+                prev[id] = {true, stats.m_AllocCount, stats.m_FreeCount, 0.0, 0.0};
+            }
+
+            std::printf("%5" PRIu32 " %-24.24s %14" PRId64 " %10" PRId64 " %12.0f %12.0f\n",
+                id, stats.m_Name, stats.m_Bytes, stats.m_Count, prev[id].m_AllocRate, prev[id].m_FreeRate);
+        }
+
+        std::fflush(stdout);
+        prevUpdate = update;
+    }
+
+    ::munmap((void*)header, mappedSize);
+    return 0;
+}